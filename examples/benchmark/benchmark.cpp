@@ -0,0 +1,166 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+// Runs the engine on fixed problems and prints the wall time and the
+// hardware counters (IPC, cache and branch misses) of every phase and
+// worker thread, summed over all generations.
+
+#include "openGA.hpp"
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct MySolution {
+    std::vector<double> x;
+};
+
+struct MyMiddleCost {
+    std::vector<double> f;
+};
+
+using GaType = EA::Genetic<MySolution, MyMiddleCost>;
+using GenerationType = EA::GenerationType<MySolution, MyMiddleCost>;
+
+const unsigned int N_variables = 30;
+const unsigned int N_objectives = 3; // DTLZ2
+
+void init_genes(MySolution& p, const std::function<double(void)>& rnd01) {
+    for (unsigned int i = 0; i < N_variables; i++) p.x.push_back(rnd01());
+}
+
+bool eval_rastrigin(const MySolution& p, MyMiddleCost& c) {
+    constexpr double pi = 3.141592653589793238;
+    double cost = 10 * double(p.x.size());
+    for (double xi : p.x) {
+        const double y = 10.24 * xi - 5.12;
+        cost += y * y - 10.0 * cos(2.0 * pi * y);
+    }
+    c.f = {cost};
+    return true;
+}
+
+bool eval_dtlz2(const MySolution& p, MyMiddleCost& c) {
+    constexpr double pi = 3.141592653589793238;
+    double g = 0.0;
+    for (unsigned int i = N_objectives - 1; i < p.x.size(); i++) g += (p.x[i] - 0.5) * (p.x[i] - 0.5);
+    c.f.assign(N_objectives, 1.0 + g);
+    for (unsigned int m = 0; m < N_objectives; m++) {
+        for (unsigned int i = 0; i + m + 1 < N_objectives; i++) c.f[m] *= cos(p.x[i] * pi / 2);
+        if (m > 0) c.f[m] *= sin(p.x[N_objectives - 1 - m] * pi / 2);
+    }
+    return true;
+}
+
+MySolution mutate(const MySolution& X_base, const std::function<double(void)>& rnd01, double shrink_scale) {
+    MySolution X_new = X_base;
+    for (double& xi : X_new.x) {
+        xi += 0.2 * shrink_scale * (rnd01() - rnd01());
+        xi = std::min(1.0, std::max(0.0, xi));
+    }
+    return X_new;
+}
+
+MySolution crossover(const MySolution& X1, const MySolution& X2, const std::function<double(void)>& rnd01) {
+    MySolution X_new = X1;
+    for (unsigned int i = 0; i < X_new.x.size(); i++) {
+        const double r = rnd01();
+        X_new.x[i] = r * X1.x[i] + (1.0 - r) * X2.x[i];
+    }
+    return X_new;
+}
+
+double calculate_SO_total_fitness(const GaType::ThisChromosomeType& X) { return X.middle_costs.f[0]; }
+
+std::vector<double> calculate_MO_objectives(const GaType::ThisChromosomeType& X) { return X.middle_costs.f; }
+
+struct PerfTotals {
+    EA::PerfMetrics sum;
+
+    void add(const EA::PerfMetrics& perf) {
+        for (unsigned int p = 0; p < EA::N_engine_phases; p++) sum.phases[p].add(perf.phases[p]);
+        if (sum.workers.size() < perf.workers.size()) sum.workers.resize(perf.workers.size());
+        for (unsigned int w = 0; w < perf.workers.size(); w++) sum.workers[w].add(perf.workers[w]);
+    }
+};
+
+void print_row(const std::string& name, const EA::PerfCounterValues& v) {
+    std::printf(
+        "  %-12s %10.4f %14llu %14llu %6.2f %10.3f %10.3f\n",
+        name.c_str(),
+        v.seconds,
+        (unsigned long long)v.cycles,
+        (unsigned long long)v.instructions,
+        v.ipc(),
+        v.cache_mpki(),
+        v.branch_mpki());
+}
+
+void print_totals(const std::string& title, const PerfTotals& totals) {
+    const char* phase_names[EA::N_engine_phases] = {"offspring", "objectives", "ranking", "selection"};
+    std::printf("%s\n", title.c_str());
+    std::printf(
+        "  %-12s %10s %14s %14s %6s %10s %10s\n",
+        "phase",
+        "seconds",
+        "cycles",
+        "instructions",
+        "IPC",
+        "cache-MPKI",
+        "branch-MPKI");
+    for (unsigned int p = 0; p < EA::N_engine_phases; p++) print_row(phase_names[p], totals.sum.phases[p]);
+    for (unsigned int w = 0; w < totals.sum.workers.size(); w++)
+        print_row("worker " + std::to_string(w), totals.sum.workers[w]);
+    std::printf("\n");
+}
+
+void setup(GaType& ga_obj) {
+    ga_obj.dynamic_threading = false;
+    ga_obj.multi_threading = true;
+    ga_obj.idle_delay_us = 1;
+    ga_obj.verbose = false;
+    ga_obj.collect_perf_counters = true;
+    ga_obj.population = 200;
+    ga_obj.generation_max = 100;
+    ga_obj.best_stall_max = 1000;
+    ga_obj.average_stall_max = 1000;
+    ga_obj.init_genes = init_genes;
+    ga_obj.mutate = mutate;
+    ga_obj.crossover = crossover;
+    ga_obj.crossover_fraction = 0.7;
+    ga_obj.mutation_rate = 0.2;
+}
+
+int main() {
+    if (!EA::thread_perf_counters().available())
+        std::cout << "Hardware counters are not available (perf_event_open failed), only the time is measured."
+                  << std::endl
+                  << std::endl;
+
+    PerfTotals so_totals;
+    GaType so_obj;
+    setup(so_obj);
+    so_obj.problem_mode = EA::GaMode::SOGA;
+    so_obj.elite_count = 10;
+    so_obj.eval_solution = eval_rastrigin;
+    so_obj.calculate_SO_total_fitness = calculate_SO_total_fitness;
+    so_obj.SO_report_generation = [&so_totals](int, const GenerationType& g, const MySolution&) {
+        so_totals.add(g.perf);
+    };
+    so_obj.solve();
+    print_totals("SOGA, rastrigin, " + std::to_string(N_variables) + " variables", so_totals);
+
+    PerfTotals mo_totals;
+    GaType mo_obj;
+    setup(mo_obj);
+    mo_obj.problem_mode = EA::GaMode::NSGA_III;
+    mo_obj.eval_solution = eval_dtlz2;
+    mo_obj.calculate_MO_objectives = calculate_MO_objectives;
+    mo_obj.MO_report_generation = [&mo_totals](int, const GenerationType& g, const std::vector<unsigned int>&) {
+        mo_totals.add(g.perf);
+    };
+    mo_obj.solve();
+    print_totals("NSGA-III, DTLZ2, " + std::to_string(N_objectives) + " objectives", mo_totals);
+    return 0;
+}
@@ -0,0 +1,118 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+// Latency of complete solves of a tiny problem (population 30, two genes,
+// evaluations of about a microsecond) with SmallGenetic and, for
+// comparison, with the generic engine on a single thread.
+
+#include "SmallGenetic.hpp"
+#include "openGA.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using Genes = std::array<double, 2>;
+
+struct MyMiddleCost {
+    double cost;
+};
+
+using SmallGaType = EA::SmallGenetic<Genes, MyMiddleCost, 32>;
+using GaType = EA::Genetic<Genes, MyMiddleCost>;
+
+const unsigned int N_population = 30;
+const int N_generations = 50;
+const double budget_us = 2000.0;
+
+bool eval_solution(const Genes& p, MyMiddleCost& c) {
+    // sixteen sine and cosine pairs, about a microsecond
+    double x = p[0], y = p[1], s = 0.0;
+    for (int i = 1; i <= 16; i++) s += std::sin(x * i) * std::cos(y * i) / i;
+    c.cost = (x - 1.0) * (x - 1.0) + (y + 0.5) * (y + 0.5) + 0.01 * s;
+    return true;
+}
+
+void init_genes(Genes& p, EA::BulkRandom& rng) { rng.uniform(p.data(), p.size(), -2.0, 2.0); }
+
+Genes mutate(const Genes& X, EA::BulkRandom& rng, double shrink_scale) {
+    Genes Y = X;
+    for (double& v : Y) v += 0.5 * shrink_scale * (rng() - rng());
+    return Y;
+}
+
+Genes crossover(const Genes& X1, const Genes& X2, EA::BulkRandom& rng) {
+    Genes Y;
+    for (unsigned int i = 0; i < Y.size(); i++) {
+        const double r = rng();
+        Y[i] = r * X1[i] + (1.0 - r) * X2[i];
+    }
+    return Y;
+}
+
+double calculate_SO_total_fitness(const GaType::ThisChromosomeType& X) { return X.middle_costs.cost; }
+
+template<typename Solve>
+void measure(const char* name, unsigned int N_runs, Solve solve) {
+    std::vector<double> latency_us(N_runs);
+    for (unsigned int i = 0; i < N_runs; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        solve();
+        latency_us[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::sort(latency_us.begin(), latency_us.end());
+    auto percentile = [&latency_us](double p) {
+        return latency_us[std::min(latency_us.size() - 1, (std::size_t)(p * double(latency_us.size())))];
+    };
+    const std::size_t over_budget =
+        latency_us.end() - std::upper_bound(latency_us.begin(), latency_us.end(), budget_us);
+    std::printf(
+        "%-28s %6u %8.1f %8.1f %8.1f %8.1f %8.1f %8zu\n",
+        name,
+        N_runs,
+        percentile(0.5),
+        percentile(0.9),
+        percentile(0.99),
+        percentile(0.999),
+        latency_us.back(),
+        over_budget);
+}
+
+int main() {
+    std::printf("%d generations of %u members, latency of a solve in microseconds\n", N_generations, N_population);
+    std::printf(
+        "%-28s %6s %8s %8s %8s %8s %8s %8s\n", "engine", "runs", "p50", "p90", "p99", "p99.9", "max", ">2ms");
+
+    SmallGaType small_ga;
+    small_ga.population = N_population;
+    small_ga.generation_max = N_generations;
+    small_ga.best_stall_max = N_generations;
+    small_ga.init_genes = init_genes;
+    small_ga.eval_solution = eval_solution;
+    small_ga.mutate = mutate;
+    small_ga.crossover = crossover;
+    small_ga.calculate_SO_total_fitness = calculate_SO_total_fitness;
+    measure("SmallGenetic", 10000, [&small_ga]() { small_ga.solve(); });
+
+    measure("Genetic, single thread", 1000, []() {
+        GaType ga_obj;
+        ga_obj.problem_mode = EA::GaMode::SOGA;
+        ga_obj.multi_threading = false;
+        ga_obj.verbose = false;
+        ga_obj.population = N_population;
+        ga_obj.generation_max = N_generations;
+        ga_obj.best_stall_max = N_generations;
+        ga_obj.average_stall_max = N_generations;
+        ga_obj.elite_count = 3;
+        ga_obj.init_genes_bulk = init_genes;
+        ga_obj.eval_solution = eval_solution;
+        ga_obj.mutate_bulk = mutate;
+        ga_obj.crossover_bulk = crossover;
+        ga_obj.calculate_SO_total_fitness = calculate_SO_total_fitness;
+        ga_obj.SO_report_generation = [](int, const EA::GenerationType<Genes, MyMiddleCost>&, const Genes&) {};
+        ga_obj.solve();
+    });
+    return 0;
+}
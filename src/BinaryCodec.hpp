@@ -0,0 +1,220 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "Definitions.hpp"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Byte level helpers shared by the binary file
+ * formats of openGA. Buffers are plain std::string
+ * objects. Integers are stored as little-endian
+ * varints and doubles are XOR-delta encoded so that
+ * slowly changing columns shrink to a few bytes.
+ ****************************************************/
+
+inline void put_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(char(value));
+}
+
+inline uint64_t get_varint(const char*& p, const char* end) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) throw std::runtime_error("Truncated varint in binary stream");
+        uint64_t byte = (unsigned char)(*p++);
+        value |= (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return value;
+    }
+    throw std::runtime_error("Malformed varint in binary stream");
+}
+
+inline uint64_t zigzag_encode(int64_t value) { return (uint64_t(value) << 1) ^ uint64_t(value >> 63); }
+
+inline int64_t zigzag_decode(uint64_t value) { return int64_t(value >> 1) ^ -int64_t(value & 1); }
+
+inline void put_fixed64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out.push_back(char((value >> (8 * i)) & 0xff));
+}
+
+inline uint64_t get_fixed64(const char* p) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value |= uint64_t((unsigned char)p[i]) << (8 * i);
+    return value;
+}
+
+inline uint64_t double_to_bits(double x) {
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+inline double bits_to_double(uint64_t bits) {
+    double x;
+    std::memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+inline void put_bytes(std::string& out, const std::string& bytes) {
+    put_varint(out, bytes.size());
+    out.append(bytes);
+}
+
+inline std::string get_bytes(const char*& p, const char* end) {
+    uint64_t n = get_varint(p, end);
+    if (uint64_t(end - p) < n) throw std::runtime_error("Truncated byte block in binary stream");
+    std::string bytes(p, std::size_t(n));
+    p += n;
+    return bytes;
+}
+
+inline void encode_doubles(const std::vector<double>& values, std::string& out) {
+    put_varint(out, values.size());
+    uint64_t previous = 0;
+    for (double x : values) {
+        uint64_t bits = double_to_bits(x);
+        // byte-reversed so that the shared sign/exponent bits turn into leading zeros of the varint
+        uint64_t delta = bits ^ previous;
+        uint64_t reversed = 0;
+        for (int i = 0; i < 8; i++) reversed |= ((delta >> (8 * i)) & 0xff) << (8 * (7 - i));
+        put_varint(out, reversed);
+        previous = bits;
+    }
+}
+
+inline void decode_doubles(const char*& p, const char* end, std::vector<double>& values) {
+    uint64_t n = get_varint(p, end);
+    values.clear();
+    values.reserve(std::size_t(n));
+    uint64_t previous = 0;
+    for (uint64_t k = 0; k < n; k++) {
+        uint64_t reversed = get_varint(p, end);
+        uint64_t delta = 0;
+        for (int i = 0; i < 8; i++) delta |= ((reversed >> (8 * i)) & 0xff) << (8 * (7 - i));
+        previous ^= delta;
+        values.push_back(bits_to_double(previous));
+    }
+}
+
+inline void encode_ints(const std::vector<int>& values, std::string& out) {
+    put_varint(out, values.size());
+    int64_t previous = 0;
+    for (int x : values) {
+        put_varint(out, zigzag_encode(int64_t(x) - previous));
+        previous = x;
+    }
+}
+
+inline void decode_ints(const char*& p, const char* end, std::vector<int>& values) {
+    uint64_t n = get_varint(p, end);
+    values.clear();
+    values.reserve(std::size_t(n));
+    int64_t previous = 0;
+    for (uint64_t k = 0; k < n; k++) {
+        previous += zigzag_decode(get_varint(p, end));
+        values.push_back(int(previous));
+    }
+}
+
+/****************************************************
+ * 64-bit hashing helpers for building gene keys, e.g.
+ *   uint64_t h = hash_bytes(&x, sizeof(x));
+ *   h = hash_combine(h, hash_bytes(v.data(), v.size() * sizeof(double)));
+ ****************************************************/
+inline uint64_t hash_mix(uint64_t x) {
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+inline uint64_t hash_bytes(const void* data, std::size_t n, uint64_t seed = 0xcbf29ce484222325ULL) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    uint64_t h = seed;
+    for (std::size_t i = 0; i < n; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL; // FNV-1a
+    }
+    return hash_mix(h);
+}
+
+inline uint64_t hash_combine(uint64_t seed, uint64_t value) {
+    return hash_mix(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+/****************************************************
+ * A small LZ77 block compressor. The output starts
+ * with the uncompressed size followed by a sequence of
+ * (literal length, literals, match length, offset)
+ * tokens. It trades ratio for speed and needs no
+ * third-party library.
+ ****************************************************/
+inline void lz_compress(const std::string& in, std::string& out) {
+    const std::size_t min_match = 4;
+    const unsigned int hash_bits = 14;
+    const std::size_t N = in.size();
+    const char* src = in.data();
+    out.clear();
+    put_varint(out, N);
+
+    std::vector<std::size_t> table(std::size_t(1) << hash_bits, std::size_t(-1));
+    std::size_t literal_start = 0;
+    std::size_t i = 0;
+    while (i + min_match <= N) {
+        uint32_t word;
+        std::memcpy(&word, src + i, sizeof(word));
+        uint32_t h = (word * 2654435761u) >> (32 - hash_bits);
+        std::size_t candidate = table[h];
+        table[h] = i;
+        if (candidate != std::size_t(-1) && std::memcmp(src + candidate, src + i, min_match) == 0) {
+            std::size_t len = min_match;
+            while (i + len < N && src[candidate + len] == src[i + len]) len++;
+            put_varint(out, i - literal_start);
+            out.append(src + literal_start, i - literal_start);
+            put_varint(out, len);
+            put_varint(out, i - candidate);
+            i += len;
+            literal_start = i;
+        }
+        else
+            i++;
+    }
+    if (literal_start < N || N == 0) {
+        put_varint(out, N - literal_start);
+        out.append(src + literal_start, N - literal_start);
+        put_varint(out, 0);
+    }
+}
+
+inline void lz_decompress(const char* p, const char* end, std::string& out) {
+    uint64_t N = get_varint(p, end);
+    out.clear();
+    out.reserve(std::size_t(N));
+    while (p < end) {
+        uint64_t n_literal = get_varint(p, end);
+        if (uint64_t(end - p) < n_literal) throw std::runtime_error("Corrupted compressed block (literals)");
+        out.append(p, std::size_t(n_literal));
+        p += n_literal;
+        uint64_t len = get_varint(p, end);
+        if (len == 0) continue;
+        uint64_t offset = get_varint(p, end);
+        if (offset == 0 || offset > out.size()) throw std::runtime_error("Corrupted compressed block (offset)");
+        std::size_t from = out.size() - std::size_t(offset);
+        for (uint64_t k = 0; k < len; k++) out.push_back(out[from + std::size_t(k)]); // may overlap
+    }
+    if (out.size() != N) throw std::runtime_error("Corrupted compressed block (size)");
+}
+
+NS_EA_END
@@ -0,0 +1,193 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "BinaryCodec.hpp"
+#include "Definitions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Random numbers in bulk for the genetic operators.
+ * The generator runs several xoshiro256+ streams side
+ * by side with their states laid out lane by lane, so
+ * the compiler turns the inner loops into SIMD code.
+ * Arrays are filled in one call instead of one
+ * std::function call per random number.
+ * An instance belongs to a single thread.
+ ****************************************************/
+class BulkRandom {
+    static const unsigned int N_lanes = 8;
+    static const unsigned int N_block = 64; // random numbers produced at once, multiple of N_lanes
+
+    uint64_t s0[N_lanes], s1[N_lanes], s2[N_lanes], s3[N_lanes];
+    uint64_t block[N_block];
+    unsigned int block_pos;
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    // Advances all lanes by one step and writes N_lanes numbers.
+    void step(uint64_t* out) {
+        for (unsigned int l = 0; l < N_lanes; l++) {
+            out[l] = s0[l] + s3[l];
+            const uint64_t t = s1[l] << 17;
+            s2[l] ^= s0[l];
+            s3[l] ^= s1[l];
+            s1[l] ^= s2[l];
+            s0[l] ^= s3[l];
+            s2[l] ^= t;
+            s3[l] = rotl(s3[l], 45);
+        }
+    }
+
+    void refill() {
+        for (unsigned int i = 0; i < N_block; i += N_lanes) step(block + i);
+        block_pos = 0;
+    }
+
+    // [0,1) from the upper 52 bits, without an integer to double conversion
+    static double to_unit(uint64_t x) {
+        uint64_t bits = (x >> 12) | 0x3FF0000000000000ull;
+        double d;
+        std::memcpy(&d, &bits, sizeof d);
+        return d - 1.0;
+    }
+
+public:
+    explicit BulkRandom(uint64_t seed) { this->seed(seed); }
+
+    void seed(uint64_t seed) {
+        uint64_t x = seed;
+        for (unsigned int l = 0; l < N_lanes; l++) {
+            s0[l] = hash_mix(x += 0x9e3779b97f4a7c15ull);
+            s1[l] = hash_mix(x += 0x9e3779b97f4a7c15ull);
+            s2[l] = hash_mix(x += 0x9e3779b97f4a7c15ull);
+            s3[l] = hash_mix(x += 0x9e3779b97f4a7c15ull);
+        }
+        block_pos = N_block;
+    }
+
+    uint64_t next() {
+        if (block_pos == N_block) refill();
+        return block[block_pos++];
+    }
+
+    // scalar uniform in [0,1), can be wrapped as rnd01
+    double operator()() { return to_unit(next()); }
+
+    void raw(uint64_t* out, std::size_t n) {
+        std::size_t i = 0;
+        for (; block_pos < N_block && i < n; i++) out[i] = block[block_pos++];
+        for (; i + N_lanes <= n; i += N_lanes) step(out + i);
+        for (; i < n; i++) out[i] = next();
+    }
+
+    // uniform in [lo,hi)
+    void uniform(double* out, std::size_t n, double lo = 0.0, double hi = 1.0) {
+        const double scale = hi - lo;
+        for (std::size_t i = 0; i < n; i += N_block) {
+            const std::size_t m = std::min<std::size_t>(N_block, n - i);
+            uint64_t x[N_block];
+            raw(x, m);
+            for (std::size_t j = 0; j < m; j++) out[i + j] = lo + scale * to_unit(x[j]);
+        }
+    }
+
+    // normal distribution (Box-Muller)
+    void normal(double* out, std::size_t n, double mean = 0.0, double stddev = 1.0) {
+        const double two_pi = 6.283185307179586;
+        for (std::size_t i = 0; i < n; i += N_block) {
+            const std::size_t m = std::min<std::size_t>(N_block, n - i);
+            const std::size_t pairs = (m + 1) / 2;
+            double u[N_block];
+            uniform(u, 2 * pairs);
+            double z[N_block];
+            for (std::size_t j = 0; j < pairs; j++) {
+                const double r = std::sqrt(-2.0 * std::log(1.0 - u[2 * j]));
+                z[2 * j] = r * std::cos(two_pi * u[2 * j + 1]);
+                z[2 * j + 1] = r * std::sin(two_pi * u[2 * j + 1]);
+            }
+            for (std::size_t j = 0; j < m; j++) out[i + j] = mean + stddev * z[j];
+        }
+    }
+
+    /****************************************************
+     * Integers in [lo,hi] by multiply and shift. The bias
+     * is below (hi-lo+1)/2^32, negligible for the ranges
+     * of gene indices and alleles.
+     ****************************************************/
+    void integers(int* out, std::size_t n, int lo, int hi) {
+        const uint64_t range = uint64_t(int64_t(hi) - int64_t(lo) + 1);
+        for (std::size_t i = 0; i < n; i += N_block) {
+            const std::size_t m = std::min<std::size_t>(N_block, n - i);
+            uint64_t x[N_block];
+            raw(x, m);
+            for (std::size_t j = 0; j < m; j++) out[i + j] = int(int64_t(lo) + int64_t(((x[j] >> 32) * range) >> 32));
+        }
+    }
+
+    // out[i] is 1 with probability p
+    void bernoulli(uint8_t* out, std::size_t n, double p) {
+        if (p <= 0.0) {
+            std::memset(out, 0, n);
+            return;
+        }
+        if (p >= 1.0) {
+            std::memset(out, 1, n);
+            return;
+        }
+        const uint64_t threshold = uint64_t(p * 9007199254740992.0); // p * 2^53
+        for (std::size_t i = 0; i < n; i += N_block) {
+            const std::size_t m = std::min<std::size_t>(N_block, n - i);
+            uint64_t x[N_block];
+            raw(x, m);
+            for (std::size_t j = 0; j < m; j++) out[i + j] = uint8_t((x[j] >> 11) < threshold);
+        }
+    }
+
+    // whole vector versions
+    void uniform(std::vector<double>& out, double lo = 0.0, double hi = 1.0) {
+        uniform(out.data(), out.size(), lo, hi);
+    }
+    void normal(std::vector<double>& out, double mean = 0.0, double stddev = 1.0) {
+        normal(out.data(), out.size(), mean, stddev);
+    }
+    void integers(std::vector<int>& out, int lo, int hi) { integers(out.data(), out.size(), lo, hi); }
+    void bernoulli(std::vector<uint8_t>& out, double p) { bernoulli(out.data(), out.size(), p); }
+
+    /****************************************************
+     * Number of failures before the next success of
+     * Bernoulli trials with probability p. Mutating each
+     * gene with a small probability p then costs one draw
+     * per mutated gene instead of one draw per gene.
+     ****************************************************/
+    std::size_t geometric_skip(double p) {
+        if (p >= 1.0) return 0;
+        if (p <= 0.0) return std::numeric_limits<std::size_t>::max();
+        const double u = 1.0 - (*this)(); // (0,1]
+        const double skip = std::floor(std::log(u) / std::log1p(-p));
+        if (skip >= double(std::numeric_limits<std::size_t>::max())) return std::numeric_limits<std::size_t>::max();
+        return std::size_t(skip);
+    }
+
+    // Calls f(i) for every i in [0,n) picked with probability p.
+    template<typename F>
+    void for_each_bernoulli(std::size_t n, double p, F f) {
+        std::size_t i = geometric_skip(p);
+        while (i < n) {
+            f(i);
+            const std::size_t skip = geometric_skip(p);
+            if (skip >= n - i) break;
+            i += skip + 1;
+        }
+    }
+};
+
+NS_EA_END
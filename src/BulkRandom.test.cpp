@@ -0,0 +1,107 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <BulkRandom.hpp>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+void moments(const std::vector<double>& x, double& mean, double& variance) {
+    mean = 0.0;
+    for (double v : x) mean += v;
+    mean /= double(x.size());
+    variance = 0.0;
+    for (double v : x) variance += (v - mean) * (v - mean);
+    variance /= double(x.size() - 1);
+}
+
+} // namespace
+
+TEST(BulkRandomTest, sameSeedSameStream) {
+    EA::BulkRandom a(5), b(5), c(6);
+    std::vector<double> x(1000), y(1000), z(1000);
+    a.uniform(x);
+    // scalar and bulk draws come from the same stream
+    for (double& v : y) v = b();
+    c.uniform(z);
+    EXPECT_EQ(x, y);
+    EXPECT_NE(x, z);
+}
+
+TEST(BulkRandomTest, uniform) {
+    EA::BulkRandom rnd(1);
+    std::vector<double> x(100003);
+    rnd.uniform(x, -2.0, 4.0);
+    for (double v : x) {
+        ASSERT_GE(v, -2.0);
+        ASSERT_LT(v, 4.0);
+    }
+    double mean, variance;
+    moments(x, mean, variance);
+    EXPECT_NEAR(mean, 1.0, 0.03);
+    EXPECT_NEAR(variance, 36.0 / 12.0, 0.05);
+}
+
+TEST(BulkRandomTest, normal) {
+    EA::BulkRandom rnd(2);
+    std::vector<double> x(100001);
+    rnd.normal(x, 3.0, 2.0);
+    double mean, variance;
+    moments(x, mean, variance);
+    EXPECT_NEAR(mean, 3.0, 0.03);
+    EXPECT_NEAR(variance, 4.0, 0.08);
+}
+
+TEST(BulkRandomTest, integers) {
+    EA::BulkRandom rnd(3);
+    std::vector<int> x(70000);
+    rnd.integers(x, -3, 3);
+    std::vector<int> count(7, 0);
+    for (int v : x) {
+        ASSERT_GE(v, -3);
+        ASSERT_LE(v, 3);
+        count[v + 3]++;
+    }
+    for (int c : count) EXPECT_NEAR(c, 10000, 400);
+}
+
+TEST(BulkRandomTest, bernoulli) {
+    EA::BulkRandom rnd(4);
+    std::vector<uint8_t> x(100000);
+    rnd.bernoulli(x, 0.2);
+    int ones = 0;
+    for (uint8_t v : x) ones += v;
+    EXPECT_NEAR(ones / 100000.0, 0.2, 0.005);
+    rnd.bernoulli(x, 0.0);
+    for (uint8_t v : x) ASSERT_EQ(v, 0);
+    rnd.bernoulli(x, 1.0);
+    for (uint8_t v : x) ASSERT_EQ(v, 1);
+}
+
+TEST(BulkRandomTest, geometricSkipSampling) {
+    EA::BulkRandom rnd(5);
+    const std::size_t n = 1000;
+    const double p = 0.01;
+    std::vector<int> hits(n, 0);
+    long total = 0;
+    const int repeats = 2000;
+    for (int r = 0; r < repeats; r++) {
+        std::size_t last = 0;
+        bool first = true;
+        rnd.for_each_bernoulli(n, p, [&](std::size_t i) {
+            ASSERT_LT(i, n);
+            if (!first) {
+                ASSERT_GT(i, last);
+            }
+            first = false;
+            last = i;
+            hits[i]++;
+            total++;
+        });
+    }
+    // every index is picked with probability p
+    EXPECT_NEAR(double(total) / repeats, n * p, 0.3);
+    EXPECT_NEAR(double(hits[0]) / repeats, p, 0.008);
+    EXPECT_NEAR(double(hits[n - 1]) / repeats, p, 0.008);
+    EXPECT_EQ(rnd.geometric_skip(1.0), 0u);
+}
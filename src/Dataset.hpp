@@ -0,0 +1,285 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "BinaryCodec.hpp"
+#include "Definitions.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Dataset file layout:
+ *
+ *   "OGAD" | column blocks ... | index | index size | "OGAD"
+ *
+ * A column block is the raw array of the column values,
+ * aligned to dataset_block_alignment bytes so that it
+ * can be used in place from the mapped file. The index
+ * holds the name, the element size, the number of
+ * values and the offset of every column.
+ ****************************************************/
+const char dataset_magic[] = "OGAD";
+const std::size_t dataset_block_alignment = 64;
+
+/****************************************************
+ * Builds a dataset file from in-memory columns. Only
+ * a pointer to the values of each column is kept, so
+ * they must stay alive until write(), which streams
+ * every block straight to the file.
+ ****************************************************/
+class DatasetWriter {
+    struct Column {
+        std::string name;
+        std::size_t element_size;
+        std::size_t count;
+        const char* bytes;
+    };
+
+    std::vector<Column> columns;
+
+public:
+    template<typename T>
+    DatasetWriter& add_column(const std::string& name, const T* values, std::size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "Dataset columns hold trivially copyable values.");
+        for (const Column& c : columns)
+            if (c.name == name) throw std::runtime_error("Dataset column " + name + " is already defined.");
+        Column c;
+        c.name = name;
+        c.element_size = sizeof(T);
+        c.count = count;
+        c.bytes = reinterpret_cast<const char*>(values);
+        columns.push_back(std::move(c));
+        return *this;
+    }
+
+    template<typename T>
+    DatasetWriter& add_column(const std::string& name, const std::vector<T>& values) {
+        return add_column(name, values.data(), values.size());
+    }
+
+    // the values of a temporary would be gone before write()
+    template<typename T>
+    DatasetWriter& add_column(const std::string& name, const std::vector<T>&& values) = delete;
+
+    void write(const std::string& path) const {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) throw std::runtime_error("Cannot create file " + path);
+        const char padding[dataset_block_alignment] = {};
+        std::string index;
+        std::size_t offset = 4;
+        put_varint(index, columns.size());
+        file.write(dataset_magic, 4);
+        for (const Column& c : columns) {
+            const std::size_t aligned =
+                (offset + dataset_block_alignment - 1) / dataset_block_alignment * dataset_block_alignment;
+            file.write(padding, std::streamsize(aligned - offset));
+            put_bytes(index, c.name);
+            put_varint(index, c.element_size);
+            put_varint(index, c.count);
+            put_varint(index, aligned);
+            file.write(c.bytes, std::streamsize(c.element_size * c.count));
+            offset = aligned + c.element_size * c.count;
+        }
+        put_fixed64(index, index.size());
+        index.append(dataset_magic, 4);
+        file.write(index.data(), std::streamsize(index.size()));
+        if (!file) throw std::runtime_error("Cannot write file " + path);
+    }
+};
+
+// Zero-copy view of a dataset column.
+template<typename T>
+struct DatasetColumn {
+    const T* values = nullptr;
+    std::size_t count = 0;
+
+    std::size_t size() const { return count; }
+    const T* data() const { return values; }
+    const T& operator[](std::size_t i) const { return values[i]; }
+    const T* begin() const { return values; }
+    const T* end() const { return values + count; }
+};
+
+/****************************************************
+ * Read-only dataset mapped from a file. The columns
+ * are used in place: all threads share the pages of
+ * the mapping, evaluators forked after open() inherit
+ * it, and separate processes mapping the same file
+ * share the page cache, so the data is in memory once
+ * per host. Nothing is read before a page is touched,
+ * unless prefetch() is called.
+ ****************************************************/
+class Dataset {
+    struct Column {
+        std::size_t element_size;
+        std::size_t count;
+        std::size_t offset;
+    };
+
+    MappedFile file;
+    std::map<std::string, Column> columns;
+
+public:
+    Dataset() {}
+
+    explicit Dataset(const std::string& path) { open(path); }
+
+    Dataset(const Dataset&) = delete;
+    Dataset& operator=(const Dataset&) = delete;
+
+    void open(const std::string& path) {
+        columns.clear();
+        file.open(path);
+        const char* begin = file.data();
+        const std::size_t n = file.size();
+        if (n < 16 || std::memcmp(begin, dataset_magic, 4) != 0 || std::memcmp(begin + n - 4, dataset_magic, 4) != 0) {
+            file.close();
+            throw std::runtime_error("Not a dataset file: " + path);
+        }
+        const uint64_t index_size = get_fixed64(begin + n - 12);
+        if (index_size > n - 16) {
+            file.close();
+            throw std::runtime_error("Corrupt dataset index: " + path);
+        }
+        const char* p = begin + n - 12 - index_size;
+        const char* end = begin + n - 12;
+        for (uint64_t k = get_varint(p, end); k > 0; k--) {
+            const std::string name = get_bytes(p, end);
+            Column c;
+            c.element_size = std::size_t(get_varint(p, end));
+            c.count = std::size_t(get_varint(p, end));
+            c.offset = std::size_t(get_varint(p, end));
+            if (c.offset + c.element_size * c.count > n - 12 - index_size) {
+                file.close();
+                throw std::runtime_error("Corrupt dataset column " + name + ": " + path);
+            }
+            columns[name] = c;
+        }
+    }
+
+    bool is_open() const { return file.is_open(); }
+    std::size_t size_bytes() const { return file.size(); }
+
+    bool has_column(const std::string& name) const { return columns.count(name) > 0; }
+
+    std::vector<std::string> column_names() const {
+        std::vector<std::string> names;
+        for (const auto& c : columns) names.push_back(c.first);
+        return names;
+    }
+
+    template<typename T>
+    DatasetColumn<T> column(const std::string& name) const {
+        auto it = columns.find(name);
+        if (it == columns.end()) throw std::runtime_error("Dataset column " + name + " does not exist.");
+        if (it->second.element_size != sizeof(T))
+            throw std::runtime_error("Dataset column " + name + " has another element size.");
+        DatasetColumn<T> view;
+        view.values = reinterpret_cast<const T*>(file.data() + it->second.offset);
+        view.count = it->second.count;
+        return view;
+    }
+
+    /****************************************************
+     * Loads the pages of the given columns (all columns
+     * if none are given) before the first evaluation.
+     * The kernel is asked to read them ahead, then
+     * N_threads threads touch one byte per page so that
+     * the first generation does not run into page faults.
+     ****************************************************/
+    void prefetch(int N_threads = 1, const std::vector<std::string>& names = {}) const {
+        std::vector<std::pair<std::size_t, std::size_t>> ranges; // offset, length
+        for (const auto& c : columns)
+            if (names.empty() || std::find(names.begin(), names.end(), c.first) != names.end())
+                ranges.push_back(std::make_pair(c.second.offset, c.second.element_size * c.second.count));
+        for (const auto& r : ranges) file.will_need(r.first, r.second);
+
+        const unsigned int N_workers = (unsigned int)std::max(1, N_threads);
+        std::vector<std::thread> workers;
+        for (unsigned int w = 1; w < N_workers; w++)
+            workers.push_back(std::thread([this, &ranges, w, N_workers]() { touch(ranges, w, N_workers); }));
+        touch(ranges, 0, N_workers);
+        for (std::thread& th : workers) th.join();
+    }
+
+private:
+    // reads one byte of every page w, w+N_workers, ... of the ranges
+    void touch(const std::vector<std::pair<std::size_t, std::size_t>>& ranges, unsigned int w,
+        unsigned int N_workers) const {
+        const std::size_t page = 4096;
+        volatile char sink = 0;
+        for (const auto& r : ranges)
+            for (std::size_t k = r.first / page + w; k * page < r.first + r.second; k += N_workers)
+                sink = char(sink ^ file.data()[std::max(k * page, r.first)]);
+        (void)sink;
+    }
+};
+
+/****************************************************
+ * Opens a dataset once per process: instances of the
+ * GA running side by side get the same mapping for the
+ * same path, as long as one of them holds it.
+ ****************************************************/
+inline std::shared_ptr<const Dataset> shared_dataset(const std::string& path) {
+    static std::mutex mtx;
+    static std::map<std::string, std::weak_ptr<const Dataset>> open_datasets;
+    std::lock_guard<std::mutex> lock(mtx);
+    std::shared_ptr<const Dataset> dataset = open_datasets[path].lock();
+    if (!dataset) {
+        dataset = std::make_shared<Dataset>(path);
+        open_datasets[path] = dataset;
+    }
+    return dataset;
+}
+
+/****************************************************
+ * Handle passed to eval_solution_context. It gives the
+ * evaluations named read-only datasets instead of
+ * file-level globals. Copies share the datasets.
+ ****************************************************/
+class EvaluationContext {
+    std::map<std::string, std::shared_ptr<const Dataset>> datasets;
+
+public:
+    EvaluationContext& add_dataset(const std::string& name, std::shared_ptr<const Dataset> dataset) {
+        if (!dataset) throw std::runtime_error("Dataset " + name + " is null.");
+        datasets[name] = std::move(dataset);
+        return *this;
+    }
+
+    // opens the file via shared_dataset
+    EvaluationContext& add_dataset(const std::string& name, const std::string& path) {
+        return add_dataset(name, shared_dataset(path));
+    }
+
+    const Dataset& dataset(const std::string& name) const {
+        auto it = datasets.find(name);
+        if (it == datasets.end()) throw std::runtime_error("Dataset " + name + " is not in the evaluation context.");
+        return *it->second;
+    }
+
+    template<typename T>
+    DatasetColumn<T> column(const std::string& dataset_name, const std::string& column_name) const {
+        return dataset(dataset_name).column<T>(column_name);
+    }
+
+    void prefetch(int N_threads = 1) const {
+        for (const auto& d : datasets) d.second->prefetch(N_threads);
+    }
+};
+
+NS_EA_END
@@ -0,0 +1,89 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <Dataset.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#ifdef OPENGA_HAS_MMAP
+#    include <sys/wait.h>
+#    include <unistd.h>
+#endif
+
+struct DatasetTest : ::testing::Test {
+    void SetUp() override {
+        path = ::testing::TempDir() + "openga_dataset_test";
+        for (int i = 0; i < 5000; i++) {
+            prices.push_back(0.5 * i);
+            ids.push_back(uint32_t(7 * i));
+        }
+        EA::DatasetWriter().add_column("price", prices).add_column("id", ids).write(path);
+    }
+    void TearDown() override { std::remove(path.c_str()); }
+
+    std::string path;
+    std::vector<double> prices;
+    std::vector<uint32_t> ids;
+};
+
+TEST_F(DatasetTest, columnsAreReadInPlace) {
+    EA::Dataset dataset(path);
+    ASSERT_TRUE(dataset.is_open());
+    EXPECT_EQ(dataset.column_names(), (std::vector<std::string>{"id", "price"}));
+    EA::DatasetColumn<double> price = dataset.column<double>("price");
+    EA::DatasetColumn<uint32_t> id = dataset.column<uint32_t>("id");
+    ASSERT_EQ(price.size(), prices.size());
+    ASSERT_EQ(id.size(), ids.size());
+    EXPECT_EQ(std::vector<double>(price.begin(), price.end()), prices);
+    EXPECT_EQ(std::vector<uint32_t>(id.begin(), id.end()), ids);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(price.data()) % EA::dataset_block_alignment, 0u);
+    EXPECT_THROW(dataset.column<float>("price"), std::runtime_error);
+    EXPECT_THROW(dataset.column<double>("volume"), std::runtime_error);
+    dataset.prefetch(3);
+    dataset.prefetch(1, {"id"});
+    EXPECT_EQ(price[4999], 0.5 * 4999);
+}
+
+TEST_F(DatasetTest, sharedOncePerProcess) {
+    std::shared_ptr<const EA::Dataset> a = EA::shared_dataset(path);
+    std::shared_ptr<const EA::Dataset> b = EA::shared_dataset(path);
+    EXPECT_EQ(a.get(), b.get());
+
+    EA::EvaluationContext context;
+    context.add_dataset("market", path);
+    EXPECT_EQ(&context.dataset("market"), a.get());
+    EXPECT_EQ(context.column<double>("market", "price")[2], 1.0);
+    EXPECT_THROW(context.dataset("other"), std::runtime_error);
+}
+
+TEST_F(DatasetTest, invalidFiles) {
+    const std::string other = path + "_other";
+    {
+        std::FILE* f = std::fopen(other.c_str(), "wb");
+        std::fputs("not a dataset at all", f);
+        std::fclose(f);
+    }
+    EXPECT_THROW(EA::Dataset dataset(other), std::runtime_error);
+    std::remove(other.c_str());
+    EXPECT_THROW(EA::Dataset dataset(other), std::runtime_error);
+    EXPECT_THROW(EA::DatasetWriter().add_column("x", prices).add_column("x", ids), std::runtime_error);
+}
+
+#ifdef OPENGA_HAS_MMAP
+TEST_F(DatasetTest, forkedEvaluatorsInheritTheMapping) {
+    EA::Dataset dataset(path);
+    EA::DatasetColumn<uint32_t> id = dataset.column<uint32_t>("id");
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        uint64_t sum = 0;
+        for (uint32_t v : id) sum += v;
+        _exit(sum == 7ull * 4999 * 5000 / 2 ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+#endif
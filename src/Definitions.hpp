@@ -1,5 +1,7 @@
 #pragma once
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #ifndef NS_EA_BEGIN
 #    define NS_EA_BEGIN namespace EA {
@@ -11,3 +13,20 @@ extern std::mutex mtx_rand;
 #else
 std::mutex mtx_rand;
 #endif
+
+NS_EA_BEGIN
+
+// runs f(w) for w in [0,N_workers), on threads if there are several workers
+template<typename F>
+void run_on_workers(int N_workers, F f) {
+    if (N_workers <= 1) {
+        f(0);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (int w = 1; w < N_workers; w++) workers.push_back(std::thread(f, w));
+    f(0);
+    for (std::thread& th : workers) th.join();
+}
+
+NS_EA_END
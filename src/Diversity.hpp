@@ -0,0 +1,96 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "Definitions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Running mean and variance of vectors (Welford).
+ * Partial statistics of several threads are combined
+ * with merge (Chan et al.), so a population can be
+ * measured in parallel chunks.
+ ****************************************************/
+struct VectorStats {
+    unsigned long n = 0;
+    std::vector<double> mean;
+    std::vector<double> m2; // sums of squared deviations from the mean
+
+    void add(const std::vector<double>& x) {
+        if (n == 0) {
+            mean.assign(x.size(), 0.0);
+            m2.assign(x.size(), 0.0);
+        }
+        n++;
+        for (std::size_t i = 0; i < x.size() && i < mean.size(); i++) {
+            const double delta = x[i] - mean[i];
+            mean[i] += delta / double(n);
+            m2[i] += delta * (x[i] - mean[i]);
+        }
+    }
+
+    void merge(const VectorStats& other) {
+        if (other.n == 0) return;
+        if (n == 0) {
+            *this = other;
+            return;
+        }
+        const double n_a = double(n), n_b = double(other.n), n_ab = n_a + n_b;
+        for (std::size_t i = 0; i < mean.size() && i < other.mean.size(); i++) {
+            const double delta = other.mean[i] - mean[i];
+            mean[i] += delta * n_b / n_ab;
+            m2[i] += other.m2[i] + delta * delta * n_a * n_b / n_ab;
+        }
+        n += other.n;
+    }
+
+    // population variance per component
+    std::vector<double> variance() const {
+        std::vector<double> v(m2.size(), 0.0);
+        if (n > 0)
+            for (std::size_t i = 0; i < m2.size(); i++) v[i] = m2[i] / double(n);
+        return v;
+    }
+};
+
+inline double euclidean_distance(const std::vector<double>& a, const std::vector<double>& b) {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < a.size() && i < b.size(); i++) sum += (a[i] - b[i]) * (a[i] - b[i]);
+    return std::sqrt(sum);
+}
+
+// Shannon entropy of the distribution of the keys divided by log(N): 1 if all keys differ, 0 if all are equal.
+inline double normalized_entropy(std::vector<uint64_t> keys) {
+    const std::size_t N = keys.size();
+    if (N < 2) return 0.0;
+    std::sort(keys.begin(), keys.end());
+    double h = 0.0;
+    for (std::size_t i = 0; i < N;) {
+        std::size_t j = i;
+        while (j < N && keys[j] == keys[i]) j++;
+        const double p = double(j - i) / double(N);
+        h -= p * std::log(p);
+        i = j;
+    }
+    return h / std::log(double(N));
+}
+
+// diversity of a generation
+struct DiversityMetrics {
+    bool measured = false;
+    std::vector<double> gene_mean; // per component of the gene embedding
+    std::vector<double> gene_variance;
+    double mean_gene_variance = 0.0;
+    double mean_pairwise_distance = 0.0; // over sampled pairs of members
+    unsigned int N_pairs = 0;
+    double entropy = -1.0; // normalized entropy of the gene hashes, -1 without hash_genes
+    std::vector<double> objective_range; // max-min per objective (the total cost in single objective mode)
+    double objective_spread = 0.0; // mean of objective_range
+};
+
+NS_EA_END
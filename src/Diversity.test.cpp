@@ -0,0 +1,41 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <Diversity.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(DiversityTest, vectorStats) {
+    const std::vector<std::vector<double>> points = {{1, 10}, {2, 10}, {3, 10}, {6, 10}};
+    EA::VectorStats s;
+    for (const auto& p : points) s.add(p);
+    EXPECT_EQ(s.n, 4u);
+    EXPECT_DOUBLE_EQ(s.mean[0], 3.0);
+    EXPECT_DOUBLE_EQ(s.mean[1], 10.0);
+    EXPECT_DOUBLE_EQ(s.variance()[0], (4.0 + 1.0 + 0.0 + 9.0) / 4.0);
+    EXPECT_DOUBLE_EQ(s.variance()[1], 0.0);
+}
+
+TEST(DiversityTest, mergedStatsMatchASinglePass) {
+    EA::VectorStats all, a, b, empty;
+    for (int i = 0; i < 50; i++) {
+        const std::vector<double> x = {double(i * i % 17), double(i) * 0.5};
+        all.add(x);
+        (i % 3 ? a : b).add(x);
+    }
+    a.merge(empty);
+    a.merge(b);
+    EXPECT_EQ(a.n, all.n);
+    for (int k = 0; k < 2; k++) {
+        EXPECT_NEAR(a.mean[k], all.mean[k], 1e-12);
+        EXPECT_NEAR(a.variance()[k], all.variance()[k], 1e-9);
+    }
+    empty.merge(all);
+    EXPECT_EQ(empty.n, all.n);
+}
+
+TEST(DiversityTest, entropyAndDistance) {
+    EXPECT_DOUBLE_EQ(EA::normalized_entropy({1, 2, 3, 4}), 1.0);
+    EXPECT_DOUBLE_EQ(EA::normalized_entropy({7, 7, 7, 7}), 0.0);
+    EXPECT_NEAR(EA::normalized_entropy({1, 1, 2, 2}), 0.5, 1e-12);
+    EXPECT_EQ(EA::normalized_entropy({5}), 0.0);
+    EXPECT_DOUBLE_EQ(EA::euclidean_distance({0, 0}, {3, 4}), 5.0);
+}
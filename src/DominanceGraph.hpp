@@ -0,0 +1,91 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "Definitions.hpp"
+#include <vector>
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Domination relations of a population, kept between
+ * generations for incremental non-dominated sorting.
+ * Survivors keep their relations, so only the pairs
+ * involving new members have to be compared:
+ *   extend()   compares the appended members with all
+ *              others,
+ *   restrict() drops the members which did not survive
+ *              without any comparison,
+ *   fronts()   peels the fronts from the relations.
+ ****************************************************/
+class DominanceGraph {
+    std::vector<std::vector<unsigned int>> dominated; // dominated[i]: members dominated by i
+    unsigned long n_comparisons;
+
+public:
+    DominanceGraph()
+        : n_comparisons(0) {}
+
+    unsigned int size() const { return (unsigned int)dominated.size(); }
+
+    void clear() { dominated.clear(); }
+
+    // number of dominance checks done so far
+    unsigned long comparisons() const { return n_comparisons; }
+
+    // Adds the members [size(), chromosomes.size()) of the population.
+    template<typename ChromosomesT, typename DominatesFunction>
+    void extend(const ChromosomesT& chromosomes, DominatesFunction dominates) {
+        const unsigned int first = size();
+        const unsigned int N = (unsigned int)chromosomes.size();
+        if (N < first) {
+            clear();
+            extend(chromosomes, dominates);
+            return;
+        }
+        dominated.resize(N);
+        for (unsigned int i = first; i < N; i++) {
+            for (unsigned int j = 0; j < i; j++) {
+                n_comparisons++;
+                if (dominates(chromosomes[i], chromosomes[j]))
+                    dominated[i].push_back(j);
+                else if (dominates(chromosomes[j], chromosomes[i]))
+                    dominated[j].push_back(i);
+            }
+        }
+    }
+
+    // Keeps only the given members. kept[k] is the current index of the new member k.
+    void restrict(const std::vector<unsigned int>& kept) {
+        const unsigned int not_kept = (unsigned int)(-1);
+        std::vector<unsigned int> new_index(dominated.size(), not_kept);
+        for (unsigned int k = 0; k < kept.size(); k++) new_index[kept[k]] = k;
+        std::vector<std::vector<unsigned int>> restricted(kept.size());
+        for (unsigned int k = 0; k < kept.size(); k++) {
+            for (unsigned int j : dominated[kept[k]])
+                if (new_index[j] != not_kept) restricted[k].push_back(new_index[j]);
+        }
+        dominated.swap(restricted);
+    }
+
+    void fronts(std::vector<std::vector<unsigned int>>& result) const {
+        const unsigned int N = size();
+        std::vector<unsigned int> dominated_count(N, 0);
+        for (const std::vector<unsigned int>& d : dominated)
+            for (unsigned int j : d) dominated_count[j]++;
+        result.clear();
+        std::vector<unsigned int> front;
+        for (unsigned int i = 0; i < N; i++)
+            if (dominated_count[i] == 0) front.push_back(i);
+        while (!front.empty()) {
+            result.push_back(front);
+            std::vector<unsigned int> next_front;
+            for (unsigned int i : result.back())
+                for (unsigned int j : dominated[i])
+                    if (--dominated_count[j] == 0) next_front.push_back(j);
+            front.swap(next_front);
+        }
+    }
+};
+
+NS_EA_END
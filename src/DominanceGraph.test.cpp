@@ -0,0 +1,89 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <DominanceGraph.hpp>
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Point = std::vector<double>;
+
+bool dominates(const Point& a, const Point& b) {
+    for (unsigned int i = 0; i < a.size(); i++)
+        if (a[i] > b[i]) return false;
+    for (unsigned int i = 0; i < a.size(); i++)
+        if (a[i] < b[i]) return true;
+    return false;
+}
+
+// front index of every point, by brute force
+std::vector<int> front_of(const std::vector<Point>& points) {
+    std::vector<int> front(points.size(), -1);
+    int f = 0;
+    unsigned int assigned = 0;
+    while (assigned < points.size()) {
+        std::vector<unsigned int> current;
+        for (unsigned int i = 0; i < points.size(); i++) {
+            if (front[i] >= 0) continue;
+            bool is_dominated = false;
+            for (unsigned int j = 0; j < points.size(); j++)
+                if ((front[j] < 0 || front[j] == f) && j != i && dominates(points[j], points[i])) is_dominated = true;
+            if (!is_dominated) current.push_back(i);
+        }
+        for (unsigned int i : current) front[i] = f;
+        assigned += (unsigned int)current.size();
+        f++;
+    }
+    return front;
+}
+
+std::vector<int> front_of(const EA::DominanceGraph& graph) {
+    std::vector<std::vector<unsigned int>> fronts;
+    graph.fronts(fronts);
+    std::vector<int> front(graph.size(), -1);
+    for (unsigned int f = 0; f < fronts.size(); f++)
+        for (unsigned int i : fronts[f]) front[i] = (int)f;
+    return front;
+}
+
+} // namespace
+
+TEST(DominanceGraphTest, frontsOfKnownPoints) {
+    std::vector<Point> points = {{1, 1}, {2, 2}, {0, 3}, {3, 0}, {3, 3}, {2, 2}};
+    EA::DominanceGraph graph;
+    graph.extend(points, dominates);
+    EXPECT_EQ(front_of(graph), (std::vector<int>{0, 1, 0, 0, 2, 1}));
+}
+
+TEST(DominanceGraphTest, incrementalMatchesFullSort) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+    const unsigned int population = 40, offspring = 25;
+    std::vector<Point> points;
+    for (unsigned int i = 0; i < population; i++) points.push_back({unif(rng), unif(rng), unif(rng)});
+
+    EA::DominanceGraph graph;
+    graph.extend(points, dominates);
+    for (int generation = 0; generation < 10; generation++) {
+        for (unsigned int i = 0; i < offspring; i++) points.push_back({unif(rng), unif(rng), unif(rng)});
+        unsigned long before = graph.comparisons();
+        graph.extend(points, dominates);
+        // only the pairs with at least one offspring are compared
+        EXPECT_EQ(graph.comparisons() - before,
+            (unsigned long)(offspring * population + offspring * (offspring - 1) / 2));
+        EXPECT_EQ(front_of(graph), front_of(points));
+
+        // keep a random subset in a new order
+        std::vector<unsigned int> kept(points.size());
+        for (unsigned int i = 0; i < kept.size(); i++) kept[i] = i;
+        std::shuffle(kept.begin(), kept.end(), rng);
+        kept.resize(population);
+        std::vector<Point> survivors;
+        for (unsigned int i : kept) survivors.push_back(points[i]);
+        points = survivors;
+        graph.restrict(kept);
+        EXPECT_EQ(graph.size(), population);
+        EXPECT_EQ(front_of(graph), front_of(points));
+    }
+}
@@ -0,0 +1,239 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "BulkRandom.hpp"
+#include "Definitions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+NS_EA_BEGIN
+
+// distribution model of the estimation-of-distribution mode
+enum class EDAMode { Off, UMDA, PBIL, LinkageTree };
+
+/****************************************************
+ * Probability model over categorical variables, where
+ * variable v takes the values 0..cardinality[v]-1
+ * (binary genes have cardinality 2).
+ *
+ * UMDA: independent marginals, the value frequencies
+ *  of the selected members.
+ * PBIL: independent marginals moved towards these
+ *  frequencies by learning_rate every generation.
+ * LinkageTree: the variables are clustered bottom-up
+ *  by the mutual information of their values in the
+ *  selected members (average linkage). The clusters
+ *  merged at a normalized mutual information of at
+ *  least linkage_threshold, of at most max_block
+ *  variables, form the blocks of a marginal product
+ *  model. A block is sampled jointly by copying its
+ *  values from a random selected member, so that linked
+ *  values are never split up.
+ *
+ * Every value is sampled with a probability of at
+ * least margin, so that no value is lost for good. The
+ * margin is applied when sampling and is not kept in
+ * the fitted probabilities, where PBIL would compound
+ * it from generation to generation. fit() splits the
+ * counting between N_threads threads and sample()
+ * draws a whole batch variable by variable.
+ ****************************************************/
+class DistributionModel {
+    std::vector<unsigned int> cardinality;
+    std::vector<std::size_t> offset; // of the probabilities of variable v
+    std::vector<double> prob;
+    bool fitted;
+    std::vector<std::vector<unsigned int>> selected; // LinkageTree: the members the blocks are copied from
+    std::vector<std::vector<unsigned int>> linkage_blocks;
+
+public:
+    EDAMode mode;
+    double learning_rate; // PBIL
+    double margin; // minimum probability of a value
+    double linkage_threshold;
+    unsigned int max_block;
+
+    DistributionModel(const std::vector<unsigned int>& cardinality, EDAMode mode)
+        : cardinality(cardinality)
+        , fitted(false)
+        , mode(mode)
+        , learning_rate(0.1)
+        , margin(0.0)
+        , linkage_threshold(0.2)
+        , max_block(8) {
+        std::size_t n = 0;
+        for (unsigned int K : cardinality) {
+            if (K < 1) throw std::runtime_error("A variable of the distribution model has no values.");
+            offset.push_back(n);
+            n += K;
+        }
+        offset.push_back(n);
+        prob.resize(n);
+        for (std::size_t v = 0; v < cardinality.size(); v++)
+            for (std::size_t k = offset[v]; k < offset[v + 1]; k++) prob[k] = 1.0 / double(cardinality[v]);
+        for (unsigned int v = 0; v < cardinality.size(); v++) linkage_blocks.push_back({v});
+    }
+
+    std::size_t N_variables() const { return cardinality.size(); }
+
+    // the probability of sampling the value, with the margin
+    double probability(std::size_t variable, unsigned int value) const {
+        const double K = double(cardinality[variable]);
+        const double m = std::min(margin, 1.0 / K);
+        return (1.0 - K * m) * prob[offset[variable] + value] + m;
+    }
+
+    // LinkageTree: the jointly sampled blocks of variables, else one block per variable
+    const std::vector<std::vector<unsigned int>>& blocks() const { return linkage_blocks; }
+
+    void fit(const std::vector<std::vector<unsigned int>>& members, int N_threads = 1) {
+        const std::size_t N = members.size();
+        const unsigned int L = (unsigned int)cardinality.size();
+        if (N == 0) return;
+        for (const std::vector<unsigned int>& x : members) {
+            if (x.size() != L) throw std::runtime_error("Wrong number of variables for the distribution model.");
+            for (unsigned int v = 0; v < L; v++)
+                if (x[v] >= cardinality[v]) throw std::runtime_error("Variable value out of its cardinality.");
+        }
+        const int N_workers = std::max(1, std::min(N_threads, int(L)));
+
+        std::vector<double> frequency(prob.size(), 0.0);
+        run_on_workers(N_workers, [&](int w) {
+            for (unsigned int v = (unsigned int)w; v < L; v += (unsigned int)N_workers) {
+                for (const std::vector<unsigned int>& x : members) frequency[offset[v] + x[v]] += 1.0;
+                for (std::size_t k = offset[v]; k < offset[v + 1]; k++) frequency[k] /= double(N);
+            }
+        });
+        const double rate = (mode == EDAMode::PBIL && fitted) ? learning_rate : 1.0;
+        for (std::size_t k = 0; k < prob.size(); k++) prob[k] = (1.0 - rate) * prob[k] + rate * frequency[k];
+        fitted = true;
+
+        if (mode == EDAMode::LinkageTree) {
+            selected = members;
+            build_linkage_tree(frequency, N_workers);
+        }
+    }
+
+    /****************************************************
+     * Draws n members into out (n rows of N_variables()
+     * values). Each variable (or linkage block) is drawn
+     * for the whole batch at once from a block of uniform
+     * numbers, then scattered into the rows.
+     ****************************************************/
+    void sample(unsigned int n, BulkRandom& rng, std::vector<std::vector<unsigned int>>& out) const {
+        const unsigned int L = (unsigned int)cardinality.size();
+        out.assign(n, std::vector<unsigned int>(L));
+        std::vector<double> u(n);
+        std::vector<unsigned int> column(n);
+        if (mode != EDAMode::LinkageTree || selected.empty()) {
+            std::vector<double> p(*std::max_element(cardinality.begin(), cardinality.end()));
+            for (unsigned int v = 0; v < L; v++) {
+                rng.uniform(u);
+                for (unsigned int k = 0; k < cardinality[v]; k++) p[k] = probability(v, k);
+                if (cardinality[v] == 2) {
+                    for (unsigned int r = 0; r < n; r++) column[r] = u[r] < p[0] ? 0u : 1u;
+                }
+                else {
+                    for (unsigned int r = 0; r < n; r++) {
+                        unsigned int k = 0;
+                        double cdf = p[0];
+                        while (u[r] >= cdf && k + 1 < cardinality[v]) cdf += p[++k];
+                        column[r] = k;
+                    }
+                }
+                for (unsigned int r = 0; r < n; r++) out[r][v] = column[r];
+            }
+            return;
+        }
+
+        const int N_selected = int(selected.size());
+        std::vector<int> donor(n);
+        for (const std::vector<unsigned int>& block : linkage_blocks) {
+            rng.integers(donor.data(), n, 0, N_selected - 1);
+            for (unsigned int v : block)
+                for (unsigned int r = 0; r < n; r++) out[r][v] = selected[std::size_t(donor[r])][v];
+        }
+        // a value is redrawn uniformly with probability K*margin, which keeps it at a probability of margin
+        std::vector<int> value(n);
+        for (unsigned int v = 0; v < L && margin > 0.0; v++) {
+            const double redraw = std::min(1.0, double(cardinality[v]) * margin);
+            rng.uniform(u);
+            rng.integers(value.data(), n, 0, int(cardinality[v]) - 1);
+            for (unsigned int r = 0; r < n; r++)
+                if (u[r] < redraw) out[r][v] = (unsigned int)value[r];
+        }
+    }
+
+private:
+    // mutual information of variables a and b divided by the smaller of their entropies
+    double normalized_mutual_information(unsigned int a, unsigned int b, const std::vector<double>& frequency) const {
+        const unsigned int Ka = cardinality[a], Kb = cardinality[b];
+        std::vector<double> joint(std::size_t(Ka) * Kb, 0.0);
+        for (const std::vector<unsigned int>& x : selected) joint[std::size_t(x[a]) * Kb + x[b]] += 1.0;
+        const double N = double(selected.size());
+        double mi = 0.0, ha = 0.0, hb = 0.0;
+        for (unsigned int i = 0; i < Ka; i++) {
+            const double pa = frequency[offset[a] + i];
+            if (pa > 0.0) ha -= pa * std::log(pa);
+            for (unsigned int j = 0; j < Kb; j++) {
+                const double pab = joint[std::size_t(i) * Kb + j] / N;
+                const double pb = frequency[offset[b] + j];
+                if (pab > 0.0) mi += pab * std::log(pab / (pa * pb));
+            }
+        }
+        for (unsigned int j = 0; j < Kb; j++) {
+            const double pb = frequency[offset[b] + j];
+            if (pb > 0.0) hb -= pb * std::log(pb);
+        }
+        const double h = std::min(ha, hb);
+        return h > 1e-12 ? std::max(0.0, mi) / h : 0.0;
+    }
+
+    void build_linkage_tree(const std::vector<double>& frequency, int N_workers) {
+        const unsigned int L = (unsigned int)cardinality.size();
+        // pairwise mutual information, rows split between the threads
+        std::vector<double> mi(std::size_t(L) * L, 0.0);
+        run_on_workers(N_workers, [&](int w) {
+            for (unsigned int a = (unsigned int)w; a < L; a += (unsigned int)N_workers)
+                for (unsigned int b = a + 1; b < L; b++)
+                    mi[std::size_t(a) * L + b] = mi[std::size_t(b) * L + a] =
+                        normalized_mutual_information(a, b, frequency);
+        });
+
+        // average linkage clustering, the link of two clusters is the mean over their variable pairs
+        std::vector<std::vector<unsigned int>> clusters;
+        for (unsigned int v = 0; v < L; v++) clusters.push_back({v});
+        std::vector<std::vector<double>> link(L, std::vector<double>(L, 0.0));
+        for (unsigned int a = 0; a < L; a++)
+            for (unsigned int b = 0; b < L; b++) link[a][b] = mi[std::size_t(a) * L + b];
+        while (clusters.size() > 1) {
+            std::size_t best_a = 0, best_b = 0;
+            double best = -1.0;
+            for (std::size_t a = 0; a < clusters.size(); a++)
+                for (std::size_t b = a + 1; b < clusters.size(); b++)
+                    if (clusters[a].size() + clusters[b].size() <= max_block && link[a][b] > best) {
+                        best = link[a][b];
+                        best_a = a;
+                        best_b = b;
+                    }
+            if (best < linkage_threshold) break;
+            const double na = double(clusters[best_a].size()), nb = double(clusters[best_b].size());
+            for (std::size_t c = 0; c < clusters.size(); c++) {
+                const double merged = (na * link[best_a][c] + nb * link[best_b][c]) / (na + nb);
+                link[best_a][c] = link[c][best_a] = merged;
+            }
+            clusters[best_a].insert(clusters[best_a].end(), clusters[best_b].begin(), clusters[best_b].end());
+            clusters.erase(clusters.begin() + std::ptrdiff_t(best_b));
+            link.erase(link.begin() + std::ptrdiff_t(best_b));
+            for (std::vector<double>& row : link) row.erase(row.begin() + std::ptrdiff_t(best_b));
+        }
+        linkage_blocks = clusters;
+    }
+};
+
+NS_EA_END
@@ -0,0 +1,87 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <EDA.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+using Rows = std::vector<std::vector<unsigned int>>;
+
+TEST(EDATest, umdaFitsTheFrequencies) {
+    EA::DistributionModel model({2, 3}, EA::EDAMode::UMDA);
+    EXPECT_DOUBLE_EQ(model.probability(1, 2), 1.0 / 3.0);
+    model.fit({{1, 0}, {1, 2}, {0, 2}, {1, 2}}, 2);
+    EXPECT_DOUBLE_EQ(model.probability(0, 1), 0.75);
+    EXPECT_DOUBLE_EQ(model.probability(1, 0), 0.25);
+    EXPECT_DOUBLE_EQ(model.probability(1, 1), 0.0);
+    EXPECT_DOUBLE_EQ(model.probability(1, 2), 0.75);
+
+    model.margin = 0.05;
+    model.fit({{1, 1}, {1, 1}}, 1);
+    EXPECT_DOUBLE_EQ(model.probability(0, 0), 0.05);
+    EXPECT_DOUBLE_EQ(model.probability(0, 1), 0.95);
+    EXPECT_DOUBLE_EQ(model.probability(1, 0), 0.05);
+    EXPECT_THROW(model.fit({{1, 3}}), std::runtime_error);
+    EXPECT_THROW(model.fit({{1}}), std::runtime_error);
+}
+
+TEST(EDATest, pbilMovesTowardsTheFrequencies) {
+    EA::DistributionModel model({2}, EA::EDAMode::PBIL);
+    model.learning_rate = 0.25;
+    model.fit({{1}}); // the first fit starts from the frequencies
+    EXPECT_DOUBLE_EQ(model.probability(0, 1), 1.0);
+    model.fit({{0}, {0}});
+    EXPECT_DOUBLE_EQ(model.probability(0, 1), 0.75);
+    model.fit({{0}});
+    EXPECT_DOUBLE_EQ(model.probability(0, 1), 0.5625);
+}
+
+TEST(EDATest, pbilDoesNotCompoundTheMargin) {
+    EA::DistributionModel model({2}, EA::EDAMode::PBIL);
+    model.learning_rate = 0.5;
+    model.margin = 0.1;
+    for (int i = 0; i < 10; i++) model.fit({{1}});
+    EXPECT_DOUBLE_EQ(model.probability(0, 0), 0.1);
+    model.margin = 0.0;
+    EXPECT_DOUBLE_EQ(model.probability(0, 0), 0.0);
+}
+
+TEST(EDATest, samplesFollowTheMarginals) {
+    EA::DistributionModel model({2, 3}, EA::EDAMode::UMDA);
+    model.fit({{1, 0}, {1, 1}, {0, 2}, {1, 2}});
+    EA::BulkRandom rng(7);
+    Rows batch;
+    const unsigned int n = 40000;
+    model.sample(n, rng, batch);
+    ASSERT_EQ(batch.size(), n);
+    double ones = 0.0, twos = 0.0;
+    for (const std::vector<unsigned int>& x : batch) {
+        ASSERT_EQ(x.size(), 2u);
+        ones += x[0] == 1 ? 1.0 / n : 0.0;
+        twos += x[1] == 2 ? 1.0 / n : 0.0;
+    }
+    EXPECT_NEAR(ones, 0.75, 0.01);
+    EXPECT_NEAR(twos, 0.5, 0.01);
+}
+
+TEST(EDATest, linkageTreeKeepsLinkedValuesTogether) {
+    // variables 0, 2 and 4 are equal, 1 and 3 are equal, 5 is independent
+    EA::BulkRandom rng(3);
+    Rows selected;
+    for (int i = 0; i < 200; i++) {
+        const unsigned int a = rng() < 0.5, b = rng() < 0.5, c = rng() < 0.5;
+        selected.push_back({a, b, a, b, a, c});
+    }
+    EA::DistributionModel model(std::vector<unsigned int>(6, 2), EA::EDAMode::LinkageTree);
+    model.fit(selected, 3);
+    EXPECT_EQ(model.blocks(), (Rows{{0, 2, 4}, {1, 3}, {5}}));
+
+    Rows batch;
+    model.sample(1000, rng, batch);
+    for (const std::vector<unsigned int>& x : batch) {
+        EXPECT_TRUE(x[0] == x[2] && x[2] == x[4]);
+        EXPECT_EQ(x[1], x[3]);
+    }
+
+    model.max_block = 2;
+    model.fit(selected, 1);
+    for (const std::vector<unsigned int>& block : model.blocks()) EXPECT_LE(block.size(), 2u);
+}
@@ -0,0 +1,547 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "BinaryCodec.hpp"
+#include "Definitions.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef OPENGA_HAS_MMAP
+#    include <sys/file.h>
+#endif
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Persistent evaluation results shared between runs
+ * and between processes on the same host.
+ *
+ * <path>.log is an append-only list of records
+ *     [key : 8 bytes][payload size : 8 bytes][payload]
+ * <path>.idx is a memory-mapped open-addressing hash
+ * table from keys to log offsets. Its header holds the
+ * committed log size, so bytes written by a process
+ * that crashed before updating the index are ignored.
+ *
+ * Readers take a shared flock() on the index file and
+ * writers an exclusive one. Within a process, lookups
+ * run concurrently: the first reader thread takes the
+ * shared flock() and the last one releases it, while
+ * insertions and compactions wait for all readers and
+ * hold the index alone. When the log grows beyond
+ * max_log_bytes, the oldest records are dropped until
+ * the log fits into keep_fraction*max_log_bytes.
+ ****************************************************/
+class EvaluationStore {
+    struct IndexHeader {
+        uint64_t magic;
+        uint64_t epoch; // changes on index growth and log compaction
+        uint64_t capacity; // number of slots, power of two
+        uint64_t count;
+        uint64_t log_size; // committed bytes of the log
+        uint64_t reserved[3];
+    };
+
+    struct IndexSlot {
+        uint64_t key;
+        uint64_t offset_plus_one; // zero marks an empty slot
+    };
+
+    static const uint64_t index_magic = 0x5844494147416f4fULL;
+    static const uint64_t initial_capacity = 1024;
+    static const std::size_t record_header_size = 16;
+
+    std::string log_path;
+    std::string index_path;
+    uint64_t max_log_bytes;
+    double keep_fraction;
+
+    // flock() does not exclude threads of the same process, they share one lock of the index file
+    std::mutex mtx;
+    std::condition_variable lock_cv;
+    int n_readers;
+    int n_waiting_writers;
+    bool writing;
+    int index_fd;
+    int log_fd;
+    IndexHeader* header;
+    IndexSlot* slots;
+    std::size_t mapped_bytes;
+    uint64_t known_epoch;
+
+    std::deque<std::pair<uint64_t, std::string>> pending;
+    bool pending_busy;
+    bool stopping;
+    std::mutex queue_mtx;
+    std::condition_variable queue_cv;
+    std::thread worker;
+
+    std::atomic<unsigned long> n_hits;
+    std::atomic<unsigned long> n_misses;
+    std::atomic<unsigned long> n_inserts;
+    std::atomic<unsigned long> n_compactions;
+
+public:
+    explicit EvaluationStore(const std::string& path, uint64_t max_log_bytes = 0, double keep_fraction = 0.5)
+        : log_path(path + ".log")
+        , index_path(path + ".idx")
+        , max_log_bytes(max_log_bytes)
+        , keep_fraction(keep_fraction)
+        , n_readers(0)
+        , n_waiting_writers(0)
+        , writing(false)
+        , index_fd(-1)
+        , log_fd(-1)
+        , header(nullptr)
+        , slots(nullptr)
+        , mapped_bytes(0)
+        , known_epoch(0)
+        , pending_busy(false)
+        , stopping(false)
+        , n_hits(0)
+        , n_misses(0)
+        , n_inserts(0)
+        , n_compactions(0) {
+#ifdef OPENGA_HAS_MMAP
+        if (keep_fraction <= 0.0 || keep_fraction > 1.0)
+            throw std::runtime_error("Wrong evaluation store keep fraction");
+        try {
+            index_fd = ::open(index_path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (index_fd < 0) throw std::runtime_error("Cannot open evaluation index " + index_path);
+            open_log();
+            FileLock lock(index_fd, true);
+            struct stat st;
+            if (fstat(index_fd, &st) != 0) throw std::runtime_error("Cannot stat evaluation index " + index_path);
+            if (std::size_t(st.st_size) < sizeof(IndexHeader)) {
+                resize_index_file(initial_capacity);
+                map_index();
+                header->magic = index_magic;
+                header->epoch = 1;
+                header->capacity = initial_capacity;
+                header->count = 0;
+                header->log_size = 0;
+            }
+            else
+                map_index();
+            if (header->magic != index_magic) throw std::runtime_error("Not an evaluation index: " + index_path);
+            known_epoch = header->epoch;
+        }
+        catch (...) {
+            unmap_index();
+            if (log_fd >= 0) ::close(log_fd);
+            if (index_fd >= 0) ::close(index_fd);
+            throw;
+        }
+#else
+        throw std::runtime_error("EvaluationStore requires a POSIX platform.");
+#endif
+    }
+
+    EvaluationStore(const EvaluationStore&) = delete;
+    EvaluationStore& operator=(const EvaluationStore&) = delete;
+
+    ~EvaluationStore() {
+        {
+            std::lock_guard<std::mutex> lock(queue_mtx);
+            stopping = true;
+        }
+        queue_cv.notify_all();
+        if (worker.joinable()) worker.join();
+#ifdef OPENGA_HAS_MMAP
+        unmap_index();
+        if (log_fd >= 0) ::close(log_fd);
+        if (index_fd >= 0) ::close(index_fd);
+#endif
+    }
+
+    bool lookup(uint64_t key, std::string& payload) {
+        bool found = false;
+#ifdef OPENGA_HAS_MMAP
+        ReadLock lock(*this);
+        uint64_t offset;
+        if (find_slot(key, offset)) found = read_record(offset, key, payload);
+#else
+        (void)key;
+        (void)payload;
+#endif
+        if (found)
+            n_hits++;
+        else
+            n_misses++;
+        return found;
+    }
+
+    void insert(uint64_t key, const std::string& payload) {
+#ifdef OPENGA_HAS_MMAP
+        WriteLock lock(*this);
+        uint64_t offset;
+        if (find_slot(key, offset)) return; // another run was faster
+        offset = header->log_size;
+        std::string record;
+        put_fixed64(record, key);
+        put_fixed64(record, payload.size());
+        record.append(payload);
+        write_all(log_fd, record.data(), record.size(), offset);
+        header->log_size = offset + record.size();
+        if ((header->count + 1) * 2 > header->capacity) grow_index();
+        insert_slot(key, offset);
+        header->count++;
+        n_inserts++;
+        if (max_log_bytes > 0 && header->log_size > max_log_bytes)
+            compact_locked(uint64_t(double(max_log_bytes) * keep_fraction));
+#else
+        (void)key;
+        (void)payload;
+#endif
+    }
+
+    // The insertion happens on a background thread.
+    void insert_async(uint64_t key, std::string payload) {
+        std::lock_guard<std::mutex> lock(queue_mtx);
+        if (!worker.joinable()) worker = std::thread(&EvaluationStore::insert_loop, this);
+        pending.push_back(std::make_pair(key, std::move(payload)));
+        queue_cv.notify_all();
+    }
+
+    // Waits for the pending asynchronous insertions.
+    void flush() {
+        std::unique_lock<std::mutex> lock(queue_mtx);
+        queue_cv.wait(lock, [this]() { return pending.empty() && !pending_busy; });
+    }
+
+    // Drops the oldest records until the log fits into target_bytes.
+    void compact(uint64_t target_bytes) {
+#ifdef OPENGA_HAS_MMAP
+        WriteLock lock(*this);
+        compact_locked(target_bytes);
+#else
+        (void)target_bytes;
+#endif
+    }
+
+    uint64_t size() {
+#ifdef OPENGA_HAS_MMAP
+        ReadLock lock(*this);
+#endif
+        return header ? header->count : 0;
+    }
+
+    uint64_t log_bytes() {
+#ifdef OPENGA_HAS_MMAP
+        ReadLock lock(*this);
+#endif
+        return header ? header->log_size : 0;
+    }
+
+    unsigned long hits() const { return n_hits; }
+    unsigned long misses() const { return n_misses; }
+    unsigned long inserts() const { return n_inserts; }
+    unsigned long compactions() const { return n_compactions; }
+
+protected:
+    void insert_loop() {
+        std::unique_lock<std::mutex> lock(queue_mtx);
+        while (true) {
+            queue_cv.wait(lock, [this]() { return !pending.empty() || stopping; });
+            if (pending.empty()) return;
+            std::pair<uint64_t, std::string> item = std::move(pending.front());
+            pending.pop_front();
+            pending_busy = true;
+            lock.unlock();
+            try {
+                insert(item.first, item.second);
+            }
+            catch (...) {
+                // a failed cache insertion only costs a future re-evaluation
+            }
+            lock.lock();
+            pending_busy = false;
+            queue_cv.notify_all();
+        }
+    }
+
+#ifdef OPENGA_HAS_MMAP
+    struct FileLock {
+        int fd;
+        FileLock(int fd, bool exclusive)
+            : fd(fd) {
+            if (flock(fd, exclusive ? LOCK_EX : LOCK_SH) != 0) throw std::runtime_error("Cannot lock evaluation index");
+        }
+        ~FileLock() { flock(fd, LOCK_UN); }
+    };
+
+    // shared access of a lookup, with a mapping that is up to date
+    struct ReadLock {
+        EvaluationStore& store;
+        explicit ReadLock(EvaluationStore& store)
+            : store(store) {
+            while (true) {
+                store.lock_shared();
+                if (!store.mapping_stale()) return;
+                store.unlock_shared();
+                store.lock_exclusive(); // the mapping is renewed by a single thread
+                try {
+                    store.sync_mapping();
+                }
+                catch (...) {
+                    store.unlock_exclusive();
+                    throw;
+                }
+                store.unlock_exclusive();
+            }
+        }
+        ~ReadLock() { store.unlock_shared(); }
+    };
+
+    // exclusive access of an insertion or compaction, with a mapping that is up to date
+    struct WriteLock {
+        EvaluationStore& store;
+        explicit WriteLock(EvaluationStore& store)
+            : store(store) {
+            store.lock_exclusive();
+            try {
+                store.sync_mapping();
+            }
+            catch (...) {
+                store.unlock_exclusive();
+                throw;
+            }
+        }
+        ~WriteLock() { store.unlock_exclusive(); }
+    };
+
+    // waiting writers go first, so that a stream of lookups cannot starve the insertions
+    void lock_shared() {
+        std::unique_lock<std::mutex> lock(mtx);
+        lock_cv.wait(lock, [this]() { return !writing && n_waiting_writers == 0; });
+        if (n_readers == 0 && flock(index_fd, LOCK_SH) != 0) throw std::runtime_error("Cannot lock evaluation index");
+        n_readers++;
+    }
+
+    void unlock_shared() {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (--n_readers == 0) {
+            flock(index_fd, LOCK_UN);
+            lock_cv.notify_all();
+        }
+    }
+
+    void lock_exclusive() {
+        std::unique_lock<std::mutex> lock(mtx);
+        n_waiting_writers++;
+        lock_cv.wait(lock, [this]() { return !writing && n_readers == 0; });
+        n_waiting_writers--;
+        writing = true;
+        lock.unlock();
+        if (flock(index_fd, LOCK_EX) != 0) {
+            unlock_exclusive_state();
+            throw std::runtime_error("Cannot lock evaluation index");
+        }
+    }
+
+    void unlock_exclusive() {
+        flock(index_fd, LOCK_UN);
+        unlock_exclusive_state();
+    }
+
+    void unlock_exclusive_state() {
+        std::lock_guard<std::mutex> lock(mtx);
+        writing = false;
+        lock_cv.notify_all();
+    }
+
+    static void write_all(int fd, const char* data, std::size_t n, uint64_t offset) {
+        while (n > 0) {
+            ssize_t written = pwrite(fd, data, n, off_t(offset));
+            if (written <= 0) throw std::runtime_error("Cannot write the evaluation log");
+            data += written;
+            n -= std::size_t(written);
+            offset += uint64_t(written);
+        }
+    }
+
+    static bool read_all(int fd, char* data, std::size_t n, uint64_t offset) {
+        while (n > 0) {
+            ssize_t got = pread(fd, data, n, off_t(offset));
+            if (got <= 0) return false;
+            data += got;
+            n -= std::size_t(got);
+            offset += uint64_t(got);
+        }
+        return true;
+    }
+
+    static uint64_t slot_of(uint64_t key, uint64_t capacity) { return hash_mix(key) & (capacity - 1); }
+
+    void open_log() {
+        if (log_fd >= 0) ::close(log_fd);
+        log_fd = ::open(log_path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (log_fd < 0) throw std::runtime_error("Cannot open evaluation log " + log_path);
+    }
+
+    void resize_index_file(uint64_t capacity) {
+        std::size_t bytes = sizeof(IndexHeader) + std::size_t(capacity) * sizeof(IndexSlot);
+        if (ftruncate(index_fd, off_t(bytes)) != 0) throw std::runtime_error("Cannot resize evaluation index");
+    }
+
+    void map_index() {
+        unmap_index();
+        struct stat st;
+        if (fstat(index_fd, &st) != 0) throw std::runtime_error("Cannot stat evaluation index");
+        mapped_bytes = std::size_t(st.st_size);
+        void* p = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, index_fd, 0);
+        if (p == MAP_FAILED) {
+            mapped_bytes = 0;
+            throw std::runtime_error("Cannot map evaluation index");
+        }
+        header = static_cast<IndexHeader*>(p);
+        slots = reinterpret_cast<IndexSlot*>(static_cast<char*>(p) + sizeof(IndexHeader));
+    }
+
+    void unmap_index() {
+        if (header) munmap(header, mapped_bytes);
+        header = nullptr;
+        slots = nullptr;
+        mapped_bytes = 0;
+    }
+
+    bool mapping_stale() const {
+        return sizeof(IndexHeader) + header->capacity * sizeof(IndexSlot) != mapped_bytes ||
+            header->epoch != known_epoch;
+    }
+
+    // Catches up with index growth or log compaction done by other processes.
+    void sync_mapping() {
+        if (sizeof(IndexHeader) + header->capacity * sizeof(IndexSlot) != mapped_bytes) map_index();
+        if (header->epoch != known_epoch) {
+            open_log();
+            known_epoch = header->epoch;
+        }
+    }
+
+    bool find_slot(uint64_t key, uint64_t& offset) const {
+        uint64_t capacity = header->capacity;
+        for (uint64_t i = slot_of(key, capacity), n = 0; n < capacity; i = (i + 1) & (capacity - 1), n++) {
+            const IndexSlot& slot = slots[i];
+            if (!slot.offset_plus_one) return false;
+            if (slot.key == key) {
+                offset = slot.offset_plus_one - 1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void insert_slot(uint64_t key, uint64_t offset) {
+        uint64_t capacity = header->capacity;
+        uint64_t i = slot_of(key, capacity);
+        while (slots[i].offset_plus_one) i = (i + 1) & (capacity - 1);
+        slots[i].key = key;
+        slots[i].offset_plus_one = offset + 1;
+    }
+
+    bool read_record(uint64_t offset, uint64_t key, std::string& payload) {
+        char head[record_header_size];
+        if (!read_all(log_fd, head, record_header_size, offset)) return false;
+        if (get_fixed64(head) != key) return false;
+        uint64_t n = get_fixed64(head + 8);
+        if (offset + record_header_size + n > header->log_size) return false;
+        payload.resize(std::size_t(n));
+        return n == 0 || read_all(log_fd, &payload[0], std::size_t(n), offset + record_header_size);
+    }
+
+    void collect_slots(std::vector<IndexSlot>& live) const {
+        live.clear();
+        for (uint64_t i = 0; i < header->capacity; i++)
+            if (slots[i].offset_plus_one) live.push_back(slots[i]);
+    }
+
+    void rebuild_index(const std::vector<IndexSlot>& live, uint64_t capacity) {
+        if (capacity != header->capacity) {
+            resize_index_file(capacity);
+            map_index();
+            header->capacity = capacity;
+        }
+        std::memset(static_cast<void*>(slots), 0, std::size_t(capacity) * sizeof(IndexSlot));
+        for (const IndexSlot& s : live) insert_slot(s.key, s.offset_plus_one - 1);
+        header->count = live.size();
+        header->epoch++;
+        known_epoch = header->epoch;
+    }
+
+    void grow_index() {
+        std::vector<IndexSlot> live;
+        collect_slots(live);
+        rebuild_index(live, header->capacity * 2);
+    }
+
+    void compact_locked(uint64_t target_bytes) {
+        std::vector<IndexSlot> live;
+        collect_slots(live);
+        std::sort(live.begin(), live.end(), [](const IndexSlot& a, const IndexSlot& b) {
+            return a.offset_plus_one < b.offset_plus_one;
+        });
+        // keep the newest records
+        std::vector<uint64_t> sizes(live.size());
+        uint64_t kept_bytes = 0;
+        std::size_t first_kept = live.size();
+        while (first_kept > 0) {
+            char head[record_header_size];
+            uint64_t offset = live[first_kept - 1].offset_plus_one - 1;
+            if (!read_all(log_fd, head, record_header_size, offset))
+                throw std::runtime_error("Corrupted evaluation log");
+            uint64_t record_size = record_header_size + get_fixed64(head + 8);
+            if (kept_bytes + record_size > target_bytes) break;
+            sizes[first_kept - 1] = record_size;
+            kept_bytes += record_size;
+            first_kept--;
+        }
+
+        std::string tmp_path = log_path + ".compact";
+        int tmp_fd = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (tmp_fd < 0) throw std::runtime_error("Cannot create " + tmp_path);
+        std::vector<IndexSlot> kept;
+        uint64_t new_offset = 0;
+        std::string buffer;
+        try {
+            for (std::size_t i = first_kept; i < live.size(); i++) {
+                buffer.resize(std::size_t(sizes[i]));
+                if (!read_all(log_fd, &buffer[0], buffer.size(), live[i].offset_plus_one - 1))
+                    throw std::runtime_error("Corrupted evaluation log");
+                write_all(tmp_fd, buffer.data(), buffer.size(), new_offset);
+                IndexSlot s = live[i];
+                s.offset_plus_one = new_offset + 1;
+                kept.push_back(s);
+                new_offset += sizes[i];
+            }
+            if (fsync(tmp_fd) != 0 || std::rename(tmp_path.c_str(), log_path.c_str()) != 0)
+                throw std::runtime_error("Cannot replace the evaluation log");
+        }
+        catch (...) {
+            ::close(tmp_fd);
+            std::remove(tmp_path.c_str());
+            throw;
+        }
+        ::close(tmp_fd);
+        open_log();
+        header->log_size = new_offset;
+        rebuild_index(kept, header->capacity);
+        n_compactions++;
+    }
+#endif
+};
+
+NS_EA_END
@@ -0,0 +1,108 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <EvaluationStore.hpp>
+#include <atomic>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef OPENGA_HAS_MMAP
+
+struct EvaluationStoreTest : ::testing::Test {
+    void SetUp() override {
+        path = ::testing::TempDir() + "openga_store_test";
+        TearDown();
+    }
+    void TearDown() override {
+        std::remove((path + ".log").c_str());
+        std::remove((path + ".idx").c_str());
+    }
+
+    std::string path;
+};
+
+TEST_F(EvaluationStoreTest, insertAndLookup) {
+    EA::EvaluationStore store(path);
+    std::string payload;
+    EXPECT_FALSE(store.lookup(42, payload));
+    store.insert(42, "forty-two");
+    store.insert(0, "");
+    ASSERT_TRUE(store.lookup(42, payload));
+    EXPECT_EQ(payload, "forty-two");
+    ASSERT_TRUE(store.lookup(0, payload));
+    EXPECT_EQ(payload, "");
+    EXPECT_EQ(store.size(), 2u);
+    EXPECT_EQ(store.hits(), 2u);
+    EXPECT_EQ(store.misses(), 1u);
+}
+
+TEST_F(EvaluationStoreTest, persistsAcrossInstances) {
+    {
+        EA::EvaluationStore store(path);
+        for (uint64_t k = 0; k < 3000; k++) store.insert_async(k, std::to_string(k * k));
+        store.flush();
+        EXPECT_EQ(store.size(), 3000u);
+    }
+    EA::EvaluationStore store(path);
+    std::string payload;
+    ASSERT_TRUE(store.lookup(1234, payload));
+    EXPECT_EQ(payload, std::to_string(1234 * 1234));
+    EXPECT_FALSE(store.lookup(3000, payload));
+}
+
+TEST_F(EvaluationStoreTest, sharedBetweenInstances) {
+    EA::EvaluationStore a(path);
+    EA::EvaluationStore b(path);
+    std::thread writer_a([&a]() {
+        for (uint64_t k = 0; k < 2000; k += 2) a.insert(k, "a");
+    });
+    std::thread writer_b([&b]() {
+        for (uint64_t k = 1; k < 2000; k += 2) b.insert(k, "b");
+    });
+    writer_a.join();
+    writer_b.join();
+    std::string payload;
+    ASSERT_TRUE(a.lookup(1999, payload));
+    EXPECT_EQ(payload, "b");
+    ASSERT_TRUE(b.lookup(1998, payload));
+    EXPECT_EQ(payload, "a");
+    EXPECT_EQ(a.size(), 2000u);
+}
+
+TEST_F(EvaluationStoreTest, concurrentLookupsDuringInsertions) {
+    EA::EvaluationStore store(path);
+    EA::EvaluationStore other(path); // grows the index under the readers
+    for (uint64_t k = 0; k < 100; k++) store.insert(k, std::to_string(k));
+    std::atomic<int> wrong(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++)
+        readers.push_back(std::thread([&store, &wrong]() {
+            std::string payload;
+            for (int round = 0; round < 20; round++)
+                for (uint64_t k = 0; k < 100; k++)
+                    if (!store.lookup(k, payload) || payload != std::to_string(k)) wrong++;
+        }));
+    for (uint64_t k = 100; k < 3000; k++) other.insert(k, "new");
+    for (std::thread& th : readers) th.join();
+    EXPECT_EQ(wrong, 0);
+    EXPECT_EQ(store.hits(), 8000u);
+    EXPECT_EQ(store.size(), 3000u);
+}
+
+TEST_F(EvaluationStoreTest, compactionKeepsNewest) {
+    const uint64_t limit = 4096;
+    EA::EvaluationStore store(path, limit, 0.5);
+    EA::EvaluationStore other(path);
+    const std::string payload(100, 'x');
+    for (uint64_t k = 0; k < 200; k++) store.insert(k, payload);
+    EXPECT_GT(store.compactions(), 0u);
+    EXPECT_LE(store.log_bytes(), limit);
+    std::string result;
+    EXPECT_TRUE(store.lookup(199, result));
+    EXPECT_FALSE(store.lookup(0, result));
+    EXPECT_TRUE(other.lookup(199, result)); // sees the compacted log
+    EXPECT_EQ(result, payload);
+}
+
+#endif
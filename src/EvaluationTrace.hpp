@@ -0,0 +1,176 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "BinaryCodec.hpp"
+#include "Definitions.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Evaluation trace file layout:
+ *
+ *   "OGAT" | record | record | ...
+ *
+ * record: [gene hash : 8 bytes][time in ns : varint]
+ *         [flags : 1 byte][payload : varint size, bytes]
+ * flags: 1 accepted, 2 payload is lz-compressed.
+ * The payload is the serialized middle costs. Records
+ * are appended in the order the evaluations finished,
+ * so a trace cut short by a crash stays readable up to
+ * its last complete record.
+ ****************************************************/
+const char trace_magic[] = "OGAT";
+
+// what the replay serves for genes which are not in the trace
+enum class TraceMiss {
+    Substitute, // the next record of the trace in recording order, keeps the production cost and time profile
+    Evaluate, // the attached eval_solution
+    Reject // the genes are rejected and redrawn
+};
+
+struct TraceRecord {
+    uint64_t key;
+    bool accepted;
+    bool compressed;
+    double seconds; // measured evaluation time
+    std::string payload;
+};
+
+// Appends evaluation records to a trace file. record() is thread safe.
+class EvaluationTraceWriter {
+    std::ofstream file;
+    std::mutex mtx;
+    unsigned long n_records;
+
+public:
+    explicit EvaluationTraceWriter(const std::string& path)
+        : file(path, std::ios::binary | std::ios::trunc)
+        , n_records(0) {
+        if (!file) throw std::runtime_error("Cannot open evaluation trace " + path);
+        file.write(trace_magic, 4);
+    }
+
+    void record(uint64_t key, bool accepted, const std::string& payload, double seconds) {
+        std::string out;
+        put_fixed64(out, key);
+        put_varint(out, uint64_t(std::llround(std::max(seconds, 0.0) * 1e9)));
+        std::string packed;
+        if (payload.size() > 64) lz_compress(payload, packed);
+        const bool compress = !packed.empty() && packed.size() < payload.size();
+        out.push_back(char((accepted ? 1 : 0) | (compress ? 2 : 0)));
+        put_bytes(out, compress ? packed : payload);
+        std::lock_guard<std::mutex> lock(mtx);
+        file.write(out.data(), std::streamsize(out.size()));
+        if (!file) throw std::runtime_error("Cannot write the evaluation trace");
+        n_records++;
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(mtx);
+        file.flush();
+    }
+
+    unsigned long size() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return n_records;
+    }
+};
+
+/****************************************************
+ * A recorded trace loaded for replay. find() returns
+ * the first record of a gene hash, substitute() hands
+ * out all records in recording order, starting over
+ * at the end. Both are thread safe.
+ ****************************************************/
+class EvaluationTrace {
+    std::vector<TraceRecord> records;
+    std::unordered_map<uint64_t, std::size_t> first_record;
+    std::atomic<unsigned long> next_substitute;
+    std::atomic<unsigned long> n_hits;
+    std::atomic<unsigned long> n_misses;
+
+public:
+    explicit EvaluationTrace(const std::string& path)
+        : next_substitute(0)
+        , n_hits(0)
+        , n_misses(0) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) throw std::runtime_error("Cannot open evaluation trace " + path);
+        const std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (bytes.size() < 4 || bytes.compare(0, 4, trace_magic, 4) != 0)
+            throw std::runtime_error("Not an evaluation trace: " + path);
+        const char* p = bytes.data() + 4;
+        const char* end = bytes.data() + bytes.size();
+        while (p < end) {
+            TraceRecord r;
+            try {
+                if (end - p < 8) throw std::runtime_error("Truncated trace record");
+                r.key = get_fixed64(p);
+                p += 8;
+                r.seconds = double(get_varint(p, end)) * 1e-9;
+                if (p >= end) throw std::runtime_error("Truncated trace record");
+                const unsigned char flags = (unsigned char)(*p++);
+                r.accepted = (flags & 1) != 0;
+                r.compressed = (flags & 2) != 0;
+                r.payload = get_bytes(p, end);
+            }
+            catch (const std::runtime_error&) {
+                break; // an incomplete last record, e.g. of a crashed run
+            }
+            first_record.emplace(r.key, records.size());
+            records.push_back(std::move(r));
+        }
+    }
+
+    std::size_t size() const { return records.size(); }
+
+    const TraceRecord& operator[](std::size_t i) const { return records[i]; }
+
+    // nullptr if the gene hash was not recorded
+    const TraceRecord* find(uint64_t key) {
+        auto it = first_record.find(key);
+        if (it == first_record.end()) {
+            n_misses++;
+            return nullptr;
+        }
+        n_hits++;
+        return &records[it->second];
+    }
+
+    const TraceRecord& substitute() {
+        if (records.empty()) throw std::runtime_error("The evaluation trace is empty.");
+        return records[next_substitute++ % records.size()];
+    }
+
+    // the serialized middle costs of a record
+    static std::string payload(const TraceRecord& r) {
+        if (!r.compressed) return r.payload;
+        std::string out;
+        lz_decompress(r.payload.data(), r.payload.data() + r.payload.size(), out);
+        return out;
+    }
+
+    // sum of the recorded evaluation times
+    double total_seconds() const {
+        double sum = 0.0;
+        for (const TraceRecord& r : records) sum += r.seconds;
+        return sum;
+    }
+
+    unsigned long hits() const { return n_hits; }
+    unsigned long misses() const { return n_misses; }
+};
+
+NS_EA_END
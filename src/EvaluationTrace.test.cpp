@@ -0,0 +1,73 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <EvaluationTrace.hpp>
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct EvaluationTraceTest : ::testing::Test {
+    void SetUp() override { path = ::testing::TempDir() + "openga_trace_test"; }
+    void TearDown() override { std::remove(path.c_str()); }
+
+    std::string path;
+};
+
+TEST_F(EvaluationTraceTest, recordAndReplay) {
+    const std::string large(1000, 'x'); // compressed
+    {
+        EA::EvaluationTraceWriter writer(path);
+        writer.record(1, true, "one", 0.25);
+        writer.record(2, false, "", 1e-6);
+        writer.record(3, true, large, 600.0);
+        writer.record(1, true, "again", 0.5);
+        EXPECT_EQ(writer.size(), 4u);
+    }
+    EA::EvaluationTrace trace(path);
+    ASSERT_EQ(trace.size(), 4u);
+    EXPECT_TRUE(trace[2].compressed);
+    EXPECT_LT(trace[2].payload.size(), large.size());
+    EXPECT_EQ(EA::EvaluationTrace::payload(trace[2]), large);
+    EXPECT_DOUBLE_EQ(trace[2].seconds, 600.0);
+    EXPECT_DOUBLE_EQ(trace.total_seconds(), 600.750001);
+
+    const EA::TraceRecord* r = trace.find(1);
+    ASSERT_NE(r, nullptr);
+    EXPECT_EQ(EA::EvaluationTrace::payload(*r), "one"); // the first record of a hash
+    r = trace.find(2);
+    ASSERT_NE(r, nullptr);
+    EXPECT_FALSE(r->accepted);
+    EXPECT_EQ(trace.find(4), nullptr);
+    EXPECT_EQ(trace.hits(), 2u);
+    EXPECT_EQ(trace.misses(), 1u);
+
+    for (uint64_t k : {1, 2, 3, 1, 1}) EXPECT_EQ(trace.substitute().key, k);
+}
+
+TEST_F(EvaluationTraceTest, concurrentWritersAndTruncatedTail) {
+    {
+        EA::EvaluationTraceWriter writer(path);
+        std::vector<std::thread> threads;
+        for (uint64_t t = 0; t < 4; t++)
+            threads.push_back(std::thread([&writer, t]() {
+                for (uint64_t i = 0; i < 100; i++) writer.record(t * 1000 + i, true, std::to_string(i), 0.001);
+            }));
+        for (std::thread& th : threads) th.join();
+    }
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file.write("\x07\x00\x00", 3); // a record cut short by a crash
+    }
+    EA::EvaluationTrace trace(path);
+    EXPECT_EQ(trace.size(), 400u);
+    const EA::TraceRecord* r = trace.find(3042);
+    ASSERT_NE(r, nullptr);
+    EXPECT_EQ(r->payload, "42");
+
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "not a trace";
+    }
+    EXPECT_THROW(EA::EvaluationTrace bad(path), std::runtime_error);
+}
@@ -0,0 +1,122 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "BinaryCodec.hpp"
+#include "Definitions.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+NS_EA_BEGIN
+
+struct DuplicateStats {
+    unsigned long detected = 0; // duplicates found, each one is re-mutated, rejected or accepted
+    unsigned long remutated = 0; // duplicates turned into new genes by mutation
+    unsigned long rejected = 0; // duplicates dropped and bred again
+    unsigned long accepted = 0; // duplicates evaluated after all retries failed
+
+    // duplicates which were not evaluated
+    unsigned long saved() const { return detected - accepted; }
+};
+
+/****************************************************
+ * Concurrent set of gene fingerprints. Every entry
+ * remembers the last generation it was seen in and
+ * expire() forgets entries older than a given window.
+ * The set is split into shards with their own locks so
+ * that worker threads rarely wait for each other.
+ ****************************************************/
+class FingerprintSet {
+    struct Shard {
+        std::mutex mtx;
+        std::unordered_map<uint64_t, int> last_seen;
+    };
+
+    static const unsigned int N_shards = 64;
+    std::vector<Shard> shards;
+
+public:
+    std::atomic<unsigned long> n_detected;
+    std::atomic<unsigned long> n_remutated;
+    std::atomic<unsigned long> n_rejected;
+    std::atomic<unsigned long> n_accepted;
+
+    FingerprintSet()
+        : shards(N_shards)
+        , n_detected(0)
+        , n_remutated(0)
+        , n_rejected(0)
+        , n_accepted(0) {}
+
+    // Returns true if the fingerprint was not known within the window.
+    bool insert(uint64_t fingerprint, int generation) {
+        Shard& shard = shard_of(fingerprint);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto it = shard.last_seen.find(fingerprint);
+        if (it == shard.last_seen.end()) {
+            shard.last_seen.emplace(fingerprint, generation);
+            return true;
+        }
+        if (it->second < generation) it->second = generation; // refresh
+        return false;
+    }
+
+    // Marks a fingerprint as seen without reporting duplicates (e.g. survivors).
+    void touch(uint64_t fingerprint, int generation) { insert(fingerprint, generation); }
+
+    bool contains(uint64_t fingerprint) {
+        Shard& shard = shard_of(fingerprint);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        return shard.last_seen.count(fingerprint) > 0;
+    }
+
+    // Forgets the fingerprints which were not seen since oldest_generation.
+    void expire(int oldest_generation) {
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            for (auto it = shard.last_seen.begin(); it != shard.last_seen.end();) {
+                if (it->second < oldest_generation)
+                    it = shard.last_seen.erase(it);
+                else
+                    ++it;
+            }
+        }
+    }
+
+    std::size_t size() {
+        std::size_t n = 0;
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            n += shard.last_seen.size();
+        }
+        return n;
+    }
+
+    void clear() {
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            shard.last_seen.clear();
+        }
+        n_detected = 0;
+        n_remutated = 0;
+        n_rejected = 0;
+        n_accepted = 0;
+    }
+
+    DuplicateStats stats() const {
+        DuplicateStats s;
+        s.detected = n_detected;
+        s.remutated = n_remutated;
+        s.rejected = n_rejected;
+        s.accepted = n_accepted;
+        return s;
+    }
+
+protected:
+    Shard& shard_of(uint64_t fingerprint) { return shards[hash_mix(fingerprint) % N_shards]; }
+};
+
+NS_EA_END
@@ -0,0 +1,40 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <FingerprintSet.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+TEST(FingerprintSetTest, insertReportsDuplicates) {
+    EA::FingerprintSet set;
+    EXPECT_TRUE(set.insert(7, 0));
+    EXPECT_FALSE(set.insert(7, 0));
+    EXPECT_FALSE(set.insert(7, 1));
+    EXPECT_TRUE(set.insert(8, 1));
+    EXPECT_EQ(set.size(), 2u);
+}
+
+TEST(FingerprintSetTest, expireForgetsOldGenerations) {
+    EA::FingerprintSet set;
+    set.insert(1, 0);
+    set.insert(2, 1);
+    set.touch(1, 3); // seen again as a survivor
+    set.insert(3, 2);
+    set.expire(2);
+    EXPECT_TRUE(set.contains(1));
+    EXPECT_FALSE(set.contains(2));
+    EXPECT_TRUE(set.contains(3));
+}
+
+TEST(FingerprintSetTest, concurrentInsertsAreUnique) {
+    EA::FingerprintSet set;
+    std::atomic<int> new_entries(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.push_back(std::thread([&set, &new_entries]() {
+            for (uint64_t k = 0; k < 1000; k++)
+                if (set.insert(k, 0)) new_entries++;
+        }));
+    for (std::thread& th : threads) th.join();
+    EXPECT_EQ(new_entries, 1000);
+    EXPECT_EQ(set.size(), 1000u);
+}
@@ -0,0 +1,368 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "Definitions.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+NS_EA_BEGIN
+
+class GeneStore;
+
+// A pinned gene payload. The memory stays mapped as long as the pin lives.
+class GenePin {
+    GeneStore* store;
+    std::size_t index;
+    char* ptr;
+    std::size_t length;
+
+public:
+    GenePin()
+        : store(nullptr)
+        , index(0)
+        , ptr(nullptr)
+        , length(0) {}
+
+    GenePin(GeneStore* store, std::size_t index, char* ptr, std::size_t length)
+        : store(store)
+        , index(index)
+        , ptr(ptr)
+        , length(length) {}
+
+    GenePin(GenePin&& other)
+        : GenePin() {
+        swap(other);
+    }
+
+    GenePin& operator=(GenePin&& other) {
+        GenePin(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    GenePin(const GenePin&) = delete;
+    GenePin& operator=(const GenePin&) = delete;
+
+    inline ~GenePin();
+
+    void swap(GenePin& other) {
+        std::swap(store, other.store);
+        std::swap(index, other.index);
+        std::swap(ptr, other.ptr);
+        std::swap(length, other.length);
+    }
+
+    char* data() { return ptr; }
+    const char* data() const { return ptr; }
+    std::size_t size() const { return length; }
+
+    template<typename T>
+    T* as() {
+        return reinterpret_cast<T*>(ptr);
+    }
+    template<typename T>
+    const T* as() const {
+        return reinterpret_cast<const T*>(ptr);
+    }
+};
+
+/****************************************************
+ * Handle to a gene payload kept in a GeneStore, to be
+ * used as (a part of) GeneType. Copies of a chromosome
+ * share the payload, so the generations held by the
+ * engine only cost a pointer per member. The slot is
+ * returned to the store when the last copy and the
+ * last pin of it are gone.
+ * A payload is written once, right after allocate(),
+ * and read-only afterwards.
+ ****************************************************/
+class StoredGenes {
+    struct Slot {
+        std::shared_ptr<GeneStore> store;
+        std::size_t index;
+
+        Slot(const std::shared_ptr<GeneStore>& store, std::size_t index)
+            : store(store)
+            , index(index) {}
+        inline ~Slot();
+    };
+
+    std::shared_ptr<Slot> slot;
+
+    friend class GeneStore;
+
+public:
+    bool empty() const { return !slot; }
+    std::size_t slot_index() const { return slot ? slot->index : std::size_t(-1); }
+
+    inline GenePin pin() const; // read access
+    inline GenePin pin_writable(); // only for freshly allocated genes
+    inline void prefetch() const; // hints that the genes are needed soon
+};
+
+/****************************************************
+ * Out-of-core storage of large gene payloads.
+ *
+ * All payloads have the same size and live in page
+ * aligned slots of a scratch file. A slot is mapped
+ * into memory while it is pinned and stays mapped
+ * afterwards as long as the residency budget allows.
+ * Beyond the budget, the least recently used unpinned
+ * slots are written back and unmapped. Pinned slots
+ * are never evicted, so the budget is exceeded if more
+ * payloads are pinned at once than it can hold.
+ *
+ * Create it with std::make_shared; the handles keep
+ * the store alive. The scratch file is removed when
+ * the store is destroyed (POSIX only).
+ ****************************************************/
+class GeneStore : public std::enable_shared_from_this<GeneStore> {
+    struct SlotState {
+        char* mapping = nullptr;
+        int pins = 0;
+        bool dirty = false;
+        bool in_use = false;
+        uint64_t last_use = 0;
+    };
+
+    std::string path;
+    std::size_t payload_bytes;
+    std::size_t stride; // payload_bytes rounded up to pages
+    std::size_t budget;
+
+    std::mutex mtx;
+    int fd;
+    std::vector<SlotState> slots;
+    std::vector<std::size_t> free_slots;
+    std::size_t file_slots;
+    std::size_t mapped;
+    std::size_t mapped_peak;
+    uint64_t clock;
+    unsigned long n_faults;
+    unsigned long n_evictions;
+    unsigned long n_prefetches;
+
+    friend class GenePin;
+    friend class StoredGenes;
+
+public:
+    GeneStore(const std::string& path, std::size_t payload_bytes, std::size_t residency_budget)
+        : path(path)
+        , payload_bytes(payload_bytes)
+        , stride(0)
+        , budget(residency_budget)
+        , fd(-1)
+        , file_slots(0)
+        , mapped(0)
+        , mapped_peak(0)
+        , clock(0)
+        , n_faults(0)
+        , n_evictions(0)
+        , n_prefetches(0) {
+#ifdef OPENGA_HAS_MMAP
+        if (payload_bytes == 0) throw std::runtime_error("Gene store payload size is zero.");
+        const std::size_t page = std::size_t(sysconf(_SC_PAGESIZE));
+        stride = (payload_bytes + page - 1) / page * page;
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throw std::runtime_error("Cannot open gene store " + path);
+#else
+        throw std::runtime_error("GeneStore requires a POSIX platform.");
+#endif
+    }
+
+    GeneStore(const GeneStore&) = delete;
+    GeneStore& operator=(const GeneStore&) = delete;
+
+    ~GeneStore() {
+#ifdef OPENGA_HAS_MMAP
+        for (SlotState& s : slots)
+            if (s.mapping) munmap(s.mapping, stride);
+        if (fd >= 0) ::close(fd);
+        std::remove(path.c_str());
+#endif
+    }
+
+    // A new payload. Its content is undefined until written through pin_writable().
+    StoredGenes allocate() {
+        std::size_t index;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!free_slots.empty()) {
+                index = free_slots.back();
+                free_slots.pop_back();
+            }
+            else {
+                index = slots.size();
+                slots.push_back(SlotState());
+                grow_file(slots.size());
+            }
+            slots[index].in_use = true;
+        }
+        StoredGenes genes;
+        genes.slot = std::make_shared<StoredGenes::Slot>(shared_from_this(), index);
+        return genes;
+    }
+
+    std::size_t payload_size() const { return payload_bytes; }
+    std::size_t residency_budget() const { return budget; }
+
+    std::size_t slots_in_use() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return slots.size() - free_slots.size();
+    }
+
+    std::size_t resident_bytes() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return mapped;
+    }
+
+    std::size_t resident_peak() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return mapped_peak;
+    }
+
+    unsigned long faults() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return n_faults;
+    }
+
+    unsigned long evictions() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return n_evictions;
+    }
+
+    unsigned long prefetches() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return n_prefetches;
+    }
+
+protected:
+    char* pin(std::size_t index, bool writable) {
+        std::lock_guard<std::mutex> lock(mtx);
+        SlotState& s = slots[index];
+#ifdef OPENGA_HAS_MMAP
+        if (!s.mapping) {
+            void* p = mmap(nullptr, stride, PROT_READ | PROT_WRITE, MAP_SHARED, fd, off_t(index * stride));
+            if (p == MAP_FAILED) throw std::runtime_error("Cannot map gene store " + path);
+            s.mapping = static_cast<char*>(p);
+            mapped += stride;
+            n_faults++;
+        }
+#endif
+        s.pins++;
+        s.last_use = ++clock;
+        if (writable) s.dirty = true;
+        enforce_budget();
+        if (mapped > mapped_peak) mapped_peak = mapped;
+        return s.mapping;
+    }
+
+    void unpin(std::size_t index) {
+        std::lock_guard<std::mutex> lock(mtx);
+        SlotState& s = slots[index];
+        if (--s.pins == 0 && !s.in_use) free_slot(index); // released while it was pinned
+        enforce_budget();
+    }
+
+    void prefetch(std::size_t index) {
+        std::lock_guard<std::mutex> lock(mtx);
+        n_prefetches++;
+#ifdef OPENGA_HAS_MMAP
+        SlotState& s = slots[index];
+        if (s.mapping)
+            madvise(s.mapping, stride, MADV_WILLNEED);
+        else {
+#    ifdef POSIX_FADV_WILLNEED
+            posix_fadvise(fd, off_t(index * stride), off_t(stride), POSIX_FADV_WILLNEED); // asynchronous read-ahead
+#    endif
+        }
+#else
+        (void)index;
+#endif
+    }
+
+    // a pinned slot is only reused after its last pin is gone, so the pin keeps reading its genes
+    void release(std::size_t index) {
+        std::lock_guard<std::mutex> lock(mtx);
+        SlotState& s = slots[index];
+        s.dirty = false; // the content is dead, nothing to write back
+        s.in_use = false;
+        if (s.pins == 0) free_slot(index);
+    }
+
+    void free_slot(std::size_t index) {
+        if (slots[index].mapping) unmap(index);
+        free_slots.push_back(index);
+    }
+
+    void grow_file(std::size_t needed_slots) {
+        if (needed_slots <= file_slots) return;
+        std::size_t new_slots = std::max<std::size_t>(needed_slots, file_slots * 2);
+#ifdef OPENGA_HAS_MMAP
+        if (ftruncate(fd, off_t(new_slots * stride)) != 0) throw std::runtime_error("Cannot grow gene store " + path);
+#endif
+        file_slots = new_slots;
+    }
+
+    // Unmaps the least recently used unpinned slots until the budget is kept.
+    void enforce_budget() {
+        while (mapped > budget) {
+            std::size_t victim = slots.size();
+            for (std::size_t i = 0; i < slots.size(); i++) {
+                const SlotState& s = slots[i];
+                if (s.mapping && s.pins == 0 && (victim == slots.size() || s.last_use < slots[victim].last_use))
+                    victim = i;
+            }
+            if (victim == slots.size()) return; // everything is pinned
+            unmap(victim);
+            n_evictions++;
+        }
+    }
+
+    void unmap(std::size_t index) {
+        SlotState& s = slots[index];
+#ifdef OPENGA_HAS_MMAP
+        if (s.dirty) msync(s.mapping, stride, MS_SYNC); // clean pages can be dropped from the page cache
+        munmap(s.mapping, stride);
+#    ifdef POSIX_FADV_DONTNEED
+        posix_fadvise(fd, off_t(index * stride), off_t(stride), POSIX_FADV_DONTNEED);
+#    endif
+#endif
+        s.mapping = nullptr;
+        s.dirty = false;
+        mapped -= stride;
+    }
+};
+
+GenePin::~GenePin() {
+    if (store) store->unpin(index);
+}
+
+StoredGenes::Slot::~Slot() { store->release(index); }
+
+GenePin StoredGenes::pin() const {
+    if (!slot) throw std::runtime_error("Pinning empty genes.");
+    GeneStore* store = slot->store.get();
+    return GenePin(store, slot->index, store->pin(slot->index, false), store->payload_bytes);
+}
+
+GenePin StoredGenes::pin_writable() {
+    if (!slot) throw std::runtime_error("Pinning empty genes.");
+    GeneStore* store = slot->store.get();
+    return GenePin(store, slot->index, store->pin(slot->index, true), store->payload_bytes);
+}
+
+void StoredGenes::prefetch() const {
+    if (slot) slot->store->prefetch(slot->index);
+}
+
+NS_EA_END
@@ -0,0 +1,128 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <GeneStore.hpp>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef OPENGA_HAS_MMAP
+
+namespace {
+
+const std::size_t N_values = 5000; // 40000 bytes, ten pages per payload
+
+EA::StoredGenes make_genes(EA::GeneStore& store, double value) {
+    EA::StoredGenes genes = store.allocate();
+    EA::GenePin pin = genes.pin_writable();
+    double* x = pin.as<double>();
+    for (std::size_t i = 0; i < N_values; i++) x[i] = value + double(i);
+    return genes;
+}
+
+bool holds(const EA::StoredGenes& genes, double value) {
+    EA::GenePin pin = genes.pin();
+    const double* x = pin.as<double>();
+    for (std::size_t i = 0; i < N_values; i++)
+        if (x[i] != value + double(i)) return false;
+    return true;
+}
+
+} // namespace
+
+struct GeneStoreTest : ::testing::Test {
+    std::string path = ::testing::TempDir() + "openga_gene_store_test";
+};
+
+TEST_F(GeneStoreTest, payloadsSurviveEviction) {
+    const std::size_t budget = 4 * 40960;
+    auto store = std::make_shared<EA::GeneStore>(path, N_values * sizeof(double), budget);
+    std::vector<EA::StoredGenes> population;
+    for (int i = 0; i < 50; i++) population.push_back(make_genes(*store, i * 1e6));
+    EXPECT_LE(store->resident_bytes(), budget);
+    EXPECT_LE(store->resident_peak(), budget);
+    EXPECT_GT(store->evictions(), 0u);
+    for (int i = 0; i < 50; i++) EXPECT_TRUE(holds(population[i], i * 1e6));
+    EXPECT_LE(store->resident_bytes(), budget);
+}
+
+TEST_F(GeneStoreTest, copiesShareTheSlot) {
+    auto store = std::make_shared<EA::GeneStore>(path, N_values * sizeof(double), 1 << 20);
+    {
+        EA::StoredGenes a = make_genes(*store, 1.0);
+        EA::StoredGenes b = a;
+        EXPECT_EQ(a.slot_index(), b.slot_index());
+        EXPECT_EQ(store->slots_in_use(), 1u);
+        a = make_genes(*store, 2.0);
+        EXPECT_EQ(store->slots_in_use(), 2u);
+        EXPECT_TRUE(holds(b, 1.0));
+    }
+    EXPECT_EQ(store->slots_in_use(), 0u);
+    EXPECT_EQ(store->resident_bytes(), 0u);
+    // released slots are reused
+    EA::StoredGenes c = make_genes(*store, 3.0);
+    EXPECT_LT(c.slot_index(), 2u);
+}
+
+TEST_F(GeneStoreTest, pinnedSlotsAreNotEvicted) {
+    auto store = std::make_shared<EA::GeneStore>(path, N_values * sizeof(double), 0);
+    EA::StoredGenes a = make_genes(*store, 1.0);
+    EA::StoredGenes b = make_genes(*store, 2.0);
+    EXPECT_EQ(store->resident_bytes(), 0u);
+    {
+        EA::GenePin pa = a.pin();
+        EA::GenePin pb = b.pin();
+        EXPECT_EQ(store->resident_bytes(), 2 * 40960u);
+        EXPECT_EQ(pa.as<double>()[7], 8.0);
+        EXPECT_EQ(pb.as<double>()[7], 9.0);
+    }
+    EXPECT_EQ(store->resident_bytes(), 0u);
+    a.prefetch();
+    EXPECT_EQ(store->prefetches(), 1u);
+}
+
+TEST_F(GeneStoreTest, pinnedSlotsAreReusedAfterTheLastPin) {
+    auto store = std::make_shared<EA::GeneStore>(path, N_values * sizeof(double), 1 << 20);
+    EA::StoredGenes a = make_genes(*store, 1.0);
+    const std::size_t slot = a.slot_index();
+    {
+        EA::GenePin pin = a.pin();
+        a = EA::StoredGenes(); // the last copy is gone while the pin still reads the genes
+        EXPECT_EQ(store->slots_in_use(), 1u);
+        EA::StoredGenes b = make_genes(*store, 2.0);
+        EXPECT_NE(b.slot_index(), slot);
+        EXPECT_EQ(pin.as<double>()[7], 8.0);
+        EXPECT_TRUE(holds(b, 2.0));
+    }
+    EXPECT_EQ(store->slots_in_use(), 0u);
+    EXPECT_EQ(store->resident_bytes(), 0u);
+    EA::StoredGenes c = make_genes(*store, 3.0);
+    EXPECT_LT(c.slot_index(), 2u);
+}
+
+TEST_F(GeneStoreTest, concurrentWorkers) {
+    auto store = std::make_shared<EA::GeneStore>(path, N_values * sizeof(double), 8 * 40960);
+    std::vector<EA::StoredGenes> parents;
+    for (int i = 0; i < 16; i++) parents.push_back(make_genes(*store, i));
+    std::vector<EA::StoredGenes> offspring(64);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.push_back(std::thread([&, t]() {
+            for (int i = t; i < 64; i += 4) {
+                const EA::StoredGenes& p1 = parents[i % 16];
+                EA::StoredGenes child = store->allocate();
+                {
+                    EA::GenePin in = p1.pin();
+                    EA::GenePin out = child.pin_writable();
+                    for (std::size_t k = 0; k < N_values; k++) out.as<double>()[k] = in.as<double>()[k] + 100.0;
+                }
+                offspring[i] = child;
+            }
+        }));
+    }
+    for (std::thread& th : workers) th.join();
+    for (int i = 0; i < 64; i++) EXPECT_TRUE(holds(offspring[i], (i % 16) + 100.0));
+    EXPECT_EQ(store->slots_in_use(), 80u);
+}
+
+#endif
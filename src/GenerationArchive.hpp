@@ -0,0 +1,164 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "Definitions.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Immutable snapshot of a generation. The members are
+ * reference counted and shared with the snapshots of
+ * the earlier generations for as long as they survive
+ * unchanged, so a snapshot itself only holds its new
+ * members and the index lists.
+ ****************************************************/
+template<typename GenerationT>
+struct GenerationSnapshot {
+    using ChromosomeT = typename GenerationT::ThisChromosomeType;
+
+    int generation_step = 0;
+    std::vector<std::shared_ptr<const ChromosomeT>> chromosomes;
+    double best_total_cost = 0.0; // for single objective
+    double average_cost = 0.0; // for single objective
+    int best_chromosome_index = -1; // for single objective
+    std::vector<int> sorted_indices; // for single objective
+    std::vector<std::vector<unsigned int>> fronts; // for multi-objective
+    double exe_time = 0.0;
+    unsigned int N_new = 0; // members which are not shared with the previous snapshot
+
+    std::size_t size() const { return chromosomes.size(); }
+
+    const ChromosomeT& operator[](std::size_t i) const { return *chromosomes[i]; }
+
+    // deep copy in the form of the engine, e.g. for code written against GenerationType
+    GenerationT materialize() const {
+        GenerationT g;
+        for (const std::shared_ptr<const ChromosomeT>& x : chromosomes) g.chromosomes.push_back(*x);
+        g.best_total_cost = best_total_cost;
+        g.average_cost = average_cost;
+        g.best_chromosome_index = best_chromosome_index;
+        g.sorted_indices = sorted_indices;
+        g.fronts = fronts;
+        g.exe_time = exe_time;
+        return g;
+    }
+};
+
+/****************************************************
+ * History of generation snapshots. A member of the
+ * appended generation is shared with the previous
+ * snapshot if it has the same serial (see
+ * ChromosomeType::serial) and the same costs; members
+ * whose costs have changed, e.g. by further noisy
+ * replications, are stored again. The memory then
+ * grows with the number of offspring rather than with
+ * population times generations. Snapshots may be read
+ * from other threads while the run goes on.
+ ****************************************************/
+template<typename GenerationT>
+class GenerationArchive {
+public:
+    using Snapshot = GenerationSnapshot<GenerationT>;
+    using ChromosomeT = typename Snapshot::ChromosomeT;
+
+private:
+    mutable std::mutex mtx;
+    std::vector<std::shared_ptr<const Snapshot>> snapshots;
+    std::unordered_map<uint64_t, std::shared_ptr<const ChromosomeT>> previous; // members of the last snapshot
+    unsigned long n_shared;
+    unsigned long n_stored;
+
+public:
+    GenerationArchive()
+        : n_shared(0)
+        , n_stored(0) {}
+
+    void append(int generation_step, const GenerationT& g) {
+        std::shared_ptr<Snapshot> s = std::make_shared<Snapshot>();
+        s->generation_step = generation_step;
+        s->best_total_cost = g.best_total_cost;
+        s->average_cost = g.average_cost;
+        s->best_chromosome_index = g.best_chromosome_index;
+        s->sorted_indices = g.sorted_indices;
+        s->fronts = g.fronts;
+        s->exe_time = g.exe_time;
+        std::unordered_map<uint64_t, std::shared_ptr<const ChromosomeT>> current;
+        s->chromosomes.reserve(g.chromosomes.size());
+        for (const ChromosomeT& x : g.chromosomes) {
+            std::shared_ptr<const ChromosomeT> member;
+            auto it = x.serial ? previous.find(x.serial) : previous.end();
+            if (it != previous.end() && same_costs(*it->second, x))
+                member = it->second;
+            else {
+                member = std::make_shared<const ChromosomeT>(x);
+                s->N_new++;
+            }
+            if (x.serial) current[x.serial] = member;
+            s->chromosomes.push_back(member);
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        previous.swap(current);
+        n_stored += s->N_new;
+        n_shared += s->chromosomes.size() - s->N_new;
+        snapshots.push_back(s);
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return snapshots.size();
+    }
+
+    std::shared_ptr<const Snapshot> at(std::size_t i) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (i >= snapshots.size()) throw std::runtime_error("Generation snapshot out of range.");
+        return snapshots[i];
+    }
+
+    // the last snapshot of the given generation step, nullptr if there is none
+    std::shared_ptr<const Snapshot> find_generation(int generation_step) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (std::size_t i = snapshots.size(); i-- > 0;)
+            if (snapshots[i]->generation_step == generation_step) return snapshots[i];
+        return nullptr;
+    }
+
+    // member references that point to an earlier copy
+    unsigned long shared_members() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return n_shared;
+    }
+
+    // members copied into the archive
+    unsigned long stored_members() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return n_stored;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mtx);
+        snapshots.clear();
+        previous.clear();
+        n_shared = 0;
+        n_stored = 0;
+    }
+
+private:
+    // bitwise, so that unset (NaN) costs of copies compare equal
+    static bool same_costs(const ChromosomeT& a, const ChromosomeT& b) {
+        if (std::memcmp(&a.total_cost, &b.total_cost, sizeof(double)) != 0) return false;
+        if (a.objectives.size() != b.objectives.size()) return false;
+        return a.objectives.empty() ||
+            std::memcmp(a.objectives.data(), b.objectives.data(), a.objectives.size() * sizeof(double)) == 0;
+    }
+};
+
+NS_EA_END
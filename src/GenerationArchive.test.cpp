@@ -0,0 +1,89 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <GenerationArchive.hpp>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Member {
+    std::string genes;
+    double total_cost = 0.0;
+    std::vector<double> objectives;
+    uint64_t serial = 0;
+};
+
+struct Generation {
+    using ThisChromosomeType = Member;
+    std::vector<Member> chromosomes;
+    double best_total_cost = 0.0;
+    double average_cost = 0.0;
+    int best_chromosome_index = -1;
+    std::vector<int> sorted_indices;
+    std::vector<std::vector<unsigned int>> fronts;
+    double exe_time = 0.0;
+};
+
+Member member(uint64_t serial, double cost) {
+    Member x;
+    x.genes = "member " + std::to_string(serial);
+    x.total_cost = cost;
+    x.serial = serial;
+    return x;
+}
+
+} // namespace
+
+TEST(GenerationArchiveTest, survivorsAreShared) {
+    EA::GenerationArchive<Generation> archive;
+    Generation g;
+    for (uint64_t i = 1; i <= 4; i++) g.chromosomes.push_back(member(i, double(i)));
+    g.sorted_indices = {0, 1, 2, 3};
+    archive.append(0, g);
+
+    g.chromosomes[3] = member(5, 0.5); // offspring replaces the worst
+    g.chromosomes[1].total_cost = 1.5; // re-evaluated survivor
+    g.sorted_indices = {3, 0, 1, 2};
+    archive.append(1, g);
+
+    ASSERT_EQ(archive.size(), 2u);
+    std::shared_ptr<const EA::GenerationSnapshot<Generation>> s0 = archive.at(0), s1 = archive.at(1);
+    EXPECT_EQ(s0->N_new, 4u);
+    EXPECT_EQ(s1->N_new, 2u);
+    EXPECT_EQ(s1->chromosomes[0], s0->chromosomes[0]);
+    EXPECT_EQ(s1->chromosomes[2], s0->chromosomes[2]);
+    EXPECT_NE(s1->chromosomes[1], s0->chromosomes[1]);
+    EXPECT_EQ((*s0)[1].total_cost, 2.0); // earlier snapshots are immutable
+    EXPECT_EQ((*s1)[1].total_cost, 1.5);
+    EXPECT_EQ((*s1)[3].genes, "member 5");
+    EXPECT_EQ(s1->sorted_indices, (std::vector<int>{3, 0, 1, 2}));
+    EXPECT_EQ(archive.stored_members(), 6u);
+    EXPECT_EQ(archive.shared_members(), 2u);
+
+    Generation copy = s1->materialize();
+    ASSERT_EQ(copy.chromosomes.size(), 4u);
+    EXPECT_EQ(copy.chromosomes[3].total_cost, 0.5);
+    EXPECT_EQ(archive.find_generation(1), s1);
+    EXPECT_EQ(archive.find_generation(7), nullptr);
+    EXPECT_THROW(archive.at(2), std::runtime_error);
+}
+
+TEST(GenerationArchiveTest, membersWithoutSerialAreStored) {
+    EA::GenerationArchive<Generation> archive;
+    Generation g;
+    g.chromosomes.assign(3, member(0, 1.0));
+    archive.append(0, g);
+    archive.append(1, g);
+    EXPECT_EQ(archive.stored_members(), 6u);
+
+    // a member which skips a generation is stored again
+    g.chromosomes = {member(1, 1.0)};
+    archive.append(2, g);
+    g.chromosomes = {member(2, 1.0)};
+    archive.append(3, g);
+    g.chromosomes = {member(1, 1.0)};
+    archive.append(4, g);
+    EXPECT_EQ(archive.at(4)->N_new, 1u);
+    archive.clear();
+    EXPECT_EQ(archive.size(), 0u);
+}
@@ -0,0 +1,89 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "BulkRandom.hpp"
+#include "Definitions.hpp"
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Langevin step on real genes:
+ *   out = x - step*gradient + sqrt(2*step*temperature)*N(0,1)
+ * With temperature 0 it is a plain gradient descent
+ * step, larger temperatures mix in more exploration.
+ * out may alias x.
+ ****************************************************/
+inline void langevin_step(
+    const double* x,
+    const double* gradient,
+    std::size_t n,
+    double step,
+    double temperature,
+    BulkRandom& rng,
+    double* out) {
+    const double sigma = std::sqrt(2.0 * step * std::max(temperature, 0.0));
+    const std::size_t N_block = 64;
+    double noise[N_block];
+    for (std::size_t i = 0; i < n; i += N_block) {
+        const std::size_t m = std::min(N_block, n - i);
+        if (sigma > 0.0)
+            rng.normal(noise, m, 0.0, sigma);
+        else
+            for (std::size_t j = 0; j < m; j++) noise[j] = 0.0;
+        for (std::size_t j = 0; j < m; j++) out[i + j] = x[i + j] - step * gradient[i + j] + noise[j];
+    }
+}
+
+inline std::vector<double> langevin_step(
+    const std::vector<double>& x,
+    const std::vector<double>& gradient,
+    double step,
+    double temperature,
+    BulkRandom& rng) {
+    std::vector<double> out(x.size());
+    langevin_step(x.data(), gradient.data(), x.size(), step, temperature, rng, out.data());
+    return out;
+}
+
+/****************************************************
+ * Backtracking line search along the negative
+ * gradient. Starting with `step`, the step is halved
+ * until the Armijo condition
+ *   cost(x - step*g) <= cost_x - armijo*step*|g|^2
+ * holds or max_halvings steps have been tried. The
+ * accepted point is written to out and its cost is
+ * returned. If no step is accepted, out is x and
+ * cost_x is returned. cost(const vector<double>&) is
+ * called once per tried step.
+ ****************************************************/
+template<typename Cost>
+double line_search_step(
+    const std::vector<double>& x,
+    double cost_x,
+    const std::vector<double>& gradient,
+    double step,
+    Cost cost,
+    std::vector<double>& out,
+    unsigned int max_halvings = 10,
+    double armijo = 1e-4) {
+    double g2 = 0.0;
+    for (double gi : gradient) g2 += gi * gi;
+    out = x;
+    if (g2 <= 0.0) return cost_x;
+    std::vector<double> trial(x.size());
+    for (unsigned int k = 0; k <= max_halvings; k++, step *= 0.5) {
+        for (std::size_t i = 0; i < x.size(); i++) trial[i] = x[i] - step * gradient[i];
+        const double cost_trial = cost(trial);
+        if (cost_trial <= cost_x - armijo * step * g2) {
+            out.swap(trial);
+            return cost_trial;
+        }
+    }
+    return cost_x;
+}
+
+NS_EA_END
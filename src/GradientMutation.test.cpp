@@ -0,0 +1,59 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <GradientMutation.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+double sphere(const std::vector<double>& x) {
+    double s = 0.0;
+    for (double v : x) s += v * v;
+    return s;
+}
+
+std::vector<double> sphere_gradient(const std::vector<double>& x) {
+    std::vector<double> g(x.size());
+    for (std::size_t i = 0; i < x.size(); i++) g[i] = 2.0 * x[i];
+    return g;
+}
+
+} // namespace
+
+TEST(GradientMutationTest, langevinWithoutTemperatureDescends) {
+    EA::BulkRandom rng(1);
+    std::vector<double> x = {1.0, -2.0, 3.0};
+    std::vector<double> y = EA::langevin_step(x, sphere_gradient(x), 0.25, 0.0, rng);
+    EXPECT_EQ(y, (std::vector<double>{0.5, -1.0, 1.5}));
+}
+
+TEST(GradientMutationTest, langevinNoise) {
+    EA::BulkRandom rng(2);
+    const std::size_t n = 20000;
+    std::vector<double> x(n, 1.0), g(n, 2.0), y(n);
+    EA::langevin_step(x.data(), g.data(), n, 0.1, 0.5, rng, y.data());
+    double mean = 0.0, var = 0.0;
+    for (double v : y) mean += v / double(n);
+    for (double v : y) var += (v - mean) * (v - mean) / double(n - 1);
+    EXPECT_NEAR(mean, 0.8, 0.01);
+    EXPECT_NEAR(var, 2.0 * 0.1 * 0.5, 0.005);
+}
+
+TEST(GradientMutationTest, lineSearch) {
+    std::vector<double> x = {1.0, -1.0}, out;
+    unsigned int calls = 0;
+    auto cost = [&calls](const std::vector<double>& v) {
+        calls++;
+        return sphere(v);
+    };
+    // steps 4, 2 and 1 do not decrease the cost enough, 0.5 lands in the minimum
+    double c = EA::line_search_step(x, sphere(x), sphere_gradient(x), 4.0, cost, out);
+    EXPECT_LT(c, sphere(x));
+    EXPECT_DOUBLE_EQ(c, sphere(out));
+    EXPECT_EQ(out, (std::vector<double>{0.0, 0.0}));
+    EXPECT_EQ(calls, 4u);
+
+    // no descent direction
+    std::vector<double> zero(2, 0.0);
+    EXPECT_EQ(EA::line_search_step(x, 2.0, zero, 1.0, cost, out), 2.0);
+    EXPECT_EQ(out, x);
+}
@@ -0,0 +1,157 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "Definitions.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Shared state of the non-blocking interactive mode.
+ * The engine publishes the candidates of the current
+ * generation one by one as soon as they are prepared
+ * and the user interface rates them in any order from
+ * any thread. Candidates bred speculatively for the
+ * next generation while the user is rating are kept
+ * in a separate pool.
+ ****************************************************/
+template<typename ChromosomeT>
+class IGAPipeline {
+    mutable std::mutex mtx;
+    std::mutex present_mtx; // serializes the user interface callback
+    std::condition_variable cv;
+    std::vector<bool> ready;
+    std::vector<bool> rated;
+    std::vector<double> ratings;
+    unsigned int n_rated;
+    std::vector<ChromosomeT> speculative;
+    std::size_t n_reserved; // speculative slots taken by a speculator which is still breeding
+    unsigned long n_speculative_used;
+
+public:
+    std::function<void(unsigned int, const ChromosomeT&)> present;
+
+    IGAPipeline()
+        : n_rated(0)
+        , n_reserved(0)
+        , n_speculative_used(0)
+        , present(nullptr) {}
+
+    void begin_batch(unsigned int size) {
+        std::lock_guard<std::mutex> lock(mtx);
+        ready.assign(size, false);
+        rated.assign(size, false);
+        ratings.assign(size, 0.0);
+        n_rated = 0;
+    }
+
+    unsigned int batch_size() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return (unsigned int)ready.size();
+    }
+
+    // Marks a candidate as ready and hands it to the user interface.
+    void publish(unsigned int index, const ChromosomeT& candidate) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (index >= ready.size()) throw std::runtime_error("IGA candidate index out of range.");
+            ready[index] = true;
+        }
+        std::lock_guard<std::mutex> lock(present_mtx);
+        if (present) present(index, candidate);
+    }
+
+    // Returns false if the candidate is unknown or not published yet.
+    bool rate(unsigned int index, double total_cost) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (index >= ready.size() || !ready[index]) return false;
+            if (!rated[index]) n_rated++;
+            rated[index] = true;
+            ratings[index] = total_cost;
+        }
+        cv.notify_all();
+        return true;
+    }
+
+    bool all_rated() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return n_rated == rated.size();
+    }
+
+    // Waits until all candidates are rated or the timeout (in microseconds) passes.
+    bool wait_all_rated(long timeout_us) {
+        std::unique_lock<std::mutex> lock(mtx);
+        return cv.wait_for(lock, std::chrono::microseconds(timeout_us), [this]() { return n_rated == rated.size(); });
+    }
+
+    /****************************************************
+     * Costs known so far. Unrated candidates get the
+     * average of the given ratings, which lets the engine
+     * rank the population before the user has finished.
+     ****************************************************/
+    void provisional_costs(std::vector<double>& costs) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        double sum = 0.0;
+        for (std::size_t i = 0; i < ratings.size(); i++)
+            if (rated[i]) sum += ratings[i];
+        double average = n_rated ? sum / double(n_rated) : 0.0;
+        costs.resize(ratings.size());
+        for (std::size_t i = 0; i < ratings.size(); i++) costs[i] = rated[i] ? ratings[i] : average;
+    }
+
+    // Takes a slot of the speculative pool, false if the pool would grow beyond limit.
+    bool reserve_speculative(std::size_t limit) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (speculative.size() + n_reserved >= limit) return false;
+        n_reserved++;
+        return true;
+    }
+
+    // Gives a reserved slot back unfilled.
+    void release_speculative() {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (n_reserved > 0) n_reserved--;
+    }
+
+    // Fills a slot taken by reserve_speculative.
+    void push_speculative(const ChromosomeT& candidate) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (n_reserved > 0) n_reserved--;
+        speculative.push_back(candidate);
+    }
+
+    bool pop_speculative(ChromosomeT& candidate) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (speculative.empty()) return false;
+        candidate = speculative.back();
+        speculative.pop_back();
+        n_speculative_used++;
+        return true;
+    }
+
+    std::size_t speculative_count() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return speculative.size();
+    }
+
+    void clear_speculative() {
+        std::lock_guard<std::mutex> lock(mtx);
+        speculative.clear();
+    }
+
+    // number of speculative candidates which made it into a generation
+    unsigned long speculative_used() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return n_speculative_used;
+    }
+};
+
+NS_EA_END
@@ -0,0 +1,117 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <IGAPipeline.hpp>
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Candidate {
+    unsigned int id;
+};
+
+using Pipeline = EA::IGAPipeline<Candidate>;
+
+} // namespace
+
+TEST(IGAPipelineTest, ratingsFromAnotherThreadInAnyOrder) {
+    Pipeline pipeline;
+    std::vector<unsigned int> presented;
+    pipeline.present = [&presented](unsigned int index, const Candidate& c) {
+        EXPECT_EQ(c.id, 10 + index);
+        presented.push_back(index);
+    };
+    pipeline.begin_batch(8);
+    EXPECT_FALSE(pipeline.rate(3, 1.0)); // not published yet
+    for (unsigned int i = 0; i < 8; i++) pipeline.publish(i, Candidate{10 + i});
+    EXPECT_EQ(presented.size(), 8u);
+    EXPECT_FALSE(pipeline.rate(8, 1.0));
+
+    std::thread user([&pipeline]() {
+        const unsigned int order[8] = {5, 2, 7, 0, 3, 6, 1, 4};
+        for (unsigned int i : order) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            EXPECT_TRUE(pipeline.rate(i, double(i) * 0.5));
+        }
+    });
+    while (!pipeline.wait_all_rated(100)) {
+    }
+    user.join();
+    EXPECT_TRUE(pipeline.all_rated());
+    std::vector<double> costs;
+    pipeline.provisional_costs(costs);
+    ASSERT_EQ(costs.size(), 8u);
+    for (unsigned int i = 0; i < 8; i++) EXPECT_DOUBLE_EQ(costs[i], double(i) * 0.5);
+}
+
+TEST(IGAPipelineTest, unratedCandidatesGetTheAverageRating) {
+    Pipeline pipeline;
+    pipeline.begin_batch(4);
+    for (unsigned int i = 0; i < 4; i++) pipeline.publish(i, Candidate{i});
+    std::vector<double> costs;
+    pipeline.provisional_costs(costs);
+    EXPECT_EQ(costs, std::vector<double>(4, 0.0));
+
+    EXPECT_TRUE(pipeline.rate(2, 1.0));
+    EXPECT_TRUE(pipeline.rate(0, 5.0));
+    EXPECT_TRUE(pipeline.rate(0, 3.0)); // a new rating replaces the old one
+    pipeline.provisional_costs(costs);
+    EXPECT_EQ(costs, (std::vector<double>{3.0, 2.0, 1.0, 2.0}));
+    EXPECT_FALSE(pipeline.all_rated());
+    EXPECT_FALSE(pipeline.wait_all_rated(100));
+}
+
+TEST(IGAPipelineTest, speculativePoolNeverExceedsTheLimit) {
+    Pipeline pipeline;
+    const std::size_t limit = 3;
+    std::atomic<int> held(0); // reserved or waiting in the pool
+    std::atomic<bool> exceeded(false);
+    std::atomic<bool> done(false);
+    std::vector<std::thread> speculators;
+    for (unsigned int t = 0; t < 6; t++) {
+        speculators.push_back(std::thread([&, t]() {
+            for (unsigned int k = 0; k < 200; k++) {
+                if (!pipeline.reserve_speculative(limit)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (++held > int(limit)) exceeded = true;
+                if ((t + k) % 3 == 0) {
+                    held--;
+                    pipeline.release_speculative();
+                }
+                else {
+                    pipeline.push_speculative(Candidate{t * 1000 + k});
+                }
+            }
+        }));
+    }
+    unsigned long used = 0;
+    std::thread next_generation([&]() {
+        Candidate c;
+        while (!done) {
+            // held is decremented first, so that it never counts more than the pipeline holds
+            if (pipeline.speculative_count() > 0) {
+                held--;
+                EXPECT_TRUE(pipeline.pop_speculative(c));
+                used++;
+            }
+            EXPECT_LE(pipeline.speculative_count(), limit);
+        }
+    });
+    for (std::thread& th : speculators) th.join();
+    done = true;
+    next_generation.join();
+    EXPECT_FALSE(exceeded);
+    EXPECT_LE(pipeline.speculative_count(), limit);
+    EXPECT_EQ(pipeline.speculative_used(), used);
+    EXPECT_GT(used, 0u);
+
+    pipeline.clear_speculative();
+    EXPECT_EQ(pipeline.speculative_count(), 0u);
+    Candidate c;
+    EXPECT_FALSE(pipeline.pop_speculative(c));
+    EXPECT_EQ(pipeline.speculative_used(), used); // dropped candidates are not counted as used
+}
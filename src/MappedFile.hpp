@@ -0,0 +1,120 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "Definitions.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    define OPENGA_HAS_MMAP
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Read-only view of a whole file. On POSIX systems the
+ * file is memory-mapped so that only the touched pages
+ * are loaded. Elsewhere, the file is read into memory.
+ ****************************************************/
+class MappedFile {
+    const char* ptr;
+    std::size_t length;
+#ifdef OPENGA_HAS_MMAP
+    void* mapping;
+#else
+    std::vector<char> buffer;
+#endif
+
+public:
+    MappedFile()
+        : ptr(nullptr)
+        , length(0)
+#ifdef OPENGA_HAS_MMAP
+        , mapping(nullptr)
+#endif
+    {
+    }
+
+    explicit MappedFile(const std::string& path)
+        : MappedFile() {
+        open(path);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() { close(); }
+
+    void open(const std::string& path) {
+        close();
+#ifdef OPENGA_HAS_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open file " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat file " + path);
+        }
+        length = std::size_t(st.st_size);
+        if (length > 0) {
+            mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping == MAP_FAILED) {
+                mapping = nullptr;
+                length = 0;
+                ::close(fd);
+                throw std::runtime_error("Cannot map file " + path);
+            }
+            ptr = static_cast<const char*>(mapping);
+        }
+        ::close(fd); // the mapping keeps its own reference
+#else
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) throw std::runtime_error("Cannot open file " + path);
+        length = std::size_t(file.tellg());
+        buffer.resize(length);
+        file.seekg(0);
+        if (length > 0) file.read(buffer.data(), std::streamsize(length));
+        ptr = buffer.data();
+#endif
+    }
+
+    void close() {
+#ifdef OPENGA_HAS_MMAP
+        if (mapping) munmap(mapping, length);
+        mapping = nullptr;
+#else
+        buffer.clear();
+#endif
+        ptr = nullptr;
+        length = 0;
+    }
+
+    // asks the kernel to read the pages of [offset, offset+n) ahead, returns immediately
+    void will_need(std::size_t offset, std::size_t n) const {
+#ifdef OPENGA_HAS_MMAP
+        if (!mapping || offset >= length) return;
+        const std::size_t page = std::size_t(sysconf(_SC_PAGESIZE));
+        const std::size_t begin = offset / page * page;
+        const std::size_t end = std::min(length, offset + n);
+        madvise(static_cast<char*>(mapping) + begin, end - begin, MADV_WILLNEED);
+#else
+        (void)offset;
+        (void)n;
+#endif
+    }
+
+    bool is_open() const { return ptr != nullptr; }
+    const char* data() const { return ptr; }
+    std::size_t size() const { return length; }
+};
+
+NS_EA_END
@@ -2,6 +2,8 @@
 #include "Definitions.hpp"
 #include <algorithm>
 #include <cassert>
+#include <ostream>
+#include <stdexcept>
 #include <vector>
 
 NS_EA_BEGIN
@@ -107,7 +109,7 @@ std::ostream& operator<<(std::ostream& out, const Matrix<T>& mat) {
         for (unsigned int j = 0; j < mat.get_n_cols(); j++) {
             out << "\t" << mat(i, j);
         }
-        out << endl;
+        out << std::endl;
     }
     return out;
 }
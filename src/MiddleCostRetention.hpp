@@ -0,0 +1,174 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "Definitions.hpp"
+#include "MappedFile.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+NS_EA_BEGIN
+
+// what happens to the middle costs of a member once its costs are finalized
+enum class MiddleCostRetention {
+    Keep, // stay in ChromosomeType::middle_costs
+    Release, // dropped
+    Compress, // serialized and lz-compressed in memory
+    Spill // serialized into a SpillStore
+};
+
+struct SpillRecord;
+
+// where the middle costs of a member are kept, shared by its copies
+struct RetainedMiddleCosts {
+    MiddleCostRetention state = MiddleCostRetention::Keep; // Keep: in middle_costs
+    std::shared_ptr<const std::string> compressed; // Compress
+    std::shared_ptr<const SpillRecord> spilled; // Spill
+
+    bool in_place() const { return state == MiddleCostRetention::Keep; }
+};
+
+/****************************************************
+ * Side store of serialized middle costs. Records are
+ * written to a file and read back through a memory
+ * mapping of it, which is renewed when a record beyond
+ * its end is read. The pages of records which are not
+ * read belong to the page cache, not to the process.
+ * Without mmap, a read only loads its record.
+ *
+ * The space of a released record is recycled: append()
+ * writes into the smallest free extent the record fits
+ * in and only grows the file if there is none. Extents
+ * are not merged, which suits the records of one middle
+ * cost type, as they have similar sizes. Thread safe.
+ ****************************************************/
+class SpillStore {
+    std::string path;
+    bool remove_on_close;
+    std::ofstream file;
+    uint64_t written;
+    bool unflushed; // records were written since the last flush
+    std::multimap<uint64_t, uint64_t> free_extents; // size -> offset
+    uint64_t n_free;
+#ifdef OPENGA_HAS_MMAP
+    MappedFile view;
+#else
+    std::ifstream reader;
+#endif
+    std::mutex mtx;
+
+public:
+    // remove_on_close: the file only lives as long as the store
+    explicit SpillStore(const std::string& path, bool remove_on_close = true)
+        : path(path)
+        , remove_on_close(remove_on_close)
+        , file(path, std::ios::binary | std::ios::trunc)
+        , written(0)
+        , unflushed(false)
+        , n_free(0) {
+        if (!file) throw std::runtime_error("Cannot open spill store " + path);
+    }
+
+    SpillStore(const SpillStore&) = delete;
+    SpillStore& operator=(const SpillStore&) = delete;
+
+    ~SpillStore() {
+#ifdef OPENGA_HAS_MMAP
+        view.close();
+#else
+        reader.close();
+#endif
+        file.close();
+        if (remove_on_close) std::remove(path.c_str());
+    }
+
+    // returns the offset of the record
+    uint64_t append(const std::string& bytes) {
+        std::lock_guard<std::mutex> lock(mtx);
+        uint64_t offset = written;
+        auto extent = bytes.empty() ? free_extents.end() : free_extents.lower_bound(bytes.size());
+        if (extent != free_extents.end()) {
+            offset = extent->second;
+            if (extent->first > bytes.size())
+                free_extents.insert({extent->first - bytes.size(), offset + bytes.size()});
+            free_extents.erase(extent);
+            n_free -= bytes.size();
+        }
+        else
+            written += bytes.size();
+        file.seekp(std::streamoff(offset));
+        file.write(bytes.data(), std::streamsize(bytes.size()));
+        if (!file) throw std::runtime_error("Cannot write the spill store " + path);
+        unflushed = true;
+        return offset;
+    }
+
+    // the space of the record is free for the next appends
+    void release(uint64_t offset, uint64_t size) {
+        if (size == 0) return;
+        std::lock_guard<std::mutex> lock(mtx);
+        free_extents.insert({size, offset});
+        n_free += size;
+    }
+
+    std::string read(uint64_t offset, uint64_t size) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (offset + size > written) throw std::runtime_error("Record out of the spill store.");
+        if (size == 0) return std::string();
+        if (unflushed) {
+            file.flush();
+            unflushed = false;
+        }
+#ifdef OPENGA_HAS_MMAP
+        if (offset + size > view.size()) view.open(path);
+        return std::string(view.data() + offset, std::size_t(size));
+#else
+        if (!reader.is_open()) reader.open(path, std::ios::binary);
+        std::string bytes(std::size_t(size), '\0');
+        reader.clear();
+        reader.seekg(std::streamoff(offset));
+        reader.read(&bytes[0], std::streamsize(size));
+        if (!reader) throw std::runtime_error("Cannot read the spill store " + path);
+        return bytes;
+#endif
+    }
+
+    // size of the file
+    uint64_t bytes() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return written;
+    }
+
+    // bytes of released records, which are written over by the next appends
+    uint64_t free_bytes() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return n_free;
+    }
+};
+
+// A spilled record. Its space is released when the last member holding it is gone.
+struct SpillRecord {
+    std::shared_ptr<SpillStore> store;
+    uint64_t offset;
+    uint64_t size;
+
+    SpillRecord(std::shared_ptr<SpillStore> store, const std::string& bytes)
+        : store(std::move(store))
+        , offset(this->store->append(bytes))
+        , size(bytes.size()) {}
+
+    SpillRecord(const SpillRecord&) = delete;
+    SpillRecord& operator=(const SpillRecord&) = delete;
+
+    ~SpillRecord() { store->release(offset, size); }
+
+    std::string read() const { return store->read(offset, size); }
+};
+
+NS_EA_END
@@ -0,0 +1,66 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <MiddleCostRetention.hpp>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(MiddleCostRetentionTest, spilledRecordsAreReadBack) {
+    const std::string path = ::testing::TempDir() + "openga_spill_test";
+    {
+        EA::SpillStore store(path);
+        const std::string large(100000, 'y');
+        const uint64_t a = store.append("first");
+        EXPECT_EQ(store.read(a, 5), "first");
+        const uint64_t b = store.append(large); // beyond the current mapping
+        const uint64_t c = store.append("");
+        EXPECT_EQ(store.read(b, large.size()), large);
+        EXPECT_EQ(store.read(a, 5), "first");
+        EXPECT_EQ(store.read(c, 0), "");
+        EXPECT_EQ(store.bytes(), 5u + large.size());
+        EXPECT_THROW(store.read(b, large.size() + 1), std::runtime_error);
+    }
+    EXPECT_FALSE(std::ifstream(path).good()); // removed with the store
+}
+
+TEST(MiddleCostRetentionTest, releasedRecordsAreRecycled) {
+    const std::string path = ::testing::TempDir() + "openga_spill_test_recycled";
+    auto store = std::make_shared<EA::SpillStore>(path);
+    auto a = std::make_shared<EA::SpillRecord>(store, "aaaaaa");
+    auto b = std::make_shared<EA::SpillRecord>(store, "bbbb");
+    a.reset();
+    EXPECT_EQ(store->free_bytes(), 6u);
+    EA::SpillRecord c(store, "cccc"); // written over the start of a
+    EXPECT_EQ(c.offset, 0u);
+    EXPECT_EQ(c.read(), "cccc");
+    EXPECT_EQ(b->read(), "bbbb");
+    EXPECT_EQ(store->free_bytes(), 2u);
+    EXPECT_EQ(store->bytes(), 10u);
+    EA::SpillRecord d(store, "ddd"); // does not fit into the rest of a
+    EXPECT_EQ(d.offset, 10u);
+    EXPECT_EQ(d.read(), "ddd");
+    EXPECT_EQ(store->bytes(), 13u);
+}
+
+TEST(MiddleCostRetentionTest, concurrentAppends) {
+    const std::string path = ::testing::TempDir() + "openga_spill_test_kept";
+    {
+        EA::SpillStore store(path, false);
+        std::vector<uint64_t> offsets(400);
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < 4; t++)
+            threads.push_back(std::thread([&store, &offsets, t]() {
+                for (unsigned int i = t; i < 400; i += 4) {
+                    offsets[i] = store.append(std::to_string(1000 + i));
+                    EXPECT_EQ(store.read(offsets[i], 4), std::to_string(1000 + i));
+                }
+            }));
+        for (std::thread& th : threads) th.join();
+        for (unsigned int i = 0; i < 400; i++) EXPECT_EQ(store.read(offsets[i], 4), std::to_string(1000 + i));
+        EXPECT_TRUE(EA::RetainedMiddleCosts().in_place());
+    }
+    EXPECT_TRUE(std::ifstream(path).good());
+    std::remove(path.c_str());
+}
@@ -0,0 +1,96 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "Definitions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+NS_EA_BEGIN
+
+// Running mean and variance (Welford).
+struct RunningStats {
+    unsigned long n = 0;
+    double mean = 0.0;
+    double m2 = 0.0; // sum of squared deviations from the mean
+
+    void add(double x) {
+        n++;
+        const double delta = x - mean;
+        mean += delta / double(n);
+        m2 += delta * (x - mean);
+    }
+
+    // sample variance, 0 for less than two samples
+    double variance() const { return n > 1 ? m2 / double(n - 1) : 0.0; }
+    double stddev() const { return std::sqrt(variance()); }
+    double standard_error() const { return n > 0 ? std::sqrt(variance() / double(n)) : 0.0; }
+};
+
+/****************************************************
+ * Optimal computing budget allocation for selecting
+ * the best m of N noisy candidates (OCBA-m, lower is
+ * better). The ideal share of replications of a
+ * candidate is proportional to (sigma/(mean-c))^2,
+ * where c separates the m best means from the rest,
+ * so the candidates near the selection boundary with a
+ * large variance get most of the replications.
+ *
+ * Distributes `budget` extra replications one by one to
+ * the candidate lagging most behind its ideal share.
+ * Candidates at max_replications or with zero variance
+ * get nothing. Returns the number of extra replications
+ * per candidate.
+ ****************************************************/
+inline std::vector<unsigned int> ocba_allocation(
+    const std::vector<RunningStats>& stats, unsigned int m, unsigned int budget, unsigned long max_replications) {
+    const unsigned int N = (unsigned int)stats.size();
+    std::vector<unsigned int> extra(N, 0);
+    if (N < 2 || budget == 0) return extra;
+    m = std::max(1u, std::min(m, N - 1));
+
+    std::vector<unsigned int> order(N);
+    for (unsigned int i = 0; i < N; i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&stats](unsigned int a, unsigned int b) {
+        return stats[a].mean < stats[b].mean;
+    });
+    const RunningStats& last_in = stats[order[m - 1]];
+    const RunningStats& first_out = stats[order[m]];
+    const double s_in = last_in.stddev(), s_out = first_out.stddev();
+    const double c = s_in + s_out > 0.0 ? (s_out * last_in.mean + s_in * first_out.mean) / (s_in + s_out)
+                                        : 0.5 * (last_in.mean + first_out.mean);
+
+    double scale = 0.0; // smallest gap that is resolved
+    for (const RunningStats& s : stats) scale = std::max(scale, std::abs(s.mean - c));
+    const double min_gap = 1e-9 * (scale > 0.0 ? scale : 1.0);
+    std::vector<double> weight(N, 0.0);
+    double weight_sum = 0.0;
+    unsigned long total = budget;
+    for (unsigned int i = 0; i < N; i++) {
+        const double gap = std::max(std::abs(stats[i].mean - c), min_gap);
+        weight[i] = stats[i].variance() / (gap * gap);
+        weight_sum += weight[i];
+        total += stats[i].n;
+    }
+    if (weight_sum <= 0.0) return extra;
+
+    for (unsigned int k = 0; k < budget; k++) {
+        int best = -1;
+        double best_deficit = -std::numeric_limits<double>::infinity();
+        for (unsigned int i = 0; i < N; i++) {
+            if (weight[i] <= 0.0 || stats[i].n + extra[i] >= max_replications) continue;
+            const double deficit = double(total) * weight[i] / weight_sum - double(stats[i].n + extra[i]);
+            if (deficit > best_deficit) {
+                best_deficit = deficit;
+                best = int(i);
+            }
+        }
+        if (best < 0) break;
+        extra[best]++;
+    }
+    return extra;
+}
+
+NS_EA_END
@@ -0,0 +1,52 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <NoisyEvaluation.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+
+EA::RunningStats stats_of(const std::vector<double>& samples) {
+    EA::RunningStats s;
+    for (double x : samples) s.add(x);
+    return s;
+}
+
+} // namespace
+
+TEST(NoisyEvaluationTest, runningStats) {
+    EA::RunningStats s = stats_of({2, 4, 4, 4, 5, 5, 7, 9});
+    EXPECT_EQ(s.n, 8u);
+    EXPECT_DOUBLE_EQ(s.mean, 5.0);
+    EXPECT_DOUBLE_EQ(s.variance(), 32.0 / 7.0);
+    EXPECT_DOUBLE_EQ(s.standard_error(), std::sqrt(32.0 / 7.0 / 8.0));
+    EXPECT_EQ(stats_of({3}).variance(), 0.0);
+}
+
+TEST(NoisyEvaluationTest, ocbaFavorsTheSelectionBoundary) {
+    // select the best 2 of 5: members 1 and 2 are close to the boundary
+    std::vector<EA::RunningStats> stats = {
+        stats_of({0, 1}), // clearly in
+        stats_of({4.9, 5.9}), // boundary, in
+        stats_of({5.1, 6.1}), // boundary, out
+        stats_of({20, 21}), // clearly out
+        stats_of({30, 30}), // no variance
+    };
+    std::vector<unsigned int> extra = EA::ocba_allocation(stats, 2, 40, 100);
+    unsigned int sum = 0;
+    for (unsigned int e : extra) sum += e;
+    EXPECT_EQ(sum, 40u);
+    EXPECT_GT(extra[1], extra[0]);
+    EXPECT_GT(extra[2], extra[3]);
+    EXPECT_GT(extra[1] + extra[2], 30u);
+    EXPECT_EQ(extra[4], 0u);
+}
+
+TEST(NoisyEvaluationTest, ocbaRespectsTheReplicationLimit) {
+    std::vector<EA::RunningStats> stats = {stats_of({0, 1}), stats_of({0.5, 1.5}), stats_of({10, 11})};
+    std::vector<unsigned int> extra = EA::ocba_allocation(stats, 1, 100, 5);
+    for (unsigned int i = 0; i < 3; i++) EXPECT_LE(stats[i].n + extra[i], 5u);
+    // nothing to resolve without variance
+    std::vector<EA::RunningStats> exact = {stats_of({1, 1}), stats_of({2, 2})};
+    extra = EA::ocba_allocation(exact, 1, 10, 100);
+    EXPECT_EQ(extra, (std::vector<unsigned int>{0, 0}));
+}
@@ -0,0 +1,172 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "Definitions.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+NS_EA_BEGIN
+
+// Drop: a group of redundant objectives is represented by its first objective.
+// Merge: a group is replaced by the sum of its objectives scaled by their ranges.
+enum class ObjectiveReductionMode { Off, Drop, Merge };
+
+// Pareto dominance of objective vectors (minimization)
+inline bool pareto_dominates(const std::vector<double>& a, const std::vector<double>& b) {
+    bool better = false;
+    for (std::size_t i = 0; i < a.size(); i++) {
+        if (a[i] > b[i]) return false;
+        if (a[i] < b[i]) better = true;
+    }
+    return better;
+}
+
+/****************************************************
+ * Objectives used by the selection: groups of the full
+ * objective vector, each group is one objective of the
+ * reduced vector. No groups: the full vector is used.
+ ****************************************************/
+struct ObjectiveReduction {
+    std::vector<std::vector<unsigned int>> groups;
+    std::vector<double> weights; // Merge: per full objective, 1/range on the analysed front
+    bool merge = false;
+
+    bool is_identity() const { return groups.empty(); }
+
+    std::size_t size() const { return groups.size(); }
+
+    // objective g of the reduced vector
+    double value(const std::vector<double>& objectives, std::size_t g) const {
+        const std::vector<unsigned int>& group = groups[g];
+        if (!merge) return objectives[group[0]];
+        double sum = 0.0;
+        for (unsigned int k : group) sum += weights[k] * objectives[k];
+        return sum;
+    }
+
+    std::vector<double> apply(const std::vector<double>& objectives) const {
+        if (is_identity()) return objectives;
+        std::vector<double> reduced(groups.size());
+        for (std::size_t g = 0; g < groups.size(); g++) reduced[g] = value(objectives, g);
+        return reduced;
+    }
+
+    // Pareto dominance on the reduced objectives
+    bool dominates(const std::vector<double>& a, const std::vector<double>& b) const {
+        if (is_identity()) return pareto_dominates(a, b);
+        bool better = false;
+        for (std::size_t g = 0; g < groups.size(); g++) {
+            const double va = value(a, g), vb = value(b, g);
+            if (va > vb) return false;
+            if (va < vb) better = true;
+        }
+        return better;
+    }
+
+    bool operator==(const ObjectiveReduction& other) const {
+        return groups == other.groups && merge == other.merge && (!merge || weights == other.weights);
+    }
+    bool operator!=(const ObjectiveReduction& other) const { return !(*this == other); }
+};
+
+// Pearson correlation matrix (row-major, M*M) of the objective vectors, 0 for constant objectives
+inline std::vector<double> objective_correlations(const std::vector<std::vector<double>>& points) {
+    if (points.empty()) return {};
+    const std::size_t N = points.size(), M = points[0].size();
+    std::vector<double> mean(M, 0.0), sd(M, 0.0);
+    for (const std::vector<double>& p : points) {
+        if (p.size() != M) throw std::runtime_error("Objective vectors of different lengths.");
+        for (std::size_t j = 0; j < M; j++) mean[j] += p[j];
+    }
+    for (std::size_t j = 0; j < M; j++) mean[j] /= double(N);
+    std::vector<double> cov(M * M, 0.0);
+    for (const std::vector<double>& p : points)
+        for (std::size_t a = 0; a < M; a++)
+            for (std::size_t b = a; b < M; b++) cov[a * M + b] += (p[a] - mean[a]) * (p[b] - mean[b]);
+    for (std::size_t j = 0; j < M; j++) {
+        sd[j] = std::sqrt(cov[j * M + j]);
+        if (sd[j] <= 1e-12 * std::sqrt(double(N)) * std::max(1.0, std::abs(mean[j]))) sd[j] = 0.0; // rounding only
+    }
+    std::vector<double> corr(M * M, 0.0);
+    for (std::size_t a = 0; a < M; a++) {
+        corr[a * M + a] = 1.0;
+        for (std::size_t b = a + 1; b < M; b++) {
+            const double s = sd[a] * sd[b];
+            corr[a * M + b] = corr[b * M + a] = s > 0.0 ? cov[a * M + b] / s : 0.0;
+        }
+    }
+    return corr;
+}
+
+/****************************************************
+ * Groups the objectives which do not conflict on the
+ * given non-dominated points. Two objectives conflict
+ * if improving one worsens the other along the front,
+ * which shows as a negative correlation. An objective
+ * joins the first group whose members it is correlated
+ * with by at least threshold. At least min_objectives
+ * groups are kept. Returns no groups if nothing can be
+ * reduced.
+ ****************************************************/
+inline ObjectiveReduction analyse_objectives(
+    const std::vector<std::vector<double>>& front,
+    double threshold,
+    bool merge,
+    unsigned int min_objectives = 2) {
+    ObjectiveReduction reduction;
+    if (front.size() < 3) return reduction; // too few points for a correlation
+    const unsigned int M = (unsigned int)front[0].size();
+    const std::vector<double> corr = objective_correlations(front);
+    for (unsigned int j = 0; j < M; j++) {
+        bool joined = false;
+        for (std::vector<unsigned int>& group : reduction.groups) {
+            bool redundant = true;
+            for (unsigned int k : group)
+                if (corr[std::size_t(j) * M + k] < threshold) redundant = false;
+            if (redundant) {
+                group.push_back(j);
+                joined = true;
+                break;
+            }
+        }
+        if (!joined) reduction.groups.push_back({j});
+    }
+    // split the largest groups again if too few objectives are left
+    while (reduction.groups.size() < std::min(min_objectives, M)) {
+        std::size_t largest = 0;
+        for (std::size_t g = 1; g < reduction.groups.size(); g++)
+            if (reduction.groups[g].size() > reduction.groups[largest].size()) largest = g;
+        reduction.groups.push_back({reduction.groups[largest].back()});
+        reduction.groups[largest].pop_back();
+    }
+    if (reduction.groups.size() == M) {
+        reduction.groups.clear();
+        return reduction;
+    }
+    reduction.merge = merge;
+    if (merge) {
+        reduction.weights.assign(M, 1.0);
+        for (unsigned int j = 0; j < M; j++) {
+            double lo = front[0][j], hi = front[0][j];
+            for (const std::vector<double>& p : front) {
+                lo = std::min(lo, p[j]);
+                hi = std::max(hi, p[j]);
+            }
+            if (hi - lo > 1e-300) reduction.weights[j] = 1.0 / (hi - lo);
+        }
+    }
+    return reduction;
+}
+
+// one decision of the online objective reduction
+struct ObjectiveReductionRecord {
+    int generation_step;
+    std::vector<std::vector<unsigned int>> groups; // empty: all objectives are used
+    bool final_check; // re-check of the full objective set before termination
+};
+
+NS_EA_END
@@ -0,0 +1,72 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <ObjectiveReduction.hpp>
+#include <gtest/gtest.h>
+#include <vector>
+
+using Points = std::vector<std::vector<double>>;
+using Groups = std::vector<std::vector<unsigned int>>;
+
+namespace {
+
+// front of f0 = x, f1 = 1 - x, with f2 = 2 x and f3 = x^2 redundant with f0 and f4 constant
+Points redundant_front() {
+    Points front;
+    for (int i = 0; i <= 10; i++) {
+        const double x = 0.1 * i;
+        front.push_back({x, 1.0 - x, 2.0 * x, x * x, 3.0});
+    }
+    return front;
+}
+
+} // namespace
+
+TEST(ObjectiveReductionTest, correlations) {
+    const std::vector<double> corr = EA::objective_correlations(redundant_front());
+    ASSERT_EQ(corr.size(), 25u);
+    EXPECT_NEAR(corr[0 * 5 + 1], -1.0, 1e-12);
+    EXPECT_NEAR(corr[0 * 5 + 2], 1.0, 1e-12);
+    EXPECT_GT(corr[0 * 5 + 3], 0.95);
+    EXPECT_EQ(corr[0 * 5 + 4], 0.0);
+    EXPECT_EQ(corr[4 * 5 + 4], 1.0);
+}
+
+TEST(ObjectiveReductionTest, redundantObjectivesAreGrouped) {
+    EA::ObjectiveReduction drop = EA::analyse_objectives(redundant_front(), 0.95, false);
+    EXPECT_EQ(drop.groups, (Groups{{0, 2, 3}, {1}, {4}}));
+    EXPECT_EQ(drop.apply({0.5, 0.5, 1.0, 0.25, 3.0}), (std::vector<double>{0.5, 0.5, 3.0}));
+    // f2 is worse but it is not used for the dominance any more
+    EXPECT_TRUE(drop.dominates({0.1, 0.5, 9.0, 0.0, 3.0}, {0.2, 0.5, 0.0, 0.0, 3.0}));
+    EXPECT_FALSE(drop.dominates({0.1, 0.5, 0.0, 0.0, 3.0}, {0.1, 0.5, 0.0, 0.0, 3.0}));
+
+    EA::ObjectiveReduction merge = EA::analyse_objectives(redundant_front(), 0.95, true);
+    EXPECT_EQ(merge.groups, drop.groups);
+    EXPECT_DOUBLE_EQ(merge.value({0.5, 0.5, 1.0, 0.25, 3.0}, 0), 0.5 / 1.0 + 1.0 / 2.0 + 0.25 / 1.0);
+    EXPECT_DOUBLE_EQ(merge.value({0.5, 0.5, 1.0, 0.25, 3.0}, 2), 3.0);
+
+    EXPECT_EQ(EA::analyse_objectives(redundant_front(), 0.99, false).groups, (Groups{{0, 2}, {1}, {3}, {4}}));
+
+    // the same groups merged with other ranges are another reduction
+    Points wider = redundant_front();
+    for (std::vector<double>& f : wider) f[2] *= 2.0;
+    EA::ObjectiveReduction rescaled = EA::analyse_objectives(wider, 0.95, true);
+    EXPECT_EQ(rescaled.groups, merge.groups);
+    EXPECT_NE(rescaled, merge);
+    EXPECT_EQ(EA::analyse_objectives(wider, 0.95, false), drop);
+}
+
+TEST(ObjectiveReductionTest, conflictingObjectivesAreKept) {
+    Points front;
+    for (int i = 0; i <= 10; i++) front.push_back({0.1 * i, 1.0 - 0.1 * i});
+    EXPECT_TRUE(EA::analyse_objectives(front, 0.95, false).is_identity());
+    EXPECT_TRUE(EA::analyse_objectives({{0.0, 1.0, 0.0}, {1.0, 0.0, 1.0}}, 0.95, false).is_identity());
+
+    // all objectives agree: two of them are kept anyway
+    Points agreeing;
+    for (int i = 0; i <= 10; i++) agreeing.push_back({0.1 * i, 0.2 * i, 0.3 * i});
+    EXPECT_EQ(EA::analyse_objectives(agreeing, 0.95, false).groups, (Groups{{0, 1}, {2}}));
+
+    EA::ObjectiveReduction identity;
+    EXPECT_EQ(identity.apply({1.0, 2.0}), (std::vector<double>{1.0, 2.0}));
+    EXPECT_TRUE(identity.dominates({1.0, 2.0}, {1.0, 3.0}));
+    EXPECT_FALSE(identity.dominates({1.0, 2.0}, {0.0, 3.0}));
+}
@@ -0,0 +1,188 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "Definitions.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+NS_EA_BEGIN
+
+enum class SelectionStrategy {
+    Roulette, // rank based roulette wheel (default)
+    Tournament, // k-tournament on the total cost (SO) or the front (MO)
+    StochasticUniversal, // low-variance sampling of the rank based roulette wheel
+    CrowdedTournament, // k-tournament on the front, ties broken by the crowding distance (MO only)
+    Lexicase // objectives as cases in a random order (MO only)
+};
+
+/****************************************************
+ * Random engine owned by a single worker. Parent
+ * selection draws from it without any lock.
+ ****************************************************/
+class LocalRandom {
+    std::mt19937_64 engine;
+
+public:
+    explicit LocalRandom(uint64_t seed)
+        : engine(seed) {}
+
+    // uniform in [0,1)
+    double operator()() { return double(engine() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // uniform in [0,n)
+    unsigned int below(unsigned int n) {
+        unsigned int i = (unsigned int)((*this)() * n);
+        return i < n ? i : n - 1;
+    }
+};
+
+// First member with cdf >= r, i.e. the roulette wheel slot of r.
+inline unsigned int roulette_select(const std::vector<double>& cdf, double r) {
+    unsigned int position = (unsigned int)(std::lower_bound(cdf.begin(), cdf.end(), r) - cdf.begin());
+    return position < cdf.size() ? position : (unsigned int)cdf.size() - 1;
+}
+
+/****************************************************
+ * k-tournament among N members. better(a,b) tells if
+ * member a wins against member b. Needs neither a
+ * ranking nor a selection chance, O(k) per draw.
+ ****************************************************/
+template<typename Better>
+unsigned int tournament_select(unsigned int N, unsigned int k, Better better, LocalRandom& rnd) {
+    unsigned int winner = rnd.below(N);
+    for (unsigned int i = 1; i < k; i++) {
+        unsigned int contender = rnd.below(N);
+        if (better(contender, winner)) winner = contender;
+    }
+    return winner;
+}
+
+/****************************************************
+ * Stochastic universal sampling: n equally spaced
+ * pointers with a single random offset over the
+ * cumulative selection chance, in one O(N+n) pass.
+ * The result is shuffled so that consecutive draws can
+ * be paired as parents.
+ ****************************************************/
+inline void stochastic_universal_sampling(
+    const std::vector<double>& cdf, unsigned int n, std::vector<unsigned int>& selected, LocalRandom& rnd) {
+    selected.clear();
+    if (cdf.empty() || n == 0) return;
+    selected.reserve(n);
+    const double total = cdf.back();
+    const double step = total / double(n);
+    double pointer = rnd() * step;
+    unsigned int position = 0;
+    const unsigned int last = (unsigned int)cdf.size() - 1;
+    for (unsigned int i = 0; i < n; i++, pointer += step) {
+        while (position < last && cdf[position] < pointer) position++;
+        selected.push_back(position);
+    }
+    for (unsigned int i = n - 1; i > 0; i--) std::swap(selected[i], selected[rnd.below(i + 1)]);
+}
+
+/****************************************************
+ * Parent pairs drawn for a whole generation at once,
+ * e.g. by a single stochastic universal sampling pass.
+ * The worker threads take them in order through an
+ * atomic counter, take() fails when all are used up.
+ * pair() reads ahead, e.g. to prefetch the parents of
+ * the pairs which are taken next.
+ ****************************************************/
+class ParentBatch {
+    std::vector<unsigned int> parents; // pair k: 2k and 2k+1
+    std::atomic<std::size_t> next;
+
+public:
+    // parents are paired in order
+    explicit ParentBatch(const std::vector<unsigned int>& parents)
+        : parents(parents)
+        , next(0) {
+        this->parents.resize(parents.size() / 2 * 2);
+    }
+
+    // index is the number of the taken pair
+    bool take(unsigned int& p1, unsigned int& p2, std::size_t& index) {
+        index = next++;
+        return pair(index, p1, p2);
+    }
+
+    bool pair(std::size_t index, unsigned int& p1, unsigned int& p2) const {
+        if (index >= size()) return false;
+        p1 = parents[2 * index];
+        p2 = parents[2 * index + 1];
+        return true;
+    }
+
+    // number of pairs
+    std::size_t size() const { return parents.size() / 2; }
+};
+
+/****************************************************
+ * Lexicase selection. The cases are visited in a random
+ * order and only the members with the lowest value of
+ * the current case survive. value(i,c) is the value of
+ * case c for member i (lower is better).
+ ****************************************************/
+template<typename Value>
+unsigned int lexicase_select(unsigned int N, unsigned int N_cases, Value value, LocalRandom& rnd) {
+    std::vector<unsigned int> cases(N_cases);
+    for (unsigned int c = 0; c < N_cases; c++) cases[c] = c;
+    for (unsigned int c = N_cases; c > 1; c--) std::swap(cases[c - 1], cases[rnd.below(c)]);
+    std::vector<unsigned int> candidates(N);
+    for (unsigned int i = 0; i < N; i++) candidates[i] = i;
+    std::vector<unsigned int> survivors;
+    for (unsigned int c : cases) {
+        if (candidates.size() == 1) break;
+        double best = std::numeric_limits<double>::infinity();
+        for (unsigned int i : candidates) best = std::min(best, value(i, c));
+        survivors.clear();
+        for (unsigned int i : candidates)
+            if (value(i, c) <= best) survivors.push_back(i);
+        candidates.swap(survivors);
+    }
+    return candidates[rnd.below((unsigned int)candidates.size())];
+}
+
+/****************************************************
+ * Crowding distance of every member within its front.
+ * The boundary members of a front get infinity.
+ * value(i,m) is objective m of member i.
+ ****************************************************/
+template<typename Value>
+void crowding_distances(
+    const std::vector<std::vector<unsigned int>>& fronts,
+    unsigned int N,
+    unsigned int N_objectives,
+    Value value,
+    std::vector<double>& distance) {
+    const double inf = std::numeric_limits<double>::infinity();
+    distance.assign(N, 0.0);
+    std::vector<unsigned int> order;
+    for (const std::vector<unsigned int>& front : fronts) {
+        if (front.size() <= 2) {
+            for (unsigned int i : front) distance[i] = inf;
+            continue;
+        }
+        order = front;
+        for (unsigned int m = 0; m < N_objectives; m++) {
+            std::sort(order.begin(), order.end(), [&value, m](unsigned int a, unsigned int b) {
+                return value(a, m) < value(b, m);
+            });
+            const double range = value(order.back(), m) - value(order.front(), m);
+            distance[order.front()] = inf;
+            distance[order.back()] = inf;
+            if (range <= 0.0) continue;
+            for (std::size_t k = 1; k + 1 < order.size(); k++)
+                distance[order[k]] += (value(order[k + 1], m) - value(order[k - 1], m)) / range;
+        }
+    }
+}
+
+NS_EA_END
@@ -0,0 +1,112 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <ParentSelection.hpp>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <limits>
+#include <thread>
+#include <vector>
+
+TEST(ParentSelectionTest, localRandomRange) {
+    EA::LocalRandom rnd(1);
+    for (int i = 0; i < 10000; i++) {
+        double r = rnd();
+        EXPECT_GE(r, 0.0);
+        EXPECT_LT(r, 1.0);
+        EXPECT_LT(rnd.below(7), 7u);
+    }
+}
+
+TEST(ParentSelectionTest, rouletteSlots) {
+    std::vector<double> cdf = {0.5, 0.75, 1.0};
+    EXPECT_EQ(EA::roulette_select(cdf, 0.0), 0u);
+    EXPECT_EQ(EA::roulette_select(cdf, 0.5), 0u);
+    EXPECT_EQ(EA::roulette_select(cdf, 0.6), 1u);
+    EXPECT_EQ(EA::roulette_select(cdf, 0.99), 2u);
+}
+
+TEST(ParentSelectionTest, tournamentPrefersBetterMembers) {
+    EA::LocalRandom rnd(2);
+    const unsigned int N = 10;
+    auto better = [](unsigned int a, unsigned int b) { return a < b; }; // member 0 is the best
+    std::vector<int> count(N, 0);
+    for (int i = 0; i < 20000; i++) count[EA::tournament_select(N, 3, better, rnd)]++;
+    for (unsigned int i = 1; i < N; i++) EXPECT_GT(count[i - 1], count[i]);
+    // P(winner = 0) = 1 - (9/10)^3
+    EXPECT_NEAR(count[0] / 20000.0, 1.0 - std::pow(0.9, 3), 0.02);
+    // a single contender is a uniform draw
+    std::fill(count.begin(), count.end(), 0);
+    for (int i = 0; i < 20000; i++) count[EA::tournament_select(N, 1, better, rnd)]++;
+    for (int c : count) EXPECT_NEAR(c / 20000.0, 0.1, 0.02);
+}
+
+TEST(ParentSelectionTest, stochasticUniversalSamplingIsExact) {
+    EA::LocalRandom rnd(3);
+    // shares 0.5, 0.25, 0.125, 0.125
+    std::vector<double> cdf = {0.5, 0.75, 0.875, 1.0};
+    std::vector<unsigned int> selected;
+    for (int repeat = 0; repeat < 100; repeat++) {
+        EA::stochastic_universal_sampling(cdf, 8, selected, rnd);
+        ASSERT_EQ(selected.size(), 8u);
+        std::vector<int> count(4, 0);
+        for (unsigned int i : selected) count[i]++;
+        EXPECT_EQ(count, (std::vector<int>{4, 2, 1, 1}));
+    }
+}
+
+TEST(ParentSelectionTest, parentBatchIsSharedByWorkers) {
+    std::vector<unsigned int> parents(1001);
+    for (unsigned int i = 0; i < parents.size(); i++) parents[i] = i;
+    EA::ParentBatch batch(parents);
+    ASSERT_EQ(batch.size(), 500u);
+    unsigned int p1, p2;
+    ASSERT_TRUE(batch.pair(3, p1, p2));
+    EXPECT_EQ(p1, 6u);
+    EXPECT_EQ(p2, 7u);
+    EXPECT_FALSE(batch.pair(500, p1, p2));
+
+    std::vector<std::vector<unsigned int>> taken(4);
+    std::vector<std::thread> workers;
+    for (unsigned int w = 0; w < 4; w++)
+        workers.push_back(std::thread([&batch, &taken, w]() {
+            unsigned int a, b;
+            std::size_t k;
+            while (batch.take(a, b, k)) {
+                EXPECT_EQ(a, 2 * k);
+                EXPECT_EQ(b, 2 * k + 1);
+                taken[w].push_back(a);
+                taken[w].push_back(b);
+            }
+        }));
+    for (std::thread& th : workers) th.join();
+    std::vector<int> count(1000, 0);
+    for (const std::vector<unsigned int>& t : taken)
+        for (unsigned int i : t) count[i]++;
+    EXPECT_EQ(count, std::vector<int>(1000, 1)); // every draw is used exactly once
+    std::size_t k;
+    EXPECT_FALSE(batch.take(p1, p2, k));
+}
+
+TEST(ParentSelectionTest, lexicaseFiltersByCases) {
+    EA::LocalRandom rnd(4);
+    // member 0 is the best in case 0, member 1 in case 1, member 2 is never the best
+    std::vector<std::vector<double>> values = {{0, 5}, {5, 0}, {1, 1}};
+    auto value = [&values](unsigned int i, unsigned int c) { return values[i][c]; };
+    std::vector<int> count(3, 0);
+    for (int i = 0; i < 1000; i++) count[EA::lexicase_select(3, 2, value, rnd)]++;
+    EXPECT_EQ(count[2], 0);
+    EXPECT_NEAR(count[0] / 1000.0, 0.5, 0.1);
+}
+
+TEST(ParentSelectionTest, crowdingDistances) {
+    std::vector<std::vector<double>> objectives = {{0, 4}, {1, 2}, {3, 1}, {4, 0}, {5, 5}};
+    std::vector<std::vector<unsigned int>> fronts = {{0, 1, 2, 3}, {4}};
+    std::vector<double> distance;
+    EA::crowding_distances(
+        fronts, 5, 2, [&objectives](unsigned int i, unsigned int m) { return objectives[i][m]; }, distance);
+    const double inf = std::numeric_limits<double>::infinity();
+    EXPECT_EQ(distance[0], inf);
+    EXPECT_EQ(distance[3], inf);
+    EXPECT_EQ(distance[4], inf);
+    EXPECT_DOUBLE_EQ(distance[1], 3.0 / 4.0 + 3.0 / 4.0);
+    EXPECT_DOUBLE_EQ(distance[2], 3.0 / 4.0 + 2.0 / 4.0);
+}
@@ -0,0 +1,179 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "Definitions.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#    define OPENGA_HAS_PERF_EVENTS
+#    include <linux/perf_event.h>
+#    include <sys/ioctl.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+NS_EA_BEGIN
+
+struct PerfCounterValues {
+    double seconds = 0.0; // wall time
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cache_misses = 0;
+    uint64_t branch_misses = 0;
+
+    void add(const PerfCounterValues& x) {
+        seconds += x.seconds;
+        cycles += x.cycles;
+        instructions += x.instructions;
+        cache_misses += x.cache_misses;
+        branch_misses += x.branch_misses;
+    }
+
+    PerfCounterValues since(const PerfCounterValues& start) const {
+        PerfCounterValues d;
+        d.seconds = seconds - start.seconds;
+        d.cycles = cycles - start.cycles;
+        d.instructions = instructions - start.instructions;
+        d.cache_misses = cache_misses - start.cache_misses;
+        d.branch_misses = branch_misses - start.branch_misses;
+        return d;
+    }
+
+    // instructions per cycle
+    double ipc() const { return cycles ? double(instructions) / double(cycles) : 0.0; }
+    // misses per thousand instructions
+    double cache_mpki() const { return instructions ? 1000.0 * double(cache_misses) / double(instructions) : 0.0; }
+    double branch_mpki() const { return instructions ? 1000.0 * double(branch_misses) / double(instructions) : 0.0; }
+};
+
+enum class EnginePhase {
+    Offspring, // initialization or crossover and mutation, including the evaluations
+    Objectives, // finalize_objectives
+    Ranking, // rank_population
+    Selection // select_population (including associate_to_references in MO)
+};
+const unsigned int N_engine_phases = 4;
+
+// hardware counters of a generation
+struct PerfMetrics {
+    PerfCounterValues phases[N_engine_phases]; // on the thread running the engine
+    std::vector<PerfCounterValues> workers; // on every worker thread of the offspring phase
+
+    PerfCounterValues& phase(EnginePhase p) { return phases[(unsigned int)p]; }
+    const PerfCounterValues& phase(EnginePhase p) const { return phases[(unsigned int)p]; }
+};
+
+/****************************************************
+ * Cycles, instructions, cache misses and branch misses
+ * of the calling thread (Linux perf_event_open, user
+ * space only). The four counters are scheduled as one
+ * group and read with a single call. When the kernel
+ * multiplexes more events than the core has counters,
+ * the group only runs for a part of the time; the
+ * counts are then scaled by the time enabled over the
+ * time running, which makes them estimates. If the
+ * kernel refuses to open them, e.g. in a
+ * container or with a restrictive perf_event_paranoid,
+ * available() is false and only the wall time is
+ * measured.
+ ****************************************************/
+class PerfCounterGroup {
+    static const unsigned int N_counters = 4;
+    int fd[N_counters];
+
+public:
+    PerfCounterGroup() {
+        for (int& f : fd) f = -1;
+#ifdef OPENGA_HAS_PERF_EVENTS
+        const uint64_t config[N_counters] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES};
+        for (unsigned int i = 0; i < N_counters; i++) {
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof attr;
+            attr.config = config[i];
+            attr.disabled = i == 0 ? 1 : 0; // the group starts with its leader
+            attr.read_format =
+                PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            fd[i] = int(syscall(__NR_perf_event_open, &attr, 0, -1, i == 0 ? -1 : fd[0], 0));
+            if (fd[0] < 0) break;
+        }
+        if (fd[0] >= 0) {
+            ioctl(fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    PerfCounterGroup(const PerfCounterGroup&) = delete;
+    PerfCounterGroup& operator=(const PerfCounterGroup&) = delete;
+
+    ~PerfCounterGroup() {
+#ifdef OPENGA_HAS_PERF_EVENTS
+        for (int f : fd)
+            if (f >= 0) close(f);
+#endif
+    }
+
+    bool available() const { return fd[0] >= 0; }
+
+    // Counts since construction. Only meaningful on the thread that constructed the group.
+    PerfCounterValues read() const {
+        PerfCounterValues v;
+        v.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#ifdef OPENGA_HAS_PERF_EVENTS
+        if (fd[0] < 0) return v;
+        uint64_t* target[N_counters] = {&v.cycles, &v.instructions, &v.cache_misses, &v.branch_misses};
+        uint64_t group[3 + N_counters] = {}; // number of counters, time enabled, time running, counts
+        const ssize_t n = ::read(fd[0], group, sizeof group);
+        if (n < ssize_t(3 * sizeof(uint64_t))) return v;
+        const double scale = group[2] > 0 && group[2] < group[1] ? double(group[1]) / double(group[2]) : 1.0;
+        // the counts are in the order the counters joined the group, which skips the ones that failed to open
+        for (unsigned int i = 0, k = 0; i < N_counters && k < group[0]; i++)
+            if (fd[i] >= 0) *target[i] = uint64_t(double(group[3 + k++]) * scale);
+#endif
+        return v;
+    }
+};
+
+// Counter group of the calling thread, opened on first use and kept for the lifetime of the thread.
+inline const PerfCounterGroup& thread_perf_counters() {
+    static thread_local PerfCounterGroup group;
+    return group;
+}
+
+// Collects the counters of worker threads, one entry per thread.
+class PerfWorkerCounters {
+    std::mutex mtx;
+    std::map<std::thread::id, PerfCounterValues> by_thread;
+
+public:
+    void add(const PerfCounterValues& values) {
+        std::lock_guard<std::mutex> lock(mtx);
+        by_thread[std::this_thread::get_id()].add(values);
+    }
+
+    // returns and clears the collected counters
+    std::vector<PerfCounterValues> take() {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::vector<PerfCounterValues> result;
+        for (const auto& entry : by_thread) result.push_back(entry.second);
+        by_thread.clear();
+        return result;
+    }
+};
+
+NS_EA_END
@@ -0,0 +1,68 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <PerfCounters.hpp>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+double busy_loop(int n) {
+    volatile double x = 0.0;
+    for (int i = 0; i < n; i++) x = x + 1.0 / double(i + 1);
+    return x;
+}
+
+} // namespace
+
+TEST(PerfCountersTest, valuesArithmetic) {
+    EA::PerfCounterValues a;
+    a.seconds = 2.0;
+    a.cycles = 1000;
+    a.instructions = 3000;
+    a.cache_misses = 6;
+    a.branch_misses = 9;
+    EXPECT_DOUBLE_EQ(a.ipc(), 3.0);
+    EXPECT_DOUBLE_EQ(a.cache_mpki(), 2.0);
+    EXPECT_DOUBLE_EQ(a.branch_mpki(), 3.0);
+
+    EA::PerfCounterValues b = a;
+    b.add(a);
+    EA::PerfCounterValues d = b.since(a);
+    EXPECT_DOUBLE_EQ(d.seconds, 2.0);
+    EXPECT_EQ(d.instructions, 3000u);
+    EXPECT_EQ(d.branch_misses, 9u);
+    EXPECT_EQ(EA::PerfCounterValues().ipc(), 0.0);
+}
+
+TEST(PerfCountersTest, threadCounters) {
+    const EA::PerfCounterGroup& group = EA::thread_perf_counters();
+    EA::PerfCounterValues start = group.read();
+    busy_loop(1000000);
+    EA::PerfCounterValues d = group.read().since(start);
+    EXPECT_GT(d.seconds, 0.0);
+    if (!group.available()) {
+        EXPECT_EQ(d.instructions, 0u);
+        return; // perf_event_open is not permitted here
+    }
+    EXPECT_GT(d.instructions, 1000000u);
+    EXPECT_GT(d.cycles, 0u);
+}
+
+TEST(PerfCountersTest, workerCountersPerThread) {
+    EA::PerfWorkerCounters workers;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; t++) {
+        threads.push_back(std::thread([&workers]() {
+            for (int k = 0; k < 2; k++) {
+                EA::PerfCounterValues start = EA::thread_perf_counters().read();
+                busy_loop(10000);
+                workers.add(EA::thread_perf_counters().read().since(start));
+            }
+        }));
+    }
+    for (std::thread& th : threads) th.join();
+    std::vector<EA::PerfCounterValues> result = workers.take();
+    EXPECT_EQ(result.size(), 3u);
+    for (const EA::PerfCounterValues& v : result) EXPECT_GT(v.seconds, 0.0);
+    EXPECT_TRUE(workers.take().empty());
+}
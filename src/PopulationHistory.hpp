@@ -0,0 +1,358 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "BinaryCodec.hpp"
+#include "Definitions.hpp"
+#include "MappedFile.hpp"
+#include "Matrix.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Population history file layout:
+ *
+ *   "OGAH" | column blocks ... | footer | footer size | "OGAF"
+ *
+ * Every generation is one chunk. Each column of a
+ * chunk is encoded and compressed separately so that
+ * a reader can decode one column of one generation
+ * without touching the rest of the file. The footer
+ * indexes all column blocks.
+ ****************************************************/
+enum class HistoryColumn { TotalCost, Objectives, Rank, Front, Genes };
+
+const unsigned int history_column_count = 5;
+const char history_header_magic[] = "OGAH";
+const char history_footer_magic[] = "OGAF";
+
+struct HistoryChunkIndex {
+    int generation_step = 0;
+    unsigned int n_rows = 0;
+    unsigned int n_objectives = 0;
+    uint64_t offset[history_column_count] = {};
+    uint64_t size[history_column_count] = {};
+};
+
+/****************************************************
+ * Appends one chunk per generation to a history file.
+ * The caller only copies the columns out of the
+ * generation; encoding, compression and disk I/O run
+ * on a background thread. At most max_pending chunks
+ * are queued before append() blocks.
+ ****************************************************/
+template<typename GeneType>
+class PopulationHistoryWriter {
+    struct Chunk {
+        int generation_step;
+        unsigned int n_rows;
+        unsigned int n_objectives;
+        std::vector<double> total_costs;
+        std::vector<double> objectives; // column-major
+        std::vector<int> ranks;
+        std::vector<int> fronts;
+        std::vector<std::string> genes;
+    };
+
+    std::ofstream file;
+    uint64_t file_offset;
+    std::vector<HistoryChunkIndex> index;
+    std::deque<Chunk> pending;
+    unsigned int max_pending;
+    bool closing;
+    bool closed;
+    std::exception_ptr worker_error;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread worker;
+
+public:
+    // optional, genes are not stored when null
+    std::function<std::string(const GeneType&)> serialize_genes;
+
+    explicit PopulationHistoryWriter(const std::string& path, unsigned int max_pending = 4)
+        : file(path, std::ios::binary | std::ios::trunc)
+        , file_offset(0)
+        , max_pending(max_pending < 1 ? 1 : max_pending)
+        , closing(false)
+        , closed(false)
+        , serialize_genes(nullptr) {
+        if (!file) throw std::runtime_error("Cannot open history file " + path);
+        file.write(history_header_magic, 4);
+        file_offset = 4;
+        worker = std::thread(&PopulationHistoryWriter::writer_loop, this);
+    }
+
+    PopulationHistoryWriter(const PopulationHistoryWriter&) = delete;
+    PopulationHistoryWriter& operator=(const PopulationHistoryWriter&) = delete;
+
+    ~PopulationHistoryWriter() {
+        try {
+            close();
+        }
+        catch (...) {
+        }
+    }
+
+    template<typename GenerationT>
+    void append(int generation_step, const GenerationT& g) {
+        Chunk chunk;
+        chunk.generation_step = generation_step;
+        chunk.n_rows = (unsigned int)g.chromosomes.size();
+        chunk.n_objectives = chunk.n_rows ? (unsigned int)g.chromosomes[0].objectives.size() : 0;
+
+        if (chunk.n_objectives == 0) {
+            chunk.total_costs.reserve(chunk.n_rows);
+            for (const auto& c : g.chromosomes) chunk.total_costs.push_back(c.total_cost);
+        }
+        else {
+            chunk.objectives.resize(std::size_t(chunk.n_rows) * chunk.n_objectives);
+            for (unsigned int i = 0; i < chunk.n_rows; i++) {
+                if (g.chromosomes[i].objectives.size() != chunk.n_objectives)
+                    throw std::runtime_error("Objective vector size mismatch in history writer.");
+                for (unsigned int j = 0; j < chunk.n_objectives; j++)
+                    chunk.objectives[std::size_t(j) * chunk.n_rows + i] = g.chromosomes[i].objectives[j];
+            }
+        }
+        if (g.sorted_indices.size() == chunk.n_rows) {
+            chunk.ranks.assign(chunk.n_rows, 0);
+            for (unsigned int i = 0; i < chunk.n_rows; i++) chunk.ranks[g.sorted_indices[i]] = int(i);
+        }
+        if (!g.fronts.empty()) {
+            chunk.fronts.assign(chunk.n_rows, -1);
+            for (unsigned int f = 0; f < g.fronts.size(); f++)
+                for (unsigned int i : g.fronts[f])
+                    if (i < chunk.n_rows) chunk.fronts[i] = int(f);
+        }
+        if (serialize_genes) {
+            chunk.genes.reserve(chunk.n_rows);
+            for (const auto& c : g.chromosomes) chunk.genes.push_back(serialize_genes(c.genes));
+        }
+
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this]() { return pending.size() < max_pending || worker_error || closing; });
+        if (worker_error) std::rethrow_exception(worker_error);
+        if (closing) throw std::runtime_error("History writer is already closed.");
+        pending.push_back(std::move(chunk));
+        cv.notify_all();
+    }
+
+    // Waits for the queued chunks and writes the footer.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (closed) return;
+            closing = true;
+            closed = true;
+        }
+        cv.notify_all();
+        if (worker.joinable()) worker.join();
+        if (worker_error) std::rethrow_exception(worker_error);
+
+        std::string footer;
+        put_varint(footer, index.size());
+        for (const HistoryChunkIndex& entry : index) {
+            put_varint(footer, zigzag_encode(entry.generation_step));
+            put_varint(footer, entry.n_rows);
+            put_varint(footer, entry.n_objectives);
+            for (unsigned int c = 0; c < history_column_count; c++) {
+                put_varint(footer, entry.offset[c]);
+                put_varint(footer, entry.size[c]);
+            }
+        }
+        std::string tail;
+        put_fixed64(tail, footer.size());
+        tail.append(history_footer_magic, 4);
+        file.write(footer.data(), std::streamsize(footer.size()));
+        file.write(tail.data(), std::streamsize(tail.size()));
+        file.close();
+        if (!file) throw std::runtime_error("Failed to finalize the history file.");
+    }
+
+protected:
+    void writer_loop() {
+        while (true) {
+            Chunk chunk;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this]() { return !pending.empty() || closing; });
+                if (pending.empty()) return;
+                chunk = std::move(pending.front());
+                pending.pop_front();
+            }
+            cv.notify_all();
+            try {
+                write_chunk(chunk);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(mtx);
+                worker_error = std::current_exception();
+                pending.clear();
+                cv.notify_all();
+                return;
+            }
+        }
+    }
+
+    void write_chunk(const Chunk& chunk) {
+        HistoryChunkIndex entry;
+        entry.generation_step = chunk.generation_step;
+        entry.n_rows = chunk.n_rows;
+        entry.n_objectives = chunk.n_objectives;
+
+        std::string raw, compressed;
+        for (unsigned int c = 0; c < history_column_count; c++) {
+            raw.clear();
+            switch (HistoryColumn(c)) {
+            case HistoryColumn::TotalCost:
+                if (!chunk.total_costs.empty()) encode_doubles(chunk.total_costs, raw);
+                break;
+            case HistoryColumn::Objectives:
+                if (!chunk.objectives.empty()) encode_doubles(chunk.objectives, raw);
+                break;
+            case HistoryColumn::Rank:
+                if (!chunk.ranks.empty()) encode_ints(chunk.ranks, raw);
+                break;
+            case HistoryColumn::Front:
+                if (!chunk.fronts.empty()) encode_ints(chunk.fronts, raw);
+                break;
+            case HistoryColumn::Genes:
+                for (const std::string& s : chunk.genes) put_bytes(raw, s);
+                break;
+            }
+            entry.offset[c] = file_offset;
+            if (raw.empty()) continue; // absent column
+            lz_compress(raw, compressed);
+            file.write(compressed.data(), std::streamsize(compressed.size()));
+            if (!file) throw std::runtime_error("Failed to write the history file.");
+            entry.size[c] = compressed.size();
+            file_offset += compressed.size();
+        }
+        index.push_back(entry);
+    }
+};
+
+/****************************************************
+ * Random access to a history file. The file is mapped
+ * and only the footer is parsed on construction. Each
+ * query decodes exactly one column of one chunk.
+ ****************************************************/
+class PopulationHistoryReader {
+    MappedFile mapped;
+    std::vector<HistoryChunkIndex> index;
+
+public:
+    explicit PopulationHistoryReader(const std::string& path)
+        : mapped(path) {
+        const std::size_t tail_size = 8 + 4;
+        const char* begin = mapped.data();
+        std::size_t n = mapped.size();
+        if (n < 4 + tail_size || std::string(begin, 4) != history_header_magic ||
+            std::string(begin + n - 4, 4) != history_footer_magic)
+            throw std::runtime_error("Not a population history file: " + path);
+        uint64_t footer_size = get_fixed64(begin + n - tail_size);
+        if (footer_size > n - 4 - tail_size) throw std::runtime_error("Corrupted history footer: " + path);
+        const char* p = begin + n - tail_size - footer_size;
+        const char* end = begin + n - tail_size;
+        uint64_t n_chunks = get_varint(p, end);
+        index.resize(std::size_t(n_chunks));
+        for (HistoryChunkIndex& entry : index) {
+            entry.generation_step = int(zigzag_decode(get_varint(p, end)));
+            entry.n_rows = (unsigned int)get_varint(p, end);
+            entry.n_objectives = (unsigned int)get_varint(p, end);
+            for (unsigned int c = 0; c < history_column_count; c++) {
+                entry.offset[c] = get_varint(p, end);
+                entry.size[c] = get_varint(p, end);
+                if (entry.offset[c] + entry.size[c] > n - tail_size - footer_size)
+                    throw std::runtime_error("Corrupted history index: " + path);
+            }
+        }
+    }
+
+    unsigned int size() const { return (unsigned int)index.size(); }
+
+    const HistoryChunkIndex& chunk(unsigned int i) const { return index.at(i); }
+
+    int generation_step(unsigned int i) const { return chunk(i).generation_step; }
+
+    // returns the chunk index of a generation step or -1
+    int find_generation(int generation_step) const {
+        for (unsigned int i = 0; i < index.size(); i++)
+            if (index[i].generation_step == generation_step) return int(i);
+        return -1;
+    }
+
+    bool has_column(unsigned int i, HistoryColumn column) const { return chunk(i).size[unsigned(column)] > 0; }
+
+    std::vector<double> total_costs(unsigned int i) const {
+        std::vector<double> values;
+        std::string raw;
+        if (!column_bytes(i, HistoryColumn::TotalCost, raw)) return values;
+        const char* p = raw.data();
+        decode_doubles(p, p + raw.size(), values);
+        return values;
+    }
+
+    Matrix<double> objectives(unsigned int i) const {
+        const HistoryChunkIndex& entry = chunk(i);
+        Matrix<double> result;
+        std::string raw;
+        if (!column_bytes(i, HistoryColumn::Objectives, raw)) return result;
+        std::vector<double> values;
+        const char* p = raw.data();
+        decode_doubles(p, p + raw.size(), values);
+        if (values.size() != std::size_t(entry.n_rows) * entry.n_objectives)
+            throw std::runtime_error("Corrupted objective column in history file.");
+        result.zeros(entry.n_rows, entry.n_objectives);
+        for (unsigned int j = 0; j < entry.n_objectives; j++)
+            for (unsigned int r = 0; r < entry.n_rows; r++) result(r, j) = values[std::size_t(j) * entry.n_rows + r];
+        return result;
+    }
+
+    std::vector<int> ranks(unsigned int i) const { return int_column(i, HistoryColumn::Rank); }
+
+    std::vector<int> fronts(unsigned int i) const { return int_column(i, HistoryColumn::Front); }
+
+    std::vector<std::string> genes(unsigned int i) const {
+        std::vector<std::string> values;
+        std::string raw;
+        if (!column_bytes(i, HistoryColumn::Genes, raw)) return values;
+        const char* p = raw.data();
+        const char* end = p + raw.size();
+        values.reserve(chunk(i).n_rows);
+        while (p < end) values.push_back(get_bytes(p, end));
+        return values;
+    }
+
+protected:
+    bool column_bytes(unsigned int i, HistoryColumn column, std::string& raw) const {
+        const HistoryChunkIndex& entry = chunk(i);
+        uint64_t size = entry.size[unsigned(column)];
+        if (!size) return false;
+        const char* p = mapped.data() + entry.offset[unsigned(column)];
+        lz_decompress(p, p + size, raw);
+        return true;
+    }
+
+    std::vector<int> int_column(unsigned int i, HistoryColumn column) const {
+        std::vector<int> values;
+        std::string raw;
+        if (!column_bytes(i, column, raw)) return values;
+        const char* p = raw.data();
+        decode_ints(p, p + raw.size(), values);
+        return values;
+    }
+};
+
+NS_EA_END
@@ -0,0 +1,113 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <openGA.hpp>
+#include <string>
+
+struct PopulationHistoryTest : ::testing::Test {
+    using Generation = EA::GenerationType<double, double>;
+
+    void SetUp() override { path = ::testing::TempDir() + "openga_history_test.bin"; }
+    void TearDown() override { std::remove(path.c_str()); }
+
+    static Generation make_so_generation(int n, double shift) {
+        Generation g;
+        for (int i = 0; i < n; i++) {
+            Generation::ThisChromosomeType c;
+            c.genes = shift + i;
+            c.total_cost = shift + 0.5 * (n - i);
+            g.chromosomes.push_back(c);
+        }
+        for (int i = n - 1; i >= 0; i--) g.sorted_indices.push_back(i);
+        return g;
+    }
+
+    static Generation make_mo_generation() {
+        Generation g;
+        for (int i = 0; i < 4; i++) {
+            Generation::ThisChromosomeType c;
+            c.genes = i;
+            c.objectives = {double(i), double(3 - i), 1.0};
+            g.chromosomes.push_back(c);
+        }
+        g.fronts = {{0, 2}, {1}, {3}};
+        return g;
+    }
+
+    std::string path;
+};
+
+TEST(BinaryCodecTest, lzRoundTrip) {
+    std::string input;
+    for (int i = 0; i < 5000; i++) input += "abcabcabd" + std::to_string(i % 17);
+    std::string compressed, output;
+    EA::lz_compress(input, compressed);
+    EXPECT_LT(compressed.size(), input.size());
+    EA::lz_decompress(compressed.data(), compressed.data() + compressed.size(), output);
+    EXPECT_EQ(output, input);
+
+    EA::lz_compress(std::string(), compressed);
+    EA::lz_decompress(compressed.data(), compressed.data() + compressed.size(), output);
+    EXPECT_TRUE(output.empty());
+}
+
+TEST(BinaryCodecTest, doublesRoundTrip) {
+    std::vector<double> values = {0.0, -1.5, 1e300, 3.14159, 3.14159, -0.0, 42.0};
+    std::string raw;
+    EA::encode_doubles(values, raw);
+    std::vector<double> decoded;
+    const char* p = raw.data();
+    EA::decode_doubles(p, p + raw.size(), decoded);
+    EXPECT_EQ(decoded, values);
+}
+
+TEST_F(PopulationHistoryTest, singleObjective) {
+    {
+        EA::PopulationHistoryWriter<double> writer(path, 1);
+        writer.serialize_genes = [](const double& x) { return std::to_string(x); };
+        for (int step = 0; step < 10; step++) writer.append(step, make_so_generation(6, step));
+        writer.close();
+    }
+    EA::PopulationHistoryReader reader(path);
+    ASSERT_EQ(reader.size(), 10u);
+    int chunk = reader.find_generation(7);
+    ASSERT_EQ(chunk, 7);
+    EXPECT_TRUE(reader.has_column(chunk, EA::HistoryColumn::TotalCost));
+    EXPECT_FALSE(reader.has_column(chunk, EA::HistoryColumn::Objectives));
+    EXPECT_FALSE(reader.has_column(chunk, EA::HistoryColumn::Front));
+
+    Generation expected = make_so_generation(6, 7);
+    std::vector<double> costs = reader.total_costs(chunk);
+    ASSERT_EQ(costs.size(), 6u);
+    for (int i = 0; i < 6; i++) EXPECT_EQ(costs[i], expected.chromosomes[i].total_cost);
+    EXPECT_EQ(reader.ranks(chunk), (std::vector<int>{5, 4, 3, 2, 1, 0}));
+    std::vector<std::string> genes = reader.genes(chunk);
+    ASSERT_EQ(genes.size(), 6u);
+    EXPECT_EQ(genes[2], std::to_string(9.0));
+}
+
+TEST_F(PopulationHistoryTest, multiObjective) {
+    {
+        EA::PopulationHistoryWriter<double> writer(path);
+        writer.append(3, make_mo_generation());
+    }
+    EA::PopulationHistoryReader reader(path);
+    ASSERT_EQ(reader.size(), 1u);
+    EXPECT_EQ(reader.generation_step(0), 3);
+    EXPECT_FALSE(reader.has_column(0, EA::HistoryColumn::Genes));
+    EA::Matrix<double> objectives = reader.objectives(0);
+    ASSERT_EQ(objectives.get_n_rows(), 4u);
+    ASSERT_EQ(objectives.get_n_cols(), 3u);
+    EXPECT_EQ(objectives(1, 0), 1.0);
+    EXPECT_EQ(objectives(1, 1), 2.0);
+    EXPECT_EQ(reader.fronts(0), (std::vector<int>{0, 1, 0, 2}));
+}
+
+TEST_F(PopulationHistoryTest, rejectsForeignFile) {
+    {
+        std::ofstream file(path);
+        file << "step\tcost\n0\t1.0\n";
+    }
+    EXPECT_THROW(EA::PopulationHistoryReader reader(path), std::runtime_error);
+}
@@ -0,0 +1,268 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "Definitions.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+NS_EA_BEGIN
+
+// Amounts of named resources needed by one task, e.g. one license and 6 GB of memory.
+struct ResourceRequest {
+    std::vector<std::pair<unsigned int, uint64_t>> amounts; // resource id, amount
+
+    ResourceRequest& need(unsigned int resource, uint64_t amount) {
+        amounts.push_back(std::make_pair(resource, amount));
+        return *this;
+    }
+
+    bool empty() const { return amounts.empty(); }
+};
+
+class ResourceScheduler;
+
+// Resources held by a task. They are given back on destruction.
+class ResourceLease {
+    ResourceScheduler* scheduler;
+    ResourceRequest request;
+
+    friend class ResourceScheduler;
+
+public:
+    ResourceLease()
+        : scheduler(nullptr) {}
+
+    ResourceLease(ResourceLease&& other)
+        : scheduler(other.scheduler)
+        , request(std::move(other.request)) {
+        other.scheduler = nullptr;
+    }
+
+    ResourceLease& operator=(ResourceLease&& other) {
+        if (this != &other) {
+            release();
+            scheduler = other.scheduler;
+            request = std::move(other.request);
+            other.scheduler = nullptr;
+        }
+        return *this;
+    }
+
+    ResourceLease(const ResourceLease&) = delete;
+    ResourceLease& operator=(const ResourceLease&) = delete;
+
+    ~ResourceLease() { release(); }
+
+    bool holds() const { return scheduler != nullptr; }
+
+    inline void release();
+};
+
+/****************************************************
+ * Named resource pools shared by concurrent tasks.
+ * A resource is a counted semaphore, e.g. 8 licenses,
+ * or a budget, e.g. bytes of memory. A task acquires
+ * all the amounts of its request at once or waits, so
+ * tasks holding a part of their resources never block
+ * each other. Waiting tasks are granted in arrival
+ * order, but a later task which fits into the free
+ * resources may start before an earlier one which does
+ * not (backfilling), so that the resources are kept
+ * busy. After max_bypass such overtakes, the waiting
+ * task blocks the later ones until it fits, so large
+ * requests do not starve.
+ ****************************************************/
+class ResourceScheduler {
+    struct Resource {
+        std::string name;
+        uint64_t capacity;
+        uint64_t in_use = 0;
+        uint64_t peak = 0;
+        double busy_area = 0.0; // integral of in_use over time
+    };
+
+    struct Ticket {
+        const ResourceRequest* request;
+        bool granted = false;
+        unsigned int bypassed = 0;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<Resource> resources;
+    std::list<Ticket*> queue;
+    Clock::time_point start, last_change;
+    unsigned long N_granted = 0;
+    unsigned long N_waited = 0;
+    double total_wait = 0.0; // seconds
+
+public:
+    unsigned int max_bypass;
+
+    ResourceScheduler()
+        : start(Clock::now())
+        , last_change(start)
+        , max_bypass(32) {}
+
+    ResourceScheduler(const ResourceScheduler&) = delete;
+    ResourceScheduler& operator=(const ResourceScheduler&) = delete;
+
+    // returns the id of the new resource
+    unsigned int add_resource(const std::string& name, uint64_t capacity) {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (const Resource& r : resources)
+            if (r.name == name) throw std::runtime_error("Resource " + name + " is already defined.");
+        Resource r;
+        r.name = name;
+        r.capacity = capacity;
+        resources.push_back(r);
+        return (unsigned int)resources.size() - 1;
+    }
+
+    unsigned int resource_id(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (unsigned int i = 0; i < resources.size(); i++)
+            if (resources[i].name == name) return i;
+        throw std::runtime_error("Resource " + name + " is not defined.");
+    }
+
+    // blocks until all the amounts of the request are available
+    ResourceLease acquire(const ResourceRequest& request) {
+        ResourceLease lease;
+        if (request.empty()) return lease;
+        std::unique_lock<std::mutex> lock(mtx);
+        for (const auto& a : request.amounts) {
+            if (a.first >= resources.size()) throw std::runtime_error("Unknown resource id.");
+            const Resource& r = resources[a.first];
+            if (a.second > r.capacity)
+                throw std::runtime_error("The request exceeds the capacity of resource " + r.name + ".");
+        }
+        Ticket ticket;
+        ticket.request = &request;
+        queue.push_back(&ticket);
+        dispatch();
+        if (!ticket.granted) {
+            const Clock::time_point wait_start = Clock::now();
+            cv.wait(lock, [&ticket]() { return ticket.granted; });
+            N_waited++;
+            total_wait += std::chrono::duration<double>(Clock::now() - wait_start).count();
+        }
+        lease.scheduler = this;
+        lease.request = request;
+        return lease;
+    }
+
+    uint64_t capacity(unsigned int resource) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return resources.at(resource).capacity;
+    }
+
+    uint64_t in_use(unsigned int resource) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return resources.at(resource).in_use;
+    }
+
+    uint64_t peak(unsigned int resource) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return resources.at(resource).peak;
+    }
+
+    // mean share of the capacity in use since the scheduler was created
+    double utilization(unsigned int resource) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        const Resource& r = resources.at(resource);
+        const Clock::time_point now = Clock::now();
+        const double elapsed = std::chrono::duration<double>(now - start).count();
+        const double area = r.busy_area + double(r.in_use) * std::chrono::duration<double>(now - last_change).count();
+        return elapsed > 0.0 && r.capacity > 0 ? area / (elapsed * double(r.capacity)) : 0.0;
+    }
+
+    // number of requests waiting right now
+    unsigned long waiting() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return (unsigned long)queue.size();
+    }
+
+    unsigned long granted() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return N_granted;
+    }
+
+    // number of requests which had to wait and their total waiting time in seconds
+    unsigned long waited() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return N_waited;
+    }
+
+    double wait_time() const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return total_wait;
+    }
+
+private:
+    friend class ResourceLease;
+
+    bool fits(const ResourceRequest& request) const {
+        for (const auto& a : request.amounts)
+            if (resources[a.first].in_use + a.second > resources[a.first].capacity) return false;
+        return true;
+    }
+
+    void account_time() {
+        const Clock::time_point now = Clock::now();
+        const double dt = std::chrono::duration<double>(now - last_change).count();
+        for (Resource& r : resources) r.busy_area += double(r.in_use) * dt;
+        last_change = now;
+    }
+
+    // grants the waiting tickets which fit, called with mtx locked
+    void dispatch() {
+        bool any = false;
+        bool blocked = false;
+        for (auto it = queue.begin(); it != queue.end() && !blocked;) {
+            Ticket* t = *it;
+            if (!fits(*t->request)) {
+                if (t->bypassed >= max_bypass) blocked = true;
+                ++it;
+                continue;
+            }
+            if (!any) account_time();
+            for (const auto& a : t->request->amounts) {
+                Resource& r = resources[a.first];
+                r.in_use += a.second;
+                if (r.in_use > r.peak) r.peak = r.in_use;
+            }
+            for (auto earlier = queue.begin(); earlier != it; ++earlier) (*earlier)->bypassed++;
+            t->granted = true;
+            N_granted++;
+            any = true;
+            it = queue.erase(it);
+        }
+        if (any) cv.notify_all();
+    }
+
+    void give_back(const ResourceRequest& request) {
+        std::lock_guard<std::mutex> lock(mtx);
+        account_time();
+        for (const auto& a : request.amounts) resources[a.first].in_use -= a.second;
+        dispatch();
+    }
+};
+
+inline void ResourceLease::release() {
+    if (!scheduler) return;
+    scheduler->give_back(request);
+    scheduler = nullptr;
+}
+
+NS_EA_END
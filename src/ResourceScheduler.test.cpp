@@ -0,0 +1,101 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <ResourceScheduler.hpp>
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void wait_for_waiting(const EA::ResourceScheduler& scheduler, unsigned long n) {
+    while (scheduler.waiting() < n) std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+} // namespace
+
+TEST(ResourceSchedulerTest, limitsAreNeverExceeded) {
+    EA::ResourceScheduler scheduler;
+    const unsigned int license = scheduler.add_resource("license", 3);
+    const unsigned int memory = scheduler.add_resource("memory", 10);
+    std::atomic<int> licenses_used(0), memory_used(0);
+    std::atomic<bool> exceeded(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.push_back(std::thread([&, t]() {
+            for (int k = 0; k < 20; k++) {
+                const int mem = 1 + (t + k) % 6;
+                EA::ResourceRequest request;
+                request.need(license, 1).need(memory, (uint64_t)mem);
+                EA::ResourceLease lease = scheduler.acquire(request);
+                if (++licenses_used > 3) exceeded = true;
+                if ((memory_used += mem) > 10) exceeded = true;
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                licenses_used--;
+                memory_used -= mem;
+            }
+        }));
+    }
+    for (std::thread& th : threads) th.join();
+    EXPECT_FALSE(exceeded);
+    EXPECT_EQ(scheduler.granted(), 160u);
+    EXPECT_LE(scheduler.peak(license), 3u);
+    EXPECT_LE(scheduler.peak(memory), 10u);
+    EXPECT_EQ(scheduler.in_use(license), 0u);
+    EXPECT_EQ(scheduler.in_use(memory), 0u);
+    EXPECT_GT(scheduler.utilization(license), 0.0);
+    EXPECT_LE(scheduler.utilization(license), 1.0);
+}
+
+TEST(ResourceSchedulerTest, smallRequestsBackfill) {
+    EA::ResourceScheduler scheduler;
+    const unsigned int memory = scheduler.add_resource("memory", 4);
+    EA::ResourceLease held = scheduler.acquire(EA::ResourceRequest().need(memory, 3));
+    std::atomic<bool> large_done(false);
+    std::thread large([&]() {
+        EA::ResourceLease lease = scheduler.acquire(EA::ResourceRequest().need(memory, 4));
+        large_done = true;
+    });
+    wait_for_waiting(scheduler, 1);
+    {
+        // fits next to the held lease, starts before the large request
+        EA::ResourceLease small = scheduler.acquire(EA::ResourceRequest().need(memory, 1));
+        EXPECT_TRUE(small.holds());
+        EXPECT_EQ(scheduler.in_use(memory), 4u);
+    }
+    EXPECT_FALSE(large_done);
+    held.release();
+    large.join();
+    EXPECT_TRUE(large_done);
+    EXPECT_EQ(scheduler.waited(), 1u);
+}
+
+TEST(ResourceSchedulerTest, starvingRequestsBlockBackfilling) {
+    EA::ResourceScheduler scheduler;
+    scheduler.max_bypass = 0;
+    const unsigned int memory = scheduler.add_resource("memory", 4);
+    EA::ResourceLease held = scheduler.acquire(EA::ResourceRequest().need(memory, 3));
+    std::thread large([&]() { EA::ResourceLease lease = scheduler.acquire(EA::ResourceRequest().need(memory, 4)); });
+    wait_for_waiting(scheduler, 1);
+    std::atomic<bool> small_done(false);
+    std::thread small([&]() {
+        EA::ResourceLease lease = scheduler.acquire(EA::ResourceRequest().need(memory, 1));
+        small_done = true;
+    });
+    wait_for_waiting(scheduler, 2);
+    EXPECT_FALSE(small_done);
+    held.release();
+    large.join();
+    small.join();
+    EXPECT_TRUE(small_done);
+}
+
+TEST(ResourceSchedulerTest, invalidRequests) {
+    EA::ResourceScheduler scheduler;
+    const unsigned int license = scheduler.add_resource("license", 2);
+    EXPECT_THROW(scheduler.add_resource("license", 3), std::runtime_error);
+    EXPECT_THROW(scheduler.resource_id("memory"), std::runtime_error);
+    EXPECT_EQ(scheduler.resource_id("license"), license);
+    EXPECT_THROW(scheduler.acquire(EA::ResourceRequest().need(license, 3)), std::runtime_error);
+    EXPECT_FALSE(scheduler.acquire(EA::ResourceRequest()).holds());
+}
@@ -0,0 +1,196 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "openGA.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Single objective engine for small populations and
+ * evaluations of microseconds, e.g. inside a real-time
+ * controller. The members live in fixed-capacity
+ * buffers inside the object and everything runs inline
+ * on the calling thread. After solve_init, nothing is
+ * allocated on the heap as long as GeneType,
+ * MiddleCostType and the operators do not allocate
+ * (e.g. genes in a std::array).
+ *
+ * Parents are chosen by tournaments and the best
+ * `population` members of the parents and the offspring
+ * survive (mu+lambda). Survivors are not copied, only
+ * the order of the slots is sorted. The operators have
+ * the signatures of the *_bulk operators of Genetic.
+ ****************************************************/
+template<typename GeneType, typename MiddleCostType, unsigned int Capacity>
+class SmallGenetic {
+public:
+    using ThisChromosomeType = ChromosomeType<GeneType, MiddleCostType>;
+
+    unsigned int population; // at most Capacity
+    double crossover_fraction; // offspring per generation relative to the population
+    double mutation_rate;
+    unsigned int tournament_size;
+    int generation_max;
+    double tol_stall_best;
+    int best_stall_max;
+    uint64_t seed; // 0: time-dependent
+    int generation_step;
+
+    function<void(GeneType&, BulkRandom&)> init_genes;
+    function<bool(const GeneType&, MiddleCostType&)> eval_solution;
+    function<GeneType(const GeneType&, BulkRandom&, double shrink_scale)> mutate;
+    function<GeneType(const GeneType&, const GeneType&, BulkRandom&)> crossover;
+    function<double(const ThisChromosomeType&)> calculate_SO_total_fitness;
+    function<void(int, const ThisChromosomeType&)> report_generation; // optional, receives the best member
+
+private:
+    std::array<ThisChromosomeType, 2 * Capacity> members;
+    std::array<unsigned int, 2 * Capacity> order; // slots by cost, the first `population` are alive
+    unsigned int N_offspring;
+    int best_stall_count;
+    double previous_best;
+    LocalRandom rnd; // parent selection
+    BulkRandom bulk; // operators
+
+public:
+    SmallGenetic()
+        : population(30)
+        , crossover_fraction(0.7)
+        , mutation_rate(0.1)
+        , tournament_size(2)
+        , generation_max(50)
+        , tol_stall_best(1e-6)
+        , best_stall_max(10)
+        , seed(0)
+        , generation_step(-1)
+        , init_genes(nullptr)
+        , eval_solution(nullptr)
+        , mutate(nullptr)
+        , crossover(nullptr)
+        , calculate_SO_total_fitness(nullptr)
+        , report_generation(nullptr)
+        , N_offspring(0)
+        , best_stall_count(0)
+        , previous_best(0.0)
+        , rnd(0)
+        , bulk(0) {}
+
+    void check_settings() const {
+        if (population < 2) throw runtime_error("population is below 2.");
+        if (population > Capacity) throw runtime_error("population exceeds the capacity of SmallGenetic.");
+        if (crossover_fraction <= 0.0 || crossover_fraction > 1.0) throw runtime_error("Wrong crossover fractoin");
+        if (mutation_rate < 0.0 || mutation_rate > 1.0) throw runtime_error("Wrong mutation rate");
+        if (tournament_size < 1) throw runtime_error("tournament_size is below 1.");
+        if (init_genes == nullptr) throw runtime_error("init_genes is null!");
+        if (eval_solution == nullptr) throw runtime_error("eval_solution is null!");
+        if (mutate == nullptr) throw runtime_error("mutate is null!");
+        if (crossover == nullptr) throw runtime_error("crossover is null!");
+        if (calculate_SO_total_fitness == nullptr) throw runtime_error("calculate_SO_total_fitness is null!");
+    }
+
+    void solve_init() {
+        check_settings();
+        uint64_t s = seed;
+        if (s == 0) s = (uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        rnd = LocalRandom(s);
+        bulk.seed(hash_mix(s));
+        N_offspring = std::max(1u, (unsigned int)std::lround(double(population) * crossover_fraction));
+        best_stall_count = 0;
+        generation_step = 0;
+        for (unsigned int i = 0; i < 2 * Capacity; i++) order[i] = i;
+        for (unsigned int i = 0; i < population; i++) {
+            ThisChromosomeType& X = members[order[i]];
+            do init_genes(X.genes, bulk);
+            while (!eval_solution(X.genes, X.middle_costs));
+            X.total_cost = calculate_SO_total_fitness(X);
+        }
+        sort_slots(population);
+        previous_best = best().total_cost;
+        if (report_generation) report_generation(generation_step, best());
+    }
+
+    StopReason solve_next_generation() {
+        generation_step++;
+        const double scale = shrink_scale();
+        for (unsigned int k = 0; k < N_offspring; k++) {
+            ThisChromosomeType& X = members[order[population + k]];
+            do {
+                const unsigned int p1 = select_parent();
+                unsigned int p2 = select_parent();
+                if (p2 == p1) p2 = (p1 + 1 + rnd.below(population - 1)) % population;
+                X.genes = crossover(members[order[p1]].genes, members[order[p2]].genes, bulk);
+                if (bulk() < mutation_rate) X.genes = mutate(X.genes, bulk, scale);
+            } while (!eval_solution(X.genes, X.middle_costs));
+            X.total_cost = calculate_SO_total_fitness(X);
+        }
+        sort_slots(population + N_offspring);
+        if (report_generation) report_generation(generation_step, best());
+        return stop_criteria();
+    }
+
+    StopReason solve() {
+        solve_init();
+        StopReason stop = StopReason::Undefined;
+        while (stop == StopReason::Undefined) stop = solve_next_generation();
+        return stop;
+    }
+
+    const ThisChromosomeType& best() const { return members[order[0]]; }
+
+    // member of the current population by rank, 0 is the best
+    const ThisChromosomeType& member(unsigned int rank) const { return members[order[rank]]; }
+
+protected:
+    unsigned int select_parent() {
+        return tournament_select(
+            population,
+            tournament_size,
+            [this](unsigned int a, unsigned int b) {
+                return members[order[a]].total_cost < members[order[b]].total_cost;
+            },
+            rnd);
+    }
+
+    // insertion sort of the first n slots, almost sorted after the first generation
+    void sort_slots(unsigned int n) {
+        for (unsigned int i = 1; i < n; i++) {
+            const unsigned int slot = order[i];
+            const double cost = members[slot].total_cost;
+            unsigned int j = i;
+            for (; j > 0 && members[order[j - 1]].total_cost > cost; j--) order[j] = order[j - 1];
+            order[j] = slot;
+        }
+    }
+
+    // same schedule as Genetic::default_shrink_scale
+    double shrink_scale() {
+        double scale = (generation_step <= 5 ? 1.0 : 1.0 / std::sqrt(double(generation_step - 5 + 1)));
+        if (bulk() < 0.4)
+            scale *= scale;
+        else if (bulk() < 0.1)
+            scale = 1.0;
+        return scale;
+    }
+
+    StopReason stop_criteria() {
+        const double best_cost = best().total_cost;
+        if (std::abs(previous_best - best_cost) < tol_stall_best)
+            best_stall_count++;
+        else
+            best_stall_count = 0;
+        previous_best = best_cost;
+        if (generation_step >= generation_max) return StopReason::MaxGenerations;
+        if (best_stall_count >= best_stall_max) return StopReason::StallBest;
+        return StopReason::Undefined;
+    }
+};
+
+NS_EA_END
@@ -0,0 +1,97 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <SmallGenetic.hpp>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <new>
+
+namespace {
+
+std::atomic<unsigned long> N_allocations(0);
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    N_allocations++;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+using Genes = std::array<double, 2>;
+
+struct Cost {
+    double value;
+};
+
+using SmallGa = EA::SmallGenetic<Genes, Cost, 32>;
+
+void setup(SmallGa& ga) {
+    ga.population = 30;
+    ga.generation_max = 40;
+    ga.best_stall_max = 1000;
+    ga.seed = 7;
+    ga.init_genes = [](Genes& g, EA::BulkRandom& rng) { rng.uniform(g.data(), g.size(), -5.0, 5.0); };
+    ga.eval_solution = [](const Genes& g, Cost& c) {
+        c.value = (g[0] - 1.0) * (g[0] - 1.0) + (g[1] + 2.0) * (g[1] + 2.0);
+        return true;
+    };
+    ga.mutate = [](const Genes& g, EA::BulkRandom& rng, double shrink_scale) {
+        Genes y = g;
+        for (double& v : y) v += shrink_scale * (rng() - rng());
+        return y;
+    };
+    ga.crossover = [](const Genes& a, const Genes& b, EA::BulkRandom& rng) {
+        Genes y;
+        for (unsigned int i = 0; i < 2; i++) {
+            const double r = rng();
+            y[i] = r * a[i] + (1.0 - r) * b[i];
+        }
+        return y;
+    };
+    ga.calculate_SO_total_fitness = [](const SmallGa::ThisChromosomeType& X) { return X.middle_costs.value; };
+}
+
+} // namespace
+
+TEST(SmallGeneticTest, convergesWithoutAllocations) {
+    SmallGa ga;
+    setup(ga);
+    ga.solve_init();
+    const unsigned long before = N_allocations;
+    EA::StopReason stop = EA::StopReason::Undefined;
+    while (stop == EA::StopReason::Undefined) stop = ga.solve_next_generation();
+    EXPECT_EQ(N_allocations - before, 0u);
+    EXPECT_EQ(stop, EA::StopReason::MaxGenerations);
+    EXPECT_LT(ga.best().total_cost, 1e-3);
+    for (unsigned int r = 1; r < ga.population; r++)
+        EXPECT_LE(ga.member(r - 1).total_cost, ga.member(r).total_cost);
+
+    // repeated solves reuse the buffers as well
+    const unsigned long before_resolve = N_allocations;
+    ga.solve();
+    EXPECT_EQ(N_allocations - before_resolve, 0u);
+}
+
+TEST(SmallGeneticTest, sameSeedSameResult) {
+    SmallGa a, b;
+    setup(a);
+    setup(b);
+    a.solve();
+    b.solve();
+    EXPECT_EQ(a.best().genes, b.best().genes);
+}
+
+TEST(SmallGeneticTest, checksTheCapacity) {
+    SmallGa ga;
+    setup(ga);
+    ga.population = 33;
+    EXPECT_THROW(ga.solve_init(), std::runtime_error);
+}
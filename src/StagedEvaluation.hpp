@@ -0,0 +1,310 @@
+// This library is free and distributed under
+// Mozilla Public License Version 2.0.
+
+#pragma once
+#include "BinaryCodec.hpp"
+#include "Definitions.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+NS_EA_BEGIN
+
+/****************************************************
+ * Keys of gene fields for the evaluation stages, e.g.
+ *   hash_fields(genes.outline, genes.hole_count)
+ * Trivially copyable fields are hashed by their bytes,
+ * vectors and strings by their contents.
+ ****************************************************/
+template<typename T>
+typename std::enable_if<std::is_trivially_copyable<T>::value, uint64_t>::type field_hash(const T& field) {
+    return hash_bytes(&field, sizeof(T));
+}
+
+template<typename T>
+uint64_t field_hash(const std::vector<T>& field) {
+    static_assert(std::is_trivially_copyable<T>::value, "Hash the elements of the vector one by one.");
+    return hash_bytes(field.data(), field.size() * sizeof(T), field.size());
+}
+
+inline uint64_t field_hash(const std::string& field) { return hash_bytes(field.data(), field.size(), field.size()); }
+
+inline uint64_t hash_fields() { return 0x2545f4914f6cdd1dULL; }
+
+template<typename T, typename... Rest>
+uint64_t hash_fields(const T& first, const Rest&... rest) {
+    return hash_combine(hash_fields(rest...), field_hash(first));
+}
+
+// Outputs of the stages run for one gene.
+class StageResults {
+    std::vector<std::shared_ptr<const void>> outputs;
+
+    template<typename GeneType>
+    friend class StagedEvaluation;
+
+public:
+    std::size_t size() const { return outputs.size(); }
+
+    // T is the output type the stage was added with
+    template<typename T>
+    const T& get(unsigned int stage) const {
+        if (stage >= outputs.size() || !outputs[stage]) throw std::runtime_error("Stage output is not available.");
+        return *static_cast<const T*>(outputs[stage].get());
+    }
+};
+
+struct StageStats {
+    std::string name;
+    unsigned long lookups = 0;
+    unsigned long hits = 0; // the output was cached
+    unsigned long joined = 0; // another thread was computing the same output and it was waited for
+    unsigned long misses = 0; // the stage was run
+    unsigned long evictions = 0;
+    std::size_t entries = 0;
+    double compute_time = 0.0; // seconds spent in the stage
+    double saved_time = 0.0; // estimate: hits and joins times the mean compute time
+
+    double hit_rate() const { return lookups ? double(hits + joined) / double(lookups) : 0.0; }
+};
+
+/****************************************************
+ * Bounded concurrent cache of stage outputs. The keys
+ * are split into shards with their own lock and least
+ * recently used list. An output which is being
+ * computed is in the cache as a future, so concurrent
+ * requests for the same key wait for one computation
+ * instead of running the stage again.
+ ****************************************************/
+class StageCache {
+public:
+    using Output = std::shared_ptr<const void>;
+
+private:
+    struct Entry {
+        std::shared_future<Output> output;
+        std::list<uint64_t>::iterator lru;
+    };
+
+    struct Shard {
+        std::mutex mtx;
+        std::unordered_map<uint64_t, Entry> entries;
+        std::list<uint64_t> lru; // front: most recently used
+    };
+
+    static const unsigned int N_shards = 16;
+    mutable std::vector<Shard> shards;
+    std::size_t shard_capacity;
+
+public:
+    std::atomic<unsigned long> n_lookups;
+    std::atomic<unsigned long> n_hits;
+    std::atomic<unsigned long> n_joined;
+    std::atomic<unsigned long> n_misses;
+    std::atomic<unsigned long> n_evictions;
+
+    // capacity: maximum number of outputs kept (rounded up to a multiple of the shards), 0: nothing is kept
+    explicit StageCache(std::size_t capacity)
+        : shards(N_shards)
+        , shard_capacity((capacity + N_shards - 1) / N_shards)
+        , n_lookups(0)
+        , n_hits(0)
+        , n_joined(0)
+        , n_misses(0)
+        , n_evictions(0) {}
+
+    // returns the cached output for key or the one computed by compute()
+    template<typename F>
+    Output get_or_compute(uint64_t key, F compute) {
+        n_lookups++;
+        if (shard_capacity == 0) {
+            n_misses++;
+            return compute();
+        }
+        Shard& shard = shard_of(key);
+        std::shared_future<Output> cached;
+        std::promise<Output> promise;
+        {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            auto it = shard.entries.find(key);
+            if (it != shard.entries.end()) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru);
+                cached = it->second.output;
+                const bool ready = cached.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                (ready ? n_hits : n_joined)++;
+            }
+            else {
+                n_misses++;
+                shard.lru.push_front(key);
+                Entry entry;
+                entry.output = promise.get_future().share();
+                entry.lru = shard.lru.begin();
+                shard.entries.emplace(key, entry);
+                while (shard.entries.size() > shard_capacity) {
+                    shard.entries.erase(shard.lru.back());
+                    shard.lru.pop_back();
+                    n_evictions++;
+                }
+            }
+        }
+        if (cached.valid()) return cached.get();
+        try {
+            Output result = compute();
+            promise.set_value(result);
+            return result;
+        }
+        catch (...) {
+            promise.set_exception(std::current_exception());
+            forget(key);
+            throw;
+        }
+    }
+
+    std::size_t size() const {
+        std::size_t n = 0;
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            n += shard.entries.size();
+        }
+        return n;
+    }
+
+    void clear() {
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard.mtx);
+            shard.entries.clear();
+            shard.lru.clear();
+        }
+    }
+
+private:
+    Shard& shard_of(uint64_t key) const { return shards[hash_mix(key) % N_shards]; }
+
+    // drops a failed computation so that it is tried again next time
+    void forget(uint64_t key) {
+        Shard& shard = shard_of(key);
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) return;
+        shard.lru.erase(it->second.lru);
+        shard.entries.erase(it);
+    }
+};
+
+/****************************************************
+ * Evaluation split into stages, e.g. meshing the
+ * geometry and then simulating the mesh. Every stage
+ * declares the gene fields it depends on through its
+ * key function (see hash_fields) and the earlier
+ * stages whose outputs it reads. Its output is cached
+ * under the key combined with the keys of these input
+ * stages, so an offspring which shares the fields with
+ * an earlier member skips the stage. run() is thread
+ * safe and returns the outputs of all stages.
+ ****************************************************/
+template<typename GeneType>
+class StagedEvaluation {
+    using Clock = std::chrono::steady_clock;
+
+    struct Stage {
+        std::string name;
+        std::function<uint64_t(const GeneType&)> key;
+        std::function<StageCache::Output(const GeneType&, const StageResults&)> compute;
+        std::vector<unsigned int> inputs;
+        StageCache cache;
+        std::atomic<uint64_t> compute_ns;
+
+        Stage(std::size_t capacity)
+            : cache(capacity)
+            , compute_ns(0) {}
+    };
+
+    std::vector<std::unique_ptr<Stage>> stages;
+
+public:
+    /****************************************************
+     * Adds a stage with output type T and returns its id.
+     * compute receives the genes and the outputs of the
+     * earlier stages, of which inputs lists the ones it
+     * reads. About capacity outputs are kept.
+     ****************************************************/
+    template<typename T>
+    unsigned int add_stage(
+        const std::string& name,
+        std::function<uint64_t(const GeneType&)> key,
+        std::function<T(const GeneType&, const StageResults&)> compute,
+        std::size_t capacity,
+        const std::vector<unsigned int>& inputs = {}) {
+        if (!key || !compute) throw std::runtime_error("Stage " + name + " needs a key and a compute function.");
+        for (unsigned int input : inputs)
+            if (input >= stages.size()) throw std::runtime_error("Stage " + name + " reads a later stage.");
+        std::unique_ptr<Stage> stage(new Stage(capacity));
+        stage->name = name;
+        stage->key = key;
+        stage->inputs = inputs;
+        stage->compute = [compute](const GeneType& genes, const StageResults& results) -> StageCache::Output {
+            return std::make_shared<T>(compute(genes, results));
+        };
+        stages.push_back(std::move(stage));
+        return (unsigned int)stages.size() - 1;
+    }
+
+    std::size_t N_stages() const { return stages.size(); }
+
+    StageResults run(const GeneType& genes) {
+        StageResults results;
+        results.outputs.resize(stages.size());
+        std::vector<uint64_t> keys(stages.size());
+        for (std::size_t s = 0; s < stages.size(); s++) {
+            Stage& stage = *stages[s];
+            uint64_t key = stage.key(genes);
+            for (unsigned int input : stage.inputs) key = hash_combine(key, keys[input]);
+            keys[s] = key;
+            results.outputs[s] = stage.cache.get_or_compute(key, [&]() {
+                const Clock::time_point start = Clock::now();
+                StageCache::Output output = stage.compute(genes, results);
+                const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+                stage.compute_ns += uint64_t(elapsed.count());
+                return output;
+            });
+        }
+        return results;
+    }
+
+    std::vector<StageStats> stats() const {
+        std::vector<StageStats> all;
+        for (const std::unique_ptr<Stage>& stage : stages) {
+            StageStats s;
+            s.name = stage->name;
+            s.lookups = stage->cache.n_lookups;
+            s.hits = stage->cache.n_hits;
+            s.joined = stage->cache.n_joined;
+            s.misses = stage->cache.n_misses;
+            s.evictions = stage->cache.n_evictions;
+            s.entries = stage->cache.size();
+            s.compute_time = double(stage->compute_ns) * 1e-9;
+            if (s.misses > 0) s.saved_time = s.compute_time / double(s.misses) * double(s.hits + s.joined);
+            all.push_back(s);
+        }
+        return all;
+    }
+
+    // forgets all cached outputs, e.g. after the problem data has changed
+    void clear() {
+        for (std::unique_ptr<Stage>& stage : stages) stage->cache.clear();
+    }
+};
+
+NS_EA_END
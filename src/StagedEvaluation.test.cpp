@@ -0,0 +1,124 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <StagedEvaluation.hpp>
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Design {
+    std::vector<double> outline; // meshed
+    int material; // only simulated
+};
+
+struct Fixture {
+    EA::StagedEvaluation<Design> stages;
+    std::atomic<int> meshed, simulated;
+    unsigned int mesh, simulation;
+
+    explicit Fixture(std::size_t capacity)
+        : meshed(0)
+        , simulated(0) {
+        mesh = stages.add_stage<std::vector<double>>(
+            "mesh", [](const Design& d) { return EA::hash_fields(d.outline); },
+            [this](const Design& d, const EA::StageResults&) {
+                meshed++;
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                std::vector<double> nodes(d.outline);
+                nodes.push_back(0.0);
+                return nodes;
+            },
+            capacity);
+        simulation = stages.add_stage<double>(
+            "simulation", [](const Design& d) { return EA::hash_fields(d.material); },
+            [this](const Design& d, const EA::StageResults& r) {
+                simulated++;
+                double sum = 0.0;
+                for (double x : r.get<std::vector<double>>(mesh)) sum += x;
+                return sum * d.material;
+            },
+            capacity, {mesh});
+    }
+};
+
+} // namespace
+
+TEST(StagedEvaluationTest, sharedFieldsSkipTheStage) {
+    Fixture f(64);
+    EA::StageResults r = f.stages.run({{1.0, 2.0}, 2});
+    EXPECT_EQ(r.get<double>(f.simulation), 6.0);
+    EXPECT_EQ(r.get<std::vector<double>>(f.mesh).size(), 3u);
+    r = f.stages.run({{1.0, 2.0}, 3}); // same outline, new material
+    EXPECT_EQ(r.get<double>(f.simulation), 9.0);
+    r = f.stages.run({{1.0, 2.0}, 2});
+    r = f.stages.run({{1.0, 3.0}, 2}); // the simulation depends on the mesh
+    EXPECT_EQ(r.get<double>(f.simulation), 8.0);
+    EXPECT_EQ(f.meshed, 2);
+    EXPECT_EQ(f.simulated, 3);
+
+    std::vector<EA::StageStats> stats = f.stages.stats();
+    ASSERT_EQ(stats.size(), 2u);
+    EXPECT_EQ(stats[0].name, "mesh");
+    EXPECT_EQ(stats[0].lookups, 4u);
+    EXPECT_EQ(stats[0].hits, 2u);
+    EXPECT_EQ(stats[0].misses, 2u);
+    EXPECT_EQ(stats[1].hits, 1u);
+    EXPECT_EQ(stats[1].entries, 3u);
+    EXPECT_GT(stats[0].compute_time, 0.0);
+    EXPECT_GT(stats[0].saved_time, 0.0);
+    EXPECT_DOUBLE_EQ(stats[0].hit_rate(), 0.5);
+}
+
+TEST(StagedEvaluationTest, cacheIsBounded) {
+    Fixture f(16);
+    for (int i = 0; i < 100; i++) f.stages.run({{double(i)}, 1});
+    std::vector<EA::StageStats> stats = f.stages.stats();
+    EXPECT_LE(stats[0].entries, 16u);
+    EXPECT_EQ(stats[0].evictions, 100u - stats[0].entries);
+
+    Fixture uncached(0);
+    uncached.stages.run({{1.0}, 1});
+    uncached.stages.run({{1.0}, 1});
+    EXPECT_EQ(uncached.meshed, 2);
+}
+
+TEST(StagedEvaluationTest, concurrentRequestsComputeOnce) {
+    Fixture f(64);
+    std::vector<std::thread> threads;
+    std::atomic<int> wrong(0);
+    for (int t = 0; t < 8; t++)
+        threads.push_back(std::thread([&]() {
+            for (int k = 0; k < 4; k++)
+                if (f.stages.run({{1.0, 1.0}, k}).get<double>(f.simulation) != 2.0 * k) wrong++;
+        }));
+    for (std::thread& th : threads) th.join();
+    EXPECT_EQ(wrong, 0);
+    EXPECT_EQ(f.meshed, 1);
+    EXPECT_EQ(f.simulated, 4);
+    std::vector<EA::StageStats> stats = f.stages.stats();
+    EXPECT_EQ(stats[0].hits + stats[0].joined, 31u);
+}
+
+TEST(StagedEvaluationTest, failuresAreNotCached) {
+    EA::StagedEvaluation<int> stages;
+    int calls = 0;
+    stages.add_stage<int>(
+        "flaky", [](int x) { return EA::hash_fields(x); },
+        [&calls](int x, const EA::StageResults&) {
+            if (++calls == 1) throw std::runtime_error("solver crashed");
+            return x + 1;
+        },
+        8);
+    EXPECT_THROW(stages.run(1), std::runtime_error);
+    EXPECT_EQ(stages.run(1).get<int>(0), 2);
+    EXPECT_EQ(stages.run(1).get<int>(0), 2);
+    EXPECT_EQ(calls, 2);
+    EXPECT_THROW(stages.add_stage<int>("late", [](int) { return uint64_t(0); },
+                     [](int, const EA::StageResults&) { return 0; }, 8, {3}),
+        std::runtime_error);
+    EXPECT_NE(EA::hash_fields(1, 2), EA::hash_fields(2, 1));
+    EXPECT_NE(EA::hash_fields(std::string("ab")), EA::hash_fields(std::string("ba")));
+}
@@ -2,8 +2,28 @@
 // Mozilla Public License Version 2.0.
 
 #pragma once
+#include "BulkRandom.hpp"
+#include "Dataset.hpp"
 #include "Definitions.hpp"
+#include "Diversity.hpp"
+#include "DominanceGraph.hpp"
+#include "EDA.hpp"
+#include "EvaluationStore.hpp"
+#include "EvaluationTrace.hpp"
+#include "FingerprintSet.hpp"
+#include "GenerationArchive.hpp"
+#include "GeneStore.hpp"
+#include "GradientMutation.hpp"
+#include "IGAPipeline.hpp"
 #include "Matrix.hpp"
+#include "MiddleCostRetention.hpp"
+#include "NoisyEvaluation.hpp"
+#include "ObjectiveReduction.hpp"
+#include "ParentSelection.hpp"
+#include "PerfCounters.hpp"
+#include "PopulationHistory.hpp"
+#include "ResourceScheduler.hpp"
+#include "StagedEvaluation.hpp"
 #include <algorithm>
 #include <assert.h>
 #include <atomic>
@@ -12,6 +32,7 @@
 #include <functional>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <mutex>
 #include <random>
 #include <stdexcept>
@@ -31,12 +52,23 @@ using std::vector;
 
 enum class GaMode { SOGA, IGA, NSGA_III };
 
+// diversity injected by notify_problem_changed()
+enum class ChangeResponse { None, RandomImmigrants, Hypermutation };
+
+// taken when the mean pairwise distance falls below diversity_threshold
+enum class DiversityAction { None, RaiseMutation, Immigrants, Stop };
+
 template<typename GeneType, typename MiddleCostType>
 struct ChromosomeType {
     GeneType genes;
     MiddleCostType middle_costs; // individual costs
+    vector<double> gradient; // of the total cost by the genes, from eval_solution_gradient
     double total_cost; // for single objective
     vector<double> objectives; // for multi-objective
+    RunningStats cost_samples; // total costs of the replications, for noisy evaluations
+    int birth = 0; // generation in which the oldest ancestor was created, for the age-layered mode
+    uint64_t serial = 0; // identity given in finalize_objectives and kept by the copies, for generation snapshots
+    RetainedMiddleCosts retained; // where the middle costs are, see Genetic::middle_cost_retention
 };
 
 template<typename GeneType, typename MiddleCostType>
@@ -51,6 +83,11 @@ struct GenerationType {
     vector<int> sorted_indices; // for single objective
     vector<vector<unsigned int>> fronts; // for multi-objective
     vector<double> selection_chance_cumulative;
+    vector<int> ranks; // 0 is the best
+    vector<double> crowding_distance; // for crowded tournament selection
+    vector<vector<unsigned int>> layers; // member indices per age layer, for the age-layered mode
+    PerfMetrics perf; // filled if collect_perf_counters is set
+    DiversityMetrics diversity; // measured if embed_genes or distance_genes is set
     double exe_time;
 };
 
@@ -84,7 +121,7 @@ inline int fast_combination_count(int N, int r) {
     return nCr;
 }
 
-enum class StopReason { Undefined, MaxGenerations, StallAverage, StallBest, UserRequest };
+enum class StopReason { Undefined, MaxGenerations, StallAverage, StallBest, UserRequest, DiversityCollapse };
 
 class Chronometer {
 protected:
@@ -120,6 +157,22 @@ private:
     vector<double> scalarized_objectives_min; // for multi-objective
     Matrix<double> reference_vectors;
     unsigned int N_robj;
+    std::shared_ptr<IGAPipeline<ChromosomeType<GeneType, MiddleCostType>>> iga_pipeline;
+    std::shared_ptr<FingerprintSet> duplicate_fingerprints;
+    std::shared_ptr<ParentBatch> parent_batch; // parents of the offspring being bred, see draw_parent_batch
+    unsigned int parent_lookahead; // pairs bred at the same time as the one taken from parent_batch
+    uint64_t crn_seed; // common random numbers of noisy evaluations
+    int noise_budget_step; // generation_step which spent the noise_replications_budget, -1: none
+    uint64_t problem_changes; // calls of notify_problem_changed, part of the evaluation_store keys
+    int history_step_offset; // the history continues its step count over problem changes
+    DominanceGraph dominance_graph; // relations of last_generation, for incremental_MO_ranking
+    std::shared_ptr<PerfWorkerCounters> perf_workers; // set if collect_perf_counters
+    double mutation_boost; // factor of mutation_rate raised by DiversityAction::RaiseMutation
+    bool diversity_collapsed; // last generation is below diversity_threshold
+    std::shared_ptr<DistributionModel> eda_model; // fitted in the estimation-of-distribution mode
+    ObjectiveReduction active_objectives; // objectives used by the selection, see objective_reduction
+    bool auto_reference_divisions; // reference_vector_divisions was 0 in solve_init
+    uint64_t last_serial; // of the chromosomes
 
 public:
     using ThisType = Genetic<GeneType, MiddleCostType>;
@@ -143,27 +196,96 @@ public:
     int best_stall_max;
     unsigned int reference_vector_divisions;
     bool enable_reference_vectors;
+    vector<vector<double>> aspiration_points; // R-NSGA-III: preferred (reduced) objective vectors, empty: off
+    double aspiration_spread; // size of the reference direction patch around an aspiration point, (0,1]
+    unsigned int aspiration_divisions; // directions per patch (as reference_vector_divisions), 0: fill population
     bool multi_threading;
     bool dynamic_threading;
     int N_threads;
     bool user_request_stop;
     long idle_delay_us;
     bool use_quick_sort = true;
+    bool IGA_pipeline; // non-blocking interactive mode
+    int IGA_speculative_candidates; // -1: one generation of offspring
+    bool eliminate_duplicates; // requires hash_genes
+    int duplicate_memory; // number of past generations searched for duplicates
+    int duplicate_retry_max;
+    bool incremental_MO_ranking; // keep the domination relations of the survivors
+    SelectionStrategy selection_strategy; // parent selection
+    unsigned int tournament_size;
+    unsigned int noise_min_replications; // for eval_solution_noisy
+    unsigned int noise_max_replications;
+    int noise_replications_budget; // extra replications per generation, -1: population
+    uint64_t noise_seed; // base seed of the replications, 0: random
+    ChangeResponse change_response; // for dynamic optimization
+    double change_diversity_fraction; // share of the population replaced on a problem change
+    bool collect_perf_counters; // hardware counters per phase and worker thread in GenerationType::perf
+    unsigned int ALPS_layers; // age-layered population (SOGA) with population members per layer, 0: off
+    unsigned int ALPS_age_gap; // generations between reseeds of the bottom layer
+    double gradient_mutation_rate; // share of the offspring bred by mutate_gradient
+    unsigned int diversity_pair_samples; // member pairs sampled for the mean pairwise distance
+    double diversity_threshold; // mean pairwise distance below which diversity_action is taken, 0: off
+    DiversityAction diversity_action;
+    double diversity_immigrant_fraction; // share of the population replaced by DiversityAction::Immigrants
+    bool prefetch_evaluation_data; // load the pages of the evaluation_context datasets in solve_init
+    EDAMode eda_mode; // breed by sampling a distribution model instead of crossover and mutation
+    vector<unsigned int> eda_cardinality; // number of values of every eda_encode variable, empty: all binary
+    double eda_selection_fraction; // share of the ranked population the model is fitted to
+    double PBIL_learning_rate;
+    double eda_probability_margin; // minimum probability of every value of a variable
+    double linkage_threshold; // normalized mutual information for linking variables in EDAMode::LinkageTree
+    unsigned int linkage_max_block; // maximum number of variables sampled jointly
+    ObjectiveReductionMode objective_reduction; // online reduction of redundant objectives (MOGA)
+    unsigned int objective_reduction_interval; // generations between the analyses of the first front
+    double objective_correlation_threshold; // correlation on the front above which objectives are redundant
+    vector<ObjectiveReductionRecord> objective_reduction_log;
+    double replay_latency_scale; // share of the recorded evaluation time a replayed evaluation waits, 0: none
+    TraceMiss replay_miss; // served for genes which are not in evaluation_replay
+    uint64_t random_seed; // seeds the random generator in solve_init, 0: time-dependent seed
+    MiddleCostRetention middle_cost_retention; // applied to the middle costs after finalize_objectives
     vector<GeneType> user_initial_solutions;
 
     function<void(ThisGenerationType&)> calculate_IGA_total_fitness;
+    function<void(unsigned int, const ThisChromosomeType&)> IGA_present_candidate;
     function<double(const ThisChromosomeType&)> calculate_SO_total_fitness;
     function<vector<double>(ThisChromosomeType&)> calculate_MO_objectives;
     function<vector<double>(const vector<double>&)> distribution_objective_reductions;
     function<void(GeneType&, const function<double(void)>& rnd01)> init_genes;
+    function<void(GeneType&, BulkRandom& rng)> init_genes_bulk; // alternative to init_genes
     function<bool(const GeneType&, MiddleCostType&)> eval_solution;
+    function<bool(const GeneType&, MiddleCostType&, uint64_t seed)> eval_solution_noisy; // alternative to eval_solution
+    function<bool(const GeneType&, MiddleCostType&, vector<double>& gradient)> eval_solution_gradient; // alternative
+    function<bool(const GeneType&, MiddleCostType&, const EvaluationContext&)> eval_solution_context; // alternative
+    function<bool(const GeneType&, MiddleCostType&, const StageResults&)> eval_solution_staged; // alternative
     function<bool(const GeneType&, MiddleCostType&, const ThisGenerationType&)> eval_solution_IGA;
     function<GeneType(const GeneType&, const function<double(void)>& rnd01, double shrink_scale)> mutate;
     function<GeneType(const GeneType&, const GeneType&, const function<double(void)>& rnd01)> crossover;
+    function<GeneType(const GeneType&, BulkRandom& rng, double shrink_scale)> mutate_bulk; // alternative to mutate
+    function<GeneType(const GeneType&, const GeneType&, BulkRandom& rng)> crossover_bulk; // alternative to crossover
+    function<GeneType(const ThisChromosomeType&, BulkRandom& rng, double shrink_scale)> mutate_gradient;
     function<void(int, const ThisGenerationType&, const GeneType&)> SO_report_generation;
     function<void(int, const ThisGenerationType&, const vector<unsigned int>&)> MO_report_generation;
     function<void(void)> custom_refresh;
     function<double(int, const function<double(void)>& rnd01)> get_shrink_scale;
+    function<bool(const ThisChromosomeType&)> is_affected_by_change; // nullptr: every member is affected
+    function<uint64_t(const GeneType&)> hash_genes;
+    function<void(const GeneType&, vector<double>&)> embed_genes; // numeric view of the genes for the diversity metrics
+    function<double(const GeneType&, const GeneType&)> distance_genes; // optional, else distance of the embeddings
+    function<void(const GeneType&)> prefetch_genes; // e.g. for genes kept in a GeneStore
+    function<void(const GeneType&, vector<unsigned int>&)> eda_encode; // genes to categorical variables
+    function<void(const vector<unsigned int>&, GeneType&)> eda_decode;
+    function<ResourceRequest(const GeneType&)> eval_resources; // held from resource_scheduler during an evaluation
+    function<std::string(const MiddleCostType&)> serialize_middle_costs;
+    function<bool(const std::string&, MiddleCostType&)> deserialize_middle_costs;
+    std::shared_ptr<EvaluationStore> evaluation_store; // optional persistent cache of eval_solution results
+    std::shared_ptr<PopulationHistoryWriter<GeneType>> history_writer; // optional binary trace of all generations
+    std::shared_ptr<GenerationArchive<ThisGenerationType>> generation_archive; // optional snapshots in memory
+    std::shared_ptr<ResourceScheduler> resource_scheduler; // limits concurrent evaluations, see eval_resources
+    std::shared_ptr<const EvaluationContext> evaluation_context; // datasets passed to eval_solution_context
+    std::shared_ptr<StagedEvaluation<GeneType>> evaluation_stages; // run before eval_solution_staged
+    std::shared_ptr<EvaluationTraceWriter> evaluation_recorder; // records every evaluation with its time
+    std::shared_ptr<EvaluationTrace> evaluation_replay; // serves recorded evaluations instead of eval_solution
+    std::shared_ptr<SpillStore> middle_cost_spill; // for MiddleCostRetention::Spill
     vector<ThisGenSOAbs> generations_so_abs;
     ThisGenerationType last_generation;
 
@@ -172,6 +294,15 @@ public:
     Genetic()
         : unif_dist(0.0, 1.0)
         , N_robj(0)
+        , parent_lookahead(1)
+        , crn_seed(0)
+        , noise_budget_step(-1)
+        , problem_changes(0)
+        , history_step_offset(0)
+        , mutation_boost(1.0)
+        , diversity_collapsed(false)
+        , auto_reference_divisions(false)
+        , last_serial(0)
         , problem_mode(GaMode::SOGA)
         , population(50)
         , crossover_fraction(0.7)
@@ -186,24 +317,90 @@ public:
         , best_stall_max(10)
         , reference_vector_divisions(0)
         , enable_reference_vectors(true)
+        , aspiration_spread(0.1)
+        , aspiration_divisions(0)
         , multi_threading(true)
         , dynamic_threading(true)
         , N_threads(std::thread::hardware_concurrency())
         , user_request_stop(false)
         , idle_delay_us(1000)
+        , IGA_pipeline(false)
+        , IGA_speculative_candidates(-1)
+        , eliminate_duplicates(false)
+        , duplicate_memory(2)
+        , duplicate_retry_max(5)
+        , incremental_MO_ranking(false)
+        , selection_strategy(SelectionStrategy::Roulette)
+        , tournament_size(2)
+        , noise_min_replications(2)
+        , noise_max_replications(30)
+        , noise_replications_budget(-1)
+        , noise_seed(0)
+        , change_response(ChangeResponse::RandomImmigrants)
+        , change_diversity_fraction(0.2)
+        , collect_perf_counters(false)
+        , ALPS_layers(0)
+        , ALPS_age_gap(10)
+        , gradient_mutation_rate(0.5)
+        , diversity_pair_samples(256)
+        , diversity_threshold(0.0)
+        , diversity_action(DiversityAction::None)
+        , diversity_immigrant_fraction(0.2)
+        , prefetch_evaluation_data(false)
+        , eda_mode(EDAMode::Off)
+        , eda_selection_fraction(0.5)
+        , PBIL_learning_rate(0.1)
+        , eda_probability_margin(0.0)
+        , linkage_threshold(0.2)
+        , linkage_max_block(8)
+        , objective_reduction(ObjectiveReductionMode::Off)
+        , objective_reduction_interval(10)
+        , objective_correlation_threshold(0.95)
+        , replay_latency_scale(0.0)
+        , replay_miss(TraceMiss::Substitute)
+        , random_seed(0)
+        , middle_cost_retention(MiddleCostRetention::Keep)
         , calculate_IGA_total_fitness(nullptr)
+        , IGA_present_candidate(nullptr)
         , calculate_SO_total_fitness(nullptr)
         , calculate_MO_objectives(nullptr)
         , distribution_objective_reductions(nullptr)
         , init_genes(nullptr)
+        , init_genes_bulk(nullptr)
         , eval_solution(nullptr)
+        , eval_solution_noisy(nullptr)
+        , eval_solution_gradient(nullptr)
+        , eval_solution_context(nullptr)
+        , eval_solution_staged(nullptr)
         , eval_solution_IGA(nullptr)
         , mutate(nullptr)
         , crossover(nullptr)
+        , mutate_bulk(nullptr)
+        , crossover_bulk(nullptr)
+        , mutate_gradient(nullptr)
         , SO_report_generation(nullptr)
         , MO_report_generation(nullptr)
         , custom_refresh(nullptr)
-        , get_shrink_scale(default_shrink_scale) {
+        , get_shrink_scale(default_shrink_scale)
+        , is_affected_by_change(nullptr)
+        , hash_genes(nullptr)
+        , embed_genes(nullptr)
+        , distance_genes(nullptr)
+        , prefetch_genes(nullptr)
+        , eda_encode(nullptr)
+        , eda_decode(nullptr)
+        , eval_resources(nullptr)
+        , serialize_middle_costs(nullptr)
+        , deserialize_middle_costs(nullptr)
+        , evaluation_store(nullptr)
+        , history_writer(nullptr)
+        , generation_archive(nullptr)
+        , resource_scheduler(nullptr)
+        , evaluation_context(nullptr)
+        , evaluation_stages(nullptr)
+        , evaluation_recorder(nullptr)
+        , evaluation_replay(nullptr)
+        , middle_cost_spill(nullptr) {
         // initialize the random number generator with time-dependent seed
         uint64_t timeSeed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
         std::seed_seq ss{uint32_t(timeSeed & 0xffffffff), uint32_t(timeSeed >> 32)};
@@ -221,16 +418,56 @@ public:
 
     void calculate_N_robj(const ThisGenerationType& g) {
         if (!g.chromosomes.size()) throw runtime_error("Code should not reach here. A87946516564");
-        if (distribution_objective_reductions)
-            N_robj = (unsigned int)distribution_objective_reductions(g.chromosomes[0].objectives).size();
-        else
-            N_robj = (unsigned int)g.chromosomes[0].objectives.size();
+        N_robj = (unsigned int)reduced_objectives(g.chromosomes[0].objectives).size();
         if (!N_robj) throw runtime_error("Number of the reduced objective is zero");
     }
 
+    // objectives of the reference vector selection: distribution_objective_reductions or the active objectives
+    vector<double> reduced_objectives(const vector<double>& objectives) const {
+        if (distribution_objective_reductions) return distribution_objective_reductions(objectives);
+        return active_objectives.apply(objectives);
+    }
+
+    // the fewest divisions which give more reference vectors than the population
+    void set_reference_divisions() {
+        reference_vector_divisions = 2;
+        if (N_robj == 1) throw runtime_error("The length of objective vector is 1 in a multi-objective optimization");
+        while (get_number_reference_vectors(N_robj, reference_vector_divisions + 1) <= (int)population)
+            reference_vector_divisions++;
+        if (verbose) {
+            cout << "**************************************" << endl;
+            cout << "reference_vector_divisions: " << reference_vector_divisions << endl;
+            cout << "**************************************" << endl;
+        }
+    }
+
     void solve_init() {
         check_settings();
+        if (random_seed) rng.seed(random_seed);
+        iga_pipeline = nullptr;
+        if (is_interactive() && IGA_pipeline) {
+            iga_pipeline = std::make_shared<IGAPipeline<ThisChromosomeType>>();
+            iga_pipeline->present = IGA_present_candidate;
+        }
+        crn_seed = noise_seed;
+        noise_budget_step = -1;
+        if (crn_seed == 0) {
+            std::lock_guard<std::mutex> lock(mtx_rand);
+            crn_seed = rng();
+        }
+        duplicate_fingerprints = nullptr;
+        if (eliminate_duplicates) duplicate_fingerprints = std::make_shared<FingerprintSet>();
+        mutation_boost = 1.0;
+        diversity_collapsed = false;
+        eda_model = nullptr;
+        active_objectives = ObjectiveReduction();
+        objective_reduction_log.clear();
+        if (prefetch_evaluation_data && evaluation_context)
+            evaluation_context->prefetch(multi_threading ? N_threads : 1);
+        perf_workers = nullptr;
+        if (collect_perf_counters) perf_workers = std::make_shared<PerfWorkerCounters>();
         // shrink_scale=1.0;
+        history_step_offset = 0;
         average_stall_count = 0;
         best_stall_count = 0;
         generation_step = -1;
@@ -249,28 +486,33 @@ public:
         timer.tic();
 
         ThisGenerationType generation0;
+        PerfMetrics perf;
+        PerfCounterValues perf_mark = perf_read();
         init_population(generation0);
+        if (ALPS_layers) {
+            generation0.layers.assign(1, vector<unsigned int>());
+            for (unsigned int i = 0; i < generation0.chromosomes.size(); i++) generation0.layers[0].push_back(i);
+        }
+        perf_phase(perf, EnginePhase::Offspring, perf_mark);
 
         generation_step = 0;
         finalize_objectives(generation0);
+        perf_phase(perf, EnginePhase::Objectives, perf_mark);
 
         if (!is_single_objective()) {
             calculate_N_robj(generation0);
-            if (!reference_vector_divisions) {
-                reference_vector_divisions = 2;
-                if (N_robj == 1)
-                    throw runtime_error("The length of objective vector is 1 in a multi-objective optimization");
-                while (get_number_reference_vectors(N_robj, reference_vector_divisions + 1) <= (int)population)
-                    reference_vector_divisions++;
-                if (verbose) {
-                    cout << "**************************************" << endl;
-                    cout << "reference_vector_divisions: " << reference_vector_divisions << endl;
-                    cout << "**************************************" << endl;
-                }
-            }
+            auto_reference_divisions = !reference_vector_divisions;
+            if (auto_reference_divisions) set_reference_divisions();
+            for (const vector<double>& z : aspiration_points)
+                if (z.size() != N_robj)
+                    throw runtime_error("An aspiration point does not have the length of the reduced objectives.");
         }
+        dominance_graph.clear();
+        perf_mark = perf_read();
         rank_population(generation0); // used for ellite tranfre, crossover and mutation
+        perf_phase(perf, EnginePhase::Ranking, perf_mark);
         finalize_generation(generation0);
+        perf_collect(perf, generation0);
         if (!is_single_objective()) { // muti-objective
             update_ideal_objectives(generation0, true);
             extreme_objectives.clear();
@@ -280,6 +522,7 @@ public:
         if (!user_request_stop) {
             generations_so_abs.push_back(ThisGenSOAbs(generation0));
             report_generation(generation0);
+            record_history(generation0);
         }
 
         last_generation = generation0;
@@ -290,35 +533,185 @@ public:
         timer.tic();
         generation_step++;
         ThisGenerationType new_generation;
-        transfer(new_generation);
-        crossover_and_mutation(new_generation);
+        PerfMetrics perf;
+        PerfCounterValues perf_mark = perf_read();
+        if (ALPS_layers)
+            breed_age_layers(new_generation);
+        else if (eda_mode != EDAMode::Off)
+            sample_offspring(new_generation);
+        else {
+            transfer(new_generation);
+            crossover_and_mutation(new_generation);
+        }
+        perf_phase(perf, EnginePhase::Offspring, perf_mark);
 
         finalize_objectives(new_generation);
+        perf_phase(perf, EnginePhase::Objectives, perf_mark);
         rank_population(new_generation); // used for selection
+        perf_phase(perf, EnginePhase::Ranking, perf_mark);
         ThisGenerationType selected_generation;
         select_population(new_generation, selected_generation);
         new_generation = selected_generation;
+        perf_phase(perf, EnginePhase::Selection, perf_mark);
         rank_population(new_generation); // used for elite tranfre, crossover and mutation
+        perf_phase(perf, EnginePhase::Ranking, perf_mark);
         finalize_generation(new_generation);
+        respond_to_diversity(new_generation);
+        if (objective_reduction != ObjectiveReductionMode::Off &&
+            generation_step % int(objective_reduction_interval) == 0)
+            reduce_objectives(new_generation, false);
+        perf_collect(perf, new_generation);
         new_generation.exe_time = timer.toc();
 
         if (!user_request_stop) {
             generations_so_abs.push_back(ThisGenSOAbs(new_generation));
             report_generation(new_generation);
+            record_history(new_generation);
         }
         last_generation = new_generation;
 
-        return stop_critera();
+        StopReason stop = stop_critera();
+        if (stop != StopReason::Undefined && !active_objectives.is_identity()) stop = recheck_objectives(stop);
+        return stop;
     }
 
     StopReason solve() {
-        StopReason stop = StopReason::Undefined;
         solve_init();
+        return resume();
+    }
+
+    // Continues the run from last_generation until a stop criterion is met.
+    StopReason resume() {
+        StopReason stop = StopReason::Undefined;
         while (stop == StopReason::Undefined) stop = solve_next_generation();
+        if (evaluation_recorder) evaluation_recorder->flush();
         show_stop_reason(stop);
         return stop;
     }
 
+    /****************************************************
+     * Dynamic optimization: tells the engine that the data
+     * of the problem has changed after a run. The members
+     * of last_generation affected by the change (all of
+     * them without is_affected_by_change) are evaluated
+     * again in parallel. Members which are not accepted
+     * anymore get random genes. Then the worst
+     * change_diversity_fraction of the population is
+     * replaced by random immigrants or by hypermutants of
+     * random members. The generation counter and the stall
+     * counters restart, so resume() continues with the
+     * full generation_max and a wide mutation radius.
+     * The evaluation_store keys include the number of
+     * changes, so results of the old problem are not
+     * served again, and the outputs cached by the
+     * evaluation_stages are dropped. The history_writer
+     * and the generation_archive continue the step count
+     * of the run instead of recording generation 0 again.
+     ****************************************************/
+    void notify_problem_changed() {
+        if (is_interactive()) throw runtime_error("notify_problem_changed is not supported in interactive mode!");
+        if (ALPS_layers) throw runtime_error("notify_problem_changed is not supported in age-layered mode!");
+        if (evaluation_replay) throw runtime_error("notify_problem_changed is not supported with evaluation_replay!");
+        if (last_generation.chromosomes.size() != population)
+            throw runtime_error("notify_problem_changed is called before the population is initialized!");
+        Chronometer timer;
+        timer.tic();
+        problem_changes++;
+        history_step_offset += generation_step + 1;
+        generation_step = 0;
+        noise_budget_step = -1;
+        average_stall_count = 0;
+        best_stall_count = 0;
+        generations_so_abs.clear();
+        dominance_graph.clear();
+        if (duplicate_fingerprints) duplicate_fingerprints->clear();
+        if (evaluation_stages) evaluation_stages->clear();
+
+        ThisGenerationType g;
+        g.chromosomes = last_generation.chromosomes;
+        vector<unsigned int> affected;
+        for (unsigned int i = 0; i < g.chromosomes.size(); i++)
+            if (is_affected_by_change == nullptr || is_affected_by_change(g.chromosomes[i])) affected.push_back(i);
+        evaluate_members(g, affected, ChangeResponse::None);
+        finalize_objectives(g);
+        rank_population(g);
+
+        replace_worst(g, change_diversity_fraction, change_response);
+        finalize_generation(g);
+        if (!is_single_objective()) {
+            update_ideal_objectives(g, true);
+            extreme_objectives.clear();
+            scalarized_objectives_min.clear();
+        }
+        g.exe_time = timer.toc();
+        if (!user_request_stop) {
+            generations_so_abs.push_back(ThisGenSOAbs(g));
+            report_generation(g);
+            record_history(g);
+        }
+        last_generation = g;
+    }
+
+    /****************************************************
+     * Replaces the worst share of the ranked generation,
+     * except the elites, by random immigrants or by
+     * hypermutants and ranks it again.
+     ****************************************************/
+    void replace_worst(ThisGenerationType& g, double fraction, ChangeResponse response) {
+        const unsigned int N = (unsigned int)g.chromosomes.size();
+        unsigned int N_replace = (unsigned int)std::lround(fraction * double(population));
+        N_replace = std::min(N_replace, N - std::min(N, (unsigned int)std::max(elite_count, 0)));
+        if (response == ChangeResponse::None || N_replace == 0) return;
+        vector<unsigned int> worst;
+        if (is_single_objective())
+            for (unsigned int k = 0; k < N_replace; k++) worst.push_back(g.sorted_indices[N - 1 - k]);
+        else
+            for (unsigned int f = (unsigned int)g.fronts.size(); f-- > 0 && worst.size() < N_replace;)
+                for (unsigned int i : g.fronts[f])
+                    if (worst.size() < N_replace) worst.push_back(i);
+        evaluate_members(g, worst, response);
+        finalize_objectives(g);
+        dominance_graph.clear();
+        rank_population(g);
+    }
+
+    /****************************************************
+     * In IGA pipeline mode, the user interface rates the
+     * candidates passed to IGA_present_candidate by their
+     * index. It can be called from any thread and in any
+     * order. Returns false for unknown candidates.
+     ****************************************************/
+    bool rate_IGA_candidate(unsigned int index, double total_cost) {
+        return iga_pipeline && iga_pipeline->rate(index, total_cost);
+    }
+
+    DuplicateStats get_duplicate_stats() const {
+        return duplicate_fingerprints ? duplicate_fingerprints->stats() : DuplicateStats();
+    }
+
+    // number of dominance checks done by the incremental MO ranking
+    unsigned long get_dominance_comparisons() const { return dominance_graph.comparisons(); }
+
+    /****************************************************
+     * The middle costs of x, also if middle_cost_retention
+     * has compressed or spilled them, e.g. for the report
+     * callbacks. Returns false if they were released.
+     ****************************************************/
+    bool load_middle_costs(const ThisChromosomeType& x, MiddleCostType& middle_costs) const {
+        switch (x.retained.state) {
+        case MiddleCostRetention::Keep: middle_costs = x.middle_costs; return true;
+        case MiddleCostRetention::Compress: {
+            std::string bytes;
+            const std::string& packed = *x.retained.compressed;
+            lz_decompress(packed.data(), packed.data() + packed.size(), bytes);
+            return deserialize_middle_costs(bytes, middle_costs);
+        }
+        case MiddleCostRetention::Spill:
+            return deserialize_middle_costs(x.retained.spilled->read(), middle_costs);
+        default: return false;
+        }
+    }
+
     std::string stop_reason_to_string(StopReason stop) {
         switch (stop) {
         case StopReason::Undefined: return "No-stop"; break;
@@ -326,6 +719,7 @@ public:
         case StopReason::StallAverage: return "Average stalled"; break;
         case StopReason::StallBest: return "Best stalled"; break;
         case StopReason::UserRequest: return "User request"; break;
+        case StopReason::DiversityCollapse: return "Diversity collapsed"; break;
         default: return "Unknown reason";
         }
     }
@@ -357,6 +751,12 @@ protected:
         }
     }
 
+    void record_history(const ThisGenerationType& new_generation) {
+        const int step = generation_step + history_step_offset;
+        if (history_writer) history_writer->append(step, new_generation);
+        if (generation_archive) generation_archive->append(step, new_generation);
+    }
+
     void show_stop_reason(StopReason stop) {
         if (verbose) {
             cout << "Stop criteria: ";
@@ -404,11 +804,193 @@ protected:
             new_generation.best_total_cost = best;
             new_generation.average_cost = sum / double(new_generation.chromosomes.size());
         }
+        measure_diversity(new_generation);
+    }
+
+    /****************************************************
+     * Diversity of the generation: Welford mean and
+     * variance of the gene embeddings, the mean distance
+     * of diversity_pair_samples random member pairs, the
+     * entropy of the gene hashes and the range of every
+     * objective. The embeddings and the pairs are split
+     * between the worker threads.
+     ****************************************************/
+    void measure_diversity(ThisGenerationType& g) {
+        if (embed_genes == nullptr && distance_genes == nullptr) return;
+        const unsigned int N = (unsigned int)g.chromosomes.size();
+        DiversityMetrics& d = g.diversity;
+        d = DiversityMetrics();
+        d.measured = true;
+        if (N == 0) return;
+        const int N_workers = multi_threading ? std::max(1, std::min(N_threads, int(N))) : 1;
+        vector<uint64_t> seeds(N_workers);
+        {
+            std::lock_guard<std::mutex> lock(mtx_rand);
+            for (uint64_t& seed : seeds) seed = rng();
+        }
+
+        vector<vector<double>> embedding(embed_genes ? N : 0);
+        vector<VectorStats> stats(N_workers);
+        if (embed_genes) {
+            run_on_workers(N_workers, [&](int w) {
+                for (unsigned int i = (unsigned int)w; i < N; i += (unsigned int)N_workers) {
+                    embed_genes(g.chromosomes[i].genes, embedding[i]);
+                    stats[w].add(embedding[i]);
+                }
+            });
+            for (int w = 1; w < N_workers; w++) stats[0].merge(stats[w]);
+            d.gene_mean = stats[0].mean;
+            d.gene_variance = stats[0].variance();
+            for (double v : d.gene_variance) d.mean_gene_variance += v / double(d.gene_variance.size());
+        }
+
+        const unsigned int N_pairs = N > 1 ? diversity_pair_samples : 0;
+        vector<double> distance_sum(N_workers, 0.0);
+        run_on_workers(N_workers, [&](int w) {
+            LocalRandom rnd(seeds[w]);
+            for (unsigned int k = (unsigned int)w; k < N_pairs; k += (unsigned int)N_workers) {
+                const unsigned int a = rnd.below(N);
+                const unsigned int b = (a + 1 + rnd.below(N - 1)) % N;
+                distance_sum[w] += distance_genes ? distance_genes(g.chromosomes[a].genes, g.chromosomes[b].genes)
+                                                  : euclidean_distance(embedding[a], embedding[b]);
+            }
+        });
+        d.N_pairs = N_pairs;
+        for (double sum : distance_sum) d.mean_pairwise_distance += N_pairs ? sum / double(N_pairs) : 0.0;
+
+        if (hash_genes) {
+            vector<uint64_t> keys(N);
+            for (unsigned int i = 0; i < N; i++) keys[i] = hash_genes(g.chromosomes[i].genes);
+            d.entropy = normalized_entropy(keys);
+        }
+
+        const bool SO = is_single_objective();
+        const unsigned int M = SO ? 1 : (unsigned int)g.chromosomes[0].objectives.size();
+        for (unsigned int m = 0; m < M; m++) {
+            double lo = std::numeric_limits<double>::infinity(), hi = -lo;
+            for (const ThisChromosomeType& X : g.chromosomes) {
+                const double value = SO ? X.total_cost : X.objectives[m];
+                lo = std::min(lo, value);
+                hi = std::max(hi, value);
+            }
+            d.objective_range.push_back(hi - lo);
+            d.objective_spread += (hi - lo) / double(M);
+        }
+    }
+
+    // takes diversity_action while the generation is below diversity_threshold
+    void respond_to_diversity(ThisGenerationType& g) {
+        diversity_collapsed = g.diversity.measured && diversity_threshold > 0.0 &&
+            g.diversity.mean_pairwise_distance < diversity_threshold;
+        if (!diversity_collapsed) {
+            mutation_boost = 1.0;
+            return;
+        }
+        if (verbose) cout << "Diversity collapsed: " << g.diversity.mean_pairwise_distance << endl;
+        if (diversity_action == DiversityAction::RaiseMutation)
+            mutation_boost = std::min(2.0 * mutation_boost, mutation_rate > 0.0 ? 1.0 / mutation_rate : 1.0);
+        if (diversity_action == DiversityAction::Immigrants) {
+            replace_worst(g, diversity_immigrant_fraction, ChangeResponse::RandomImmigrants);
+            finalize_generation(g);
+        }
+    }
+
+    /****************************************************
+     * Online objective reduction: the objectives are
+     * correlated on the members which are non-dominated
+     * by their full objective vectors. Objectives which
+     * do not conflict there are dropped (or merged) for
+     * the selection until the next analysis. A change is
+     * recorded in objective_reduction_log.
+     ****************************************************/
+    void reduce_objectives(ThisGenerationType& g, bool final_check) {
+        ObjectiveReduction reduction = analyse_objectives(
+            full_objective_front(g),
+            objective_correlation_threshold,
+            objective_reduction == ObjectiveReductionMode::Merge);
+        if (reduction == active_objectives && !final_check) return;
+        if (reduction.groups == active_objectives.groups && !final_check) {
+            use_objectives(reduction, g); // Merge: the same groups with the ranges of the current front
+            return;
+        }
+        objective_reduction_log.push_back({generation_step, reduction.groups, final_check});
+        if (verbose) {
+            cout << "Objective reduction (generation " << generation_step << "):";
+            if (reduction.is_identity()) cout << " all objectives";
+            for (const vector<unsigned int>& group : reduction.groups) {
+                cout << " {";
+                for (unsigned int k = 0; k < group.size(); k++) cout << (k ? "," : "") << group[k];
+                cout << "}";
+            }
+            cout << endl;
+        }
+        if (!final_check) use_objectives(reduction, g);
+    }
+
+    /****************************************************
+     * Before the run stops with reduced objectives, the
+     * last generation is ranked by all objectives again
+     * and the reduction is analysed once more. If the
+     * dropped objectives conflict with the others now,
+     * the run continues with all of them unless the
+     * generations are used up or the user stopped it.
+     ****************************************************/
+    StopReason recheck_objectives(StopReason stop) {
+        const ObjectiveReduction reduced = active_objectives;
+        use_objectives(ObjectiveReduction(), last_generation);
+        reduce_objectives(last_generation, true);
+        if (stop == StopReason::MaxGenerations || stop == StopReason::UserRequest) return stop;
+        if (objective_reduction_log.back().groups == reduced.groups) return stop;
+        if (verbose) cout << "The reduced objectives are not redundant any more, continuing with all." << endl;
+        average_stall_count = 0;
+        best_stall_count = 0;
+        return StopReason::Undefined;
+    }
+
+    // selects the objectives, rebuilds the reference vectors and the normalization for them and ranks g again
+    void use_objectives(const ObjectiveReduction& reduction, ThisGenerationType& g) {
+        active_objectives = reduction;
+        calculate_N_robj(g);
+        if (auto_reference_divisions) set_reference_divisions();
+        reference_vectors.clear();
+        update_ideal_objectives(g, true);
+        extreme_objectives.clear();
+        scalarized_objectives_min.clear();
+        dominance_graph.clear();
+        rank_population(g);
+    }
+
+    // objective vectors of the members which no member dominates in all objectives
+    vector<vector<double>> full_objective_front(const ThisGenerationType& g) const {
+        vector<vector<double>> front;
+        for (const ThisChromosomeType& x : g.chromosomes) {
+            bool dominated = false;
+            for (const ThisChromosomeType& y : g.chromosomes)
+                if (pareto_dominates(y.objectives, x.objectives)) {
+                    dominated = true;
+                    break;
+                }
+            if (!dominated) front.push_back(x.objectives);
+        }
+        return front;
+    }
+
+    unsigned int N_selection_objectives(const ThisGenerationType& g) const {
+        if (active_objectives.is_identity()) return (unsigned int)g.chromosomes[0].objectives.size();
+        return (unsigned int)active_objectives.size();
+    }
+
+    double selection_objective(const ThisChromosomeType& x, unsigned int m) const {
+        return active_objectives.is_identity() ? x.objectives[m] : active_objectives.value(x.objectives, m);
     }
 
     void check_settings() {
         if (is_interactive()) {
-            if (calculate_IGA_total_fitness == nullptr)
+            if (IGA_pipeline) {
+                if (IGA_present_candidate == nullptr)
+                    throw runtime_error("IGA_present_candidate is null in IGA pipeline mode!");
+            }
+            else if (calculate_IGA_total_fitness == nullptr)
                 throw runtime_error("calculate_IGA_total_fitness is null in interactive mode!");
             if (calculate_SO_total_fitness != nullptr)
                 throw runtime_error("calculate_SO_total_fitness is not null in interactive mode!");
@@ -421,13 +1003,99 @@ protected:
             if (eval_solution_IGA == nullptr) throw runtime_error("eval_solution_IGA is null in interactive mode!");
             if (eval_solution != nullptr)
                 throw runtime_error("eval_solution is not null in interactive mode (use eval_solution_IGA instead)!");
+            if (eval_solution_noisy != nullptr)
+                throw runtime_error("eval_solution_noisy is not null in interactive mode!");
+            if (eval_solution_gradient != nullptr)
+                throw runtime_error("eval_solution_gradient is not null in interactive mode!");
+            if (eval_solution_context != nullptr)
+                throw runtime_error("eval_solution_context is not null in interactive mode!");
+            if (eval_solution_staged != nullptr)
+                throw runtime_error("eval_solution_staged is not null in interactive mode!");
+            if (eda_mode != EDAMode::Off) throw runtime_error("The EDA mode is not supported in interactive mode!");
         }
         else {
             if (calculate_IGA_total_fitness != nullptr)
                 throw runtime_error("calculate_IGA_total_fitness is not null in non-interactive mode!");
+            if (IGA_pipeline) throw runtime_error("IGA_pipeline is set in non-interactive mode!");
             if (eval_solution_IGA != nullptr)
                 throw runtime_error("eval_solution_IGA is not null in non-interactive mode!");
-            if (eval_solution == nullptr) throw runtime_error("eval_solution is null!");
+            const bool has_evaluator = eval_solution != nullptr || eval_solution_noisy != nullptr ||
+                eval_solution_gradient != nullptr || eval_solution_context != nullptr ||
+                eval_solution_staged != nullptr;
+            if (!has_evaluator && evaluation_replay == nullptr) throw runtime_error("eval_solution is null!");
+            if (evaluation_recorder != nullptr || evaluation_replay != nullptr) {
+                if (hash_genes == nullptr) throw runtime_error("Evaluation traces require hash_genes.");
+                if (eval_solution_noisy != nullptr)
+                    throw runtime_error("Evaluation traces are not supported with eval_solution_noisy.");
+            }
+            if (evaluation_recorder != nullptr && serialize_middle_costs == nullptr)
+                throw runtime_error("evaluation_recorder requires serialize_middle_costs.");
+            if (evaluation_replay != nullptr) {
+                if (deserialize_middle_costs == nullptr)
+                    throw runtime_error("evaluation_replay requires deserialize_middle_costs.");
+                if (replay_miss == TraceMiss::Evaluate && !has_evaluator)
+                    throw runtime_error("TraceMiss::Evaluate requires eval_solution.");
+                if (replay_latency_scale < 0.0) throw runtime_error("replay_latency_scale is below 0.");
+            }
+            if (eval_solution_staged != nullptr) {
+                if (eval_solution != nullptr || eval_solution_noisy != nullptr || eval_solution_gradient != nullptr ||
+                    eval_solution_context != nullptr)
+                    throw runtime_error("eval_solution_staged is adjusted together with another eval_solution.");
+                if (evaluation_stages == nullptr)
+                    throw runtime_error("eval_solution_staged requires evaluation_stages.");
+            }
+            if (eval_solution_context != nullptr) {
+                if (eval_solution != nullptr || eval_solution_noisy != nullptr || eval_solution_gradient != nullptr)
+                    throw runtime_error("eval_solution_context is adjusted together with another eval_solution.");
+                if (evaluation_context == nullptr)
+                    throw runtime_error("eval_solution_context requires evaluation_context.");
+            }
+            if (eval_solution != nullptr && eval_solution_noisy != nullptr)
+                throw runtime_error("eval_solution and eval_solution_noisy are both adjusted.");
+            if (eval_solution_gradient != nullptr) {
+                if (eval_solution != nullptr || eval_solution_noisy != nullptr)
+                    throw runtime_error("eval_solution_gradient is adjusted together with another eval_solution.");
+                if (problem_mode != GaMode::SOGA)
+                    throw runtime_error("eval_solution_gradient is only supported in single objective mode!");
+            }
+            if (eval_solution_noisy != nullptr) {
+                if (problem_mode != GaMode::SOGA)
+                    throw runtime_error("eval_solution_noisy is only supported in single objective mode!");
+                if (noise_min_replications < 1) throw runtime_error("noise_min_replications is below 1.");
+                if (noise_max_replications < noise_min_replications)
+                    throw runtime_error("noise_max_replications is below noise_min_replications.");
+            }
+            if (diversity_threshold > 0.0 && embed_genes == nullptr && distance_genes == nullptr)
+                throw runtime_error("diversity_threshold requires embed_genes or distance_genes.");
+            if (eval_resources != nullptr && resource_scheduler == nullptr)
+                throw runtime_error("eval_resources requires a resource_scheduler.");
+            if (mutate_gradient != nullptr && eval_solution_gradient == nullptr)
+                throw runtime_error("mutate_gradient requires eval_solution_gradient.");
+            if (gradient_mutation_rate < 0.0 || gradient_mutation_rate > 1.0)
+                throw runtime_error("Wrong gradient mutation rate");
+            if (ALPS_layers > 0) {
+                if (problem_mode != GaMode::SOGA)
+                    throw runtime_error("ALPS_layers is only supported in single objective mode!");
+                if (ALPS_age_gap < 1) throw runtime_error("ALPS_age_gap is below 1.");
+                // the immigrants would keep the age of the members they replace, counted over one layer
+                if (ALPS_layers > 1 && diversity_threshold > 0.0 && diversity_action == DiversityAction::Immigrants)
+                    throw runtime_error("DiversityAction::Immigrants is not supported with several ALPS_layers.");
+            }
+            if (eda_mode != EDAMode::Off) {
+                if (eda_encode == nullptr || eda_decode == nullptr)
+                    throw runtime_error("The EDA mode requires eda_encode and eda_decode.");
+                if (ALPS_layers > 0) throw runtime_error("The EDA mode does not support ALPS_layers.");
+                if (eliminate_duplicates) throw runtime_error("The EDA mode does not support eliminate_duplicates.");
+                if (eda_selection_fraction <= 0.0 || eda_selection_fraction > 1.0)
+                    throw runtime_error("Wrong EDA selection fraction");
+                if (PBIL_learning_rate <= 0.0 || PBIL_learning_rate > 1.0)
+                    throw runtime_error("Wrong PBIL learning rate");
+                if (change_response == ChangeResponse::Hypermutation && mutate == nullptr && mutate_bulk == nullptr)
+                    throw runtime_error("ChangeResponse::Hypermutation requires mutate.");
+                // the raised mutation rate scales the probability margin of the model in this mode
+                if (diversity_action == DiversityAction::RaiseMutation && eda_probability_margin <= 0.0)
+                    throw runtime_error("DiversityAction::RaiseMutation requires eda_probability_margin in EDA mode.");
+            }
             if (is_single_objective()) {
                 if (calculate_SO_total_fitness == nullptr)
                     throw runtime_error("calculate_SO_total_fitness is null in single objective mode!");
@@ -450,9 +1118,63 @@ protected:
             }
         }
 
-        if (init_genes == nullptr) throw runtime_error("init_genes is not adjusted.");
-        if (mutate == nullptr) throw runtime_error("mutate is not adjusted.");
-        if (crossover == nullptr) throw runtime_error("crossover is not adjusted.");
+        if ((evaluation_recorder || evaluation_replay) && is_interactive())
+            throw runtime_error("Evaluation traces are not supported in interactive mode!");
+        if (middle_cost_retention != MiddleCostRetention::Keep) {
+            if (is_interactive()) throw runtime_error("middle_cost_retention is not supported in interactive mode!");
+            if (middle_cost_retention != MiddleCostRetention::Release &&
+                (serialize_middle_costs == nullptr || deserialize_middle_costs == nullptr))
+                throw runtime_error("middle cost serialization is not adjusted while middle_cost_retention is set!");
+            if (middle_cost_retention == MiddleCostRetention::Spill && middle_cost_spill == nullptr)
+                throw runtime_error("MiddleCostRetention::Spill requires middle_cost_spill.");
+        }
+        if (evaluation_store) {
+            if (is_interactive()) throw runtime_error("evaluation_store is not supported in interactive mode!");
+            if (hash_genes == nullptr) throw runtime_error("hash_genes is null while evaluation_store is set!");
+            if (serialize_middle_costs == nullptr || deserialize_middle_costs == nullptr)
+                throw runtime_error("middle cost serialization is not adjusted while evaluation_store is set!");
+        }
+
+        if (eliminate_duplicates) {
+            if (hash_genes == nullptr) throw runtime_error("hash_genes is null while eliminate_duplicates is set!");
+            if (duplicate_memory < 0) throw runtime_error("duplicate_memory is below 0.");
+            if (duplicate_retry_max < 0) throw runtime_error("duplicate_retry_max is below 0.");
+        }
+
+        if (selection_strategy == SelectionStrategy::CrowdedTournament ||
+            selection_strategy == SelectionStrategy::Lexicase) {
+            if (is_single_objective())
+                throw runtime_error("The selection strategy is only supported in multi-objective mode!");
+        }
+        if (!aspiration_points.empty()) {
+            if (is_single_objective())
+                throw runtime_error("aspiration_points are only supported in multi-objective mode!");
+            if (aspiration_spread <= 0.0 || aspiration_spread > 1.0) throw runtime_error("Wrong aspiration spread");
+        }
+        if (objective_reduction != ObjectiveReductionMode::Off) {
+            if (is_single_objective())
+                throw runtime_error("objective_reduction is only supported in multi-objective mode!");
+            if (distribution_objective_reductions != nullptr)
+                throw runtime_error("objective_reduction and distribution_objective_reductions are both adjusted.");
+            if (!aspiration_points.empty())
+                throw runtime_error("objective_reduction is not supported with aspiration_points!");
+            if (objective_reduction_interval < 1) throw runtime_error("objective_reduction_interval is below 1.");
+            if (objective_correlation_threshold <= 0.0 || objective_correlation_threshold > 1.0)
+                throw runtime_error("Wrong objective_correlation_threshold");
+        }
+        if (tournament_size < 1) throw runtime_error("tournament_size is below 1.");
+
+        if (init_genes == nullptr && init_genes_bulk == nullptr) throw runtime_error("init_genes is not adjusted.");
+        if (eda_mode == EDAMode::Off) {
+            if (mutate == nullptr && mutate_bulk == nullptr) throw runtime_error("mutate is not adjusted.");
+            if (crossover == nullptr && crossover_bulk == nullptr) throw runtime_error("crossover is not adjusted.");
+        }
+        if (init_genes != nullptr && init_genes_bulk != nullptr)
+            throw runtime_error("init_genes and init_genes_bulk are both adjusted.");
+        if (mutate != nullptr && mutate_bulk != nullptr)
+            throw runtime_error("mutate and mutate_bulk are both adjusted.");
+        if (crossover != nullptr && crossover_bulk != nullptr)
+            throw runtime_error("crossover and crossover_bulk are both adjusted.");
         if (N_threads < 1) throw runtime_error("Number of threads is below 1.");
         if (population < 1) throw runtime_error("population is below 1.");
         if (is_single_objective()) { // SO (including IGA)
@@ -472,7 +1194,9 @@ protected:
     void select_population(const ThisGenerationType& g, ThisGenerationType& g2) {
         if (user_request_stop) return;
 
-        if (is_single_objective())
+        if (ALPS_layers)
+            select_population_ALPS(g, g2);
+        else if (is_single_objective())
             select_population_SO(g, g2);
         else
             select_population_MO(g, g2);
@@ -482,19 +1206,10 @@ protected:
         if (user_request_stop) return;
 
         if (is_single_objective()) throw runtime_error("Wrong code A0812473247.");
-        if (reset) {
-            if (distribution_objective_reductions)
-                ideal_objectives = distribution_objective_reductions(g.chromosomes[0].objectives);
-            else
-                ideal_objectives = g.chromosomes[0].objectives;
-        }
+        if (reset) ideal_objectives = reduced_objectives(g.chromosomes[0].objectives);
         unsigned int N_r_objectives = (unsigned int)ideal_objectives.size();
-        for (ThisChromosomeType x : g.chromosomes) {
-            vector<double> obj_reduced;
-            if (distribution_objective_reductions)
-                obj_reduced = distribution_objective_reductions(x.objectives);
-            else
-                obj_reduced = x.objectives;
+        for (const ThisChromosomeType& x : g.chromosomes) {
+            const vector<double> obj_reduced = reduced_objectives(x.objectives);
             for (unsigned int i = 0; i < N_r_objectives; i++)
                 if (obj_reduced[i] < ideal_objectives[i]) ideal_objectives[i] = obj_reduced[i];
         }
@@ -511,12 +1226,7 @@ protected:
         const unsigned int N_chromosomes = (unsigned int)g.chromosomes.size();
         Matrix<double> zb_objectives(N_chromosomes, N_robj);
         for (unsigned int i = 0; i < N_chromosomes; i++) {
-            vector<double> robj_x;
-            if (distribution_objective_reductions)
-                robj_x = distribution_objective_reductions(g.chromosomes[i].objectives);
-            else
-                robj_x = g.chromosomes[i].objectives;
-
+            const vector<double> robj_x = reduced_objectives(g.chromosomes[i].objectives);
             for (unsigned int j = 0; j < N_robj; j++) zb_objectives(i, j) = (robj_x[j] - ideal_objectives[j]);
         }
         scalarize_objectives(zb_objectives);
@@ -529,14 +1239,10 @@ protected:
             g2 = g;
             return;
         }
-        if (reference_vectors.empty()) {
-            unsigned int obj_dept;
-            if (distribution_objective_reductions)
-                obj_dept = (unsigned int)distribution_objective_reductions(g.chromosomes[0].objectives).size();
-            else
-                obj_dept = (unsigned int)g.chromosomes[0].objectives.size();
-            reference_vectors = generate_referenceVectors(obj_dept, reference_vector_divisions);
-        }
+        if (!aspiration_points.empty())
+            reference_vectors = generate_aspiration_reference_vectors(ideal_objectives, intercepts);
+        else if (reference_vectors.empty())
+            reference_vectors = generate_referenceVectors(N_robj, reference_vector_divisions);
         vector<unsigned int> associated_ref_vector;
         vector<double> distance_ref_vector;
 
@@ -597,6 +1303,15 @@ protected:
             niche_count[min_niche_index]++;
         }
         for (unsigned int i : to_add) g2.chromosomes.push_back(g.chromosomes[i]);
+        if (incremental_MO_ranking) {
+            // the selected members keep their relations, the rest are dropped
+            vector<unsigned int> selected;
+            selected.reserve(population);
+            for (unsigned int f = 0; f < last_front_index; f++)
+                selected.insert(selected.end(), g.fronts[f].begin(), g.fronts[f].end());
+            selected.insert(selected.end(), to_add.begin(), to_add.end());
+            dominance_graph.restrict(selected);
+        }
     }
 
     void associate_to_references(
@@ -743,7 +1458,7 @@ protected:
             bool allowed;
             do {
                 allowed = true;
-                j = select_parent(g);
+                j = (int)roulette_select(g.selection_chance_cumulative, random01());
                 for (int k = 0; k < int(blocked.size()) && allowed; k++)
                     if (blocked[k] == j) allowed = false;
             } while (!allowed);
@@ -760,6 +1475,14 @@ protected:
             rank_population_SO(gen);
         else
             rank_population_MO(gen);
+        if (selection_strategy == SelectionStrategy::CrowdedTournament) {
+            crowding_distances(
+                gen.fronts,
+                (unsigned int)gen.chromosomes.size(),
+                N_selection_objectives(gen),
+                [this, &gen](unsigned int i, unsigned int m) { return selection_objective(gen.chromosomes[i], m); },
+                gen.crowding_distance);
+        }
     }
 
     void quicksort_indices_SO(vector<int>& array_indices, const ThisGenerationType& gen, int left, int right) {
@@ -810,6 +1533,7 @@ protected:
     }
 
     void generate_selection_chance(ThisGenerationType& gen, const vector<int>& rank) {
+        gen.ranks = rank;
         double chance_cumulative = 0.0;
         unsigned int N = (unsigned int)gen.chromosomes.size();
         gen.selection_chance_cumulative.clear();
@@ -818,13 +1542,26 @@ protected:
             chance_cumulative += 1.0 / sqrt(double(rank[i] + 1));
             gen.selection_chance_cumulative.push_back(chance_cumulative);
         }
+        const double normalizer = gen.selection_chance_cumulative[std::min(population, N) - 1];
         for (unsigned int i = 0; i < N; i++) { // normalizing
-            gen.selection_chance_cumulative[i] =
-                gen.selection_chance_cumulative[i] / gen.selection_chance_cumulative[population - 1];
+            gen.selection_chance_cumulative[i] = gen.selection_chance_cumulative[i] / normalizer;
         }
     }
 
     void rank_population_MO(ThisGenerationType& gen) {
+        if (incremental_MO_ranking) {
+            // The leading members are the survivors of the last generation (see transfer).
+            // Only the offspring are compared with the rest of the population.
+            dominance_graph.extend(gen.chromosomes, [this](const ThisChromosomeType& a, const ThisChromosomeType& b) {
+                return dominates(a, b);
+            });
+            dominance_graph.fronts(gen.fronts);
+            vector<int> ranks(gen.chromosomes.size(), 0);
+            for (unsigned int i = 0; i < gen.fronts.size(); i++)
+                for (unsigned int j : gen.fronts[i]) ranks[j] = i;
+            generate_selection_chance(gen, ranks);
+            return;
+        }
         vector<vector<unsigned int>> domination_set;
         vector<int> dominated_count;
         domination_set.reserve(gen.chromosomes.size());
@@ -868,6 +1605,7 @@ protected:
 
     bool dominates(const ThisChromosomeType& a, const ThisChromosomeType& b) {
         if (a.objectives.size() != b.objectives.size()) throw runtime_error("vector size mismatch A73592753!");
+        if (!active_objectives.is_identity()) return active_objectives.dominates(a.objectives, b.objectives);
         for (unsigned int i = 0; i < a.objectives.size(); i++)
             if (a.objectives[i] > b.objectives[i]) return false;
         for (unsigned int i = 0; i < a.objectives.size(); i++)
@@ -898,6 +1636,56 @@ protected:
         return result;
     }
 
+    /****************************************************
+     * R-NSGA-III: reference directions concentrated around
+     * the aspiration points instead of spread over the
+     * whole simplex. Every aspiration point is normalized
+     * like the objectives and scaled onto the unit simplex.
+     * A Das-Dennis set of aspiration_divisions is shrunk
+     * by aspiration_spread and centered on it, so the
+     * divisions set the density and the spread the size of
+     * the preferred region. The axis directions are kept
+     * so that the extreme members still anchor the
+     * normalization. The directions follow the ideal point
+     * and the intercepts, so they are built every
+     * generation.
+     ****************************************************/
+    Matrix<double> generate_aspiration_reference_vectors(
+        const vector<double>& ideal,
+        const vector<double>& intercepts) {
+        const unsigned int M = (unsigned int)intercepts.size();
+        const unsigned int N_points = (unsigned int)aspiration_points.size();
+        int divisions = int(aspiration_divisions);
+        if (divisions == 0) {
+            divisions = 1;
+            while (unsigned(get_number_reference_vectors(int(M), divisions + 1)) * N_points + M <= population)
+                divisions++;
+        }
+        const Matrix<double> patch = generate_referenceVectors(int(M), divisions);
+        const unsigned int N_patch = patch.get_n_rows();
+        Matrix<double> directions(N_points * N_patch + M, M);
+        for (unsigned int a = 0; a < N_points; a++) {
+            vector<double> center(M);
+            double sum = 0.0;
+            for (unsigned int j = 0; j < M; j++) {
+                center[j] = std::max((aspiration_points[a][j] - ideal[j]) / intercepts[j], 1e-10);
+                sum += center[j];
+            }
+            for (unsigned int k = 0; k < N_patch; k++) {
+                const unsigned int row = a * N_patch + k;
+                double row_sum = 0.0;
+                for (unsigned int j = 0; j < M; j++) {
+                    const double x = center[j] / sum + aspiration_spread * (patch(k, j) - 1.0 / double(M));
+                    directions(row, j) = std::max(x, 0.0);
+                    row_sum += directions(row, j);
+                }
+                for (unsigned int j = 0; j < M; j++) directions(row, j) /= row_sum;
+            }
+        }
+        for (unsigned int j = 0; j < M; j++) directions(N_points * N_patch + j, j) = 1.0;
+        return directions;
+    }
+
     Matrix<double> generate_referenceVectors(int dept, int N_division) {
         Matrix<double> A;
         A = generate_integerReferenceVectors(dept, N_division);
@@ -924,6 +1712,102 @@ protected:
         }
     }
 
+    /****************************************************
+     * Calls eval_solution. When an evaluation store is
+     * attached, known genes are answered from the store
+     * and new results are inserted in the background.
+     * The first payload byte records acceptance.
+     ****************************************************/
+    // gradient receives the result of eval_solution_gradient, it stays empty for results from the store
+    bool evaluate(const GeneType& genes, MiddleCostType& middle_costs, vector<double>* gradient = nullptr) {
+        if (evaluation_replay) return replay_evaluation(genes, middle_costs, gradient);
+        if (!evaluation_store) return call_eval_solution(genes, middle_costs, gradient);
+
+        Chronometer timer;
+        timer.tic();
+        uint64_t key = hash_genes(genes);
+        if (problem_changes) key = hash_combine(key, problem_changes); // results of an older problem do not match
+        std::string payload;
+        if (gradient) gradient->clear();
+        if (evaluation_store->lookup(key, payload) && !payload.empty()) {
+            if (payload[0] == 0) {
+                record_evaluation(genes, middle_costs, false, timer.toc());
+                return false;
+            }
+            if (deserialize_middle_costs(payload.substr(1), middle_costs)) {
+                record_evaluation(genes, middle_costs, true, timer.toc());
+                return true;
+            }
+        }
+        bool accepted = call_eval_solution(genes, middle_costs, gradient);
+        payload.assign(1, char(accepted ? 1 : 0));
+        if (accepted) payload += serialize_middle_costs(middle_costs);
+        evaluation_store->insert_async(key, std::move(payload));
+        return accepted;
+    }
+
+    /****************************************************
+     * Replays a recorded evaluation: the middle costs and
+     * the acceptance of the genes are taken from the trace
+     * and the evaluation waits replay_latency_scale times
+     * the recorded time, holding its resources like the
+     * real evaluation. Unknown genes are handled according
+     * to replay_miss.
+     ****************************************************/
+    bool replay_evaluation(const GeneType& genes, MiddleCostType& middle_costs, vector<double>* gradient) {
+        const TraceRecord* record = evaluation_replay->find(hash_genes(genes));
+        if (record == nullptr) {
+            if (replay_miss == TraceMiss::Evaluate) return call_eval_solution(genes, middle_costs, gradient);
+            if (replay_miss == TraceMiss::Reject) return false;
+            record = &evaluation_replay->substitute();
+        }
+        if (gradient) gradient->clear();
+        ResourceLease lease = lease_eval_resources(genes);
+        if (replay_latency_scale > 0.0)
+            std::this_thread::sleep_for(std::chrono::duration<double>(record->seconds * replay_latency_scale));
+        if (!record->accepted) return false;
+        if (!deserialize_middle_costs(EvaluationTrace::payload(*record), middle_costs))
+            throw runtime_error("Cannot deserialize the middle costs of the evaluation trace.");
+        return true;
+    }
+
+    // the time excludes the wait for the resources
+    bool call_eval_solution(const GeneType& genes, MiddleCostType& middle_costs, vector<double>* gradient = nullptr) {
+        ResourceLease lease = lease_eval_resources(genes);
+        if (!evaluation_recorder) return run_eval_solution(genes, middle_costs, gradient);
+        Chronometer timer;
+        timer.tic();
+        const bool accepted = run_eval_solution(genes, middle_costs, gradient);
+        record_evaluation(genes, middle_costs, accepted, timer.toc());
+        return accepted;
+    }
+
+    void record_evaluation(const GeneType& genes, const MiddleCostType& middle_costs, bool accepted, double seconds) {
+        if (!evaluation_recorder) return;
+        const std::string payload = accepted ? serialize_middle_costs(middle_costs) : std::string();
+        evaluation_recorder->record(hash_genes(genes), accepted, payload, seconds);
+    }
+
+    // the first replication of a noisy evaluation uses the first common seed
+    bool run_eval_solution(const GeneType& genes, MiddleCostType& middle_costs, vector<double>* gradient) {
+        if (eval_solution_noisy) return eval_solution_noisy(genes, middle_costs, replication_seed(0));
+        if (eval_solution_gradient) {
+            vector<double> unused;
+            return eval_solution_gradient(genes, middle_costs, gradient ? *gradient : unused);
+        }
+        if (eval_solution_context) return eval_solution_context(genes, middle_costs, *evaluation_context);
+        if (eval_solution_staged) return eval_solution_staged(genes, middle_costs, evaluation_stages->run(genes));
+        return eval_solution(genes, middle_costs);
+    }
+
+    // blocks until the resources of the evaluation are free
+    ResourceLease lease_eval_resources(const GeneType& genes) {
+        if (!eval_resources) return ResourceLease();
+        return resource_scheduler->acquire(eval_resources(genes));
+    }
+
+    uint64_t replication_seed(unsigned long replication) const { return hash_combine(crn_seed, replication); }
+
     bool init_population_try(ThisGenerationType& generation0, ThisChromosomeType& X, int index) {
         if (is_interactive()) {
             if (eval_solution_IGA(X.genes, X.middle_costs, generation0)) {
@@ -933,7 +1817,7 @@ protected:
             }
         }
         else {
-            if (eval_solution(X.genes, X.middle_costs)) {
+            if (evaluate(X.genes, X.middle_costs, &X.gradient)) {
                 if (index >= 0) {
                     generation0.chromosomes[index] = X;
                 }
@@ -946,17 +1830,34 @@ protected:
         return false;
     }
 
+    // random state of a single worker thread
+    struct WorkerState {
+        LocalRandom rnd; // parent selection
+        vector<unsigned int> pool; // stochastic universal sampling draws not used yet
+        ParentBatch* batch = nullptr; // shared parent pairs of the offspring of last_generation
+        BulkRandom bulk; // for the *_bulk operators
+
+        void forget_selection() { pool.clear(); }
+
+        WorkerState(uint64_t seed_selection, uint64_t seed_operators)
+            : rnd(seed_selection)
+            , bulk(seed_operators) {}
+    };
+
     void init_population_range(
         ThisGenerationType* p_generation0,
         int index_from,
         int index_to,
         unsigned int* attemps,
-        std::atomic<bool>& active_thread) {
+        std::atomic<bool>& active_thread,
+        WorkerState& local) {
         for (int index = index_from; index <= index_to; index++) {
             bool accepted = false;
+            int duplicate_attempts = 0;
             while (!accepted) {
                 ThisChromosomeType X;
-                init_genes(X.genes, [this]() { return random01(); });
+                generate_genes(X.genes, local);
+                if (!filter_duplicate(X.genes, duplicate_attempts, local)) continue;
                 accepted = init_population_try(*p_generation0, X, index);
                 (*attemps)++;
             }
@@ -980,43 +1881,38 @@ protected:
         int index_from,
         int index_to,
         unsigned int* attemps,
-        std::atomic<bool>& active_thread)>
+        std::atomic<bool>& active_thread,
+        WorkerState& local)>
     void sequential_action(ThisGenerationType& generation, unsigned int N_add, unsigned int& total_attempts) {
         std::atomic<bool> dummy;
+        WorkerState local = new_action_worker_state();
+        const PerfCounterValues perf_start = perf_read();
         for (unsigned int i = 0; i < N_add && !user_request_stop; i++)
-            (this->*action_function)(&generation, -1, -1, &total_attempts, dummy);
+            (this->*action_function)(&generation, -1, -1, &total_attempts, dummy, local);
+        perf_worker_add(perf_start);
     }
 
     /****************************************************
      * Perform a given method action (population
      * initialization, or mutation/crossover) in a thread pool.
-     * The method is called by any available thread.
+     * The method is called by any available thread: every
+     * thread takes the next solution as soon as it is free.
+     * The threads live for the whole action, so per-thread
+     * resources (the random state and the performance
+     * counters) are set up once per thread and not once
+     * per solution.
      ****************************************************/
     template<void (ThisType::*action_function)(
         ThisGenerationType* p_generation0,
         int index_from,
         int index_to,
         unsigned int* attemps,
-        std::atomic<bool>& active_thread)>
+        std::atomic<bool>& active_thread,
+        WorkerState& local)>
     void dynamic_thread_action(ThisGenerationType& generation, unsigned int N_add, unsigned int& total_attempts) {
-        vector<atomic<bool>> active_threads(N_threads);
-        for (auto& at : active_threads) std::atomic_init(&at, false);
-
         vector<unsigned int> attempts;
         attempts.assign(N_threads, 0);
 
-        // Initialize the thread pool
-        vector<std::thread> thread_pool;
-        thread_pool.reserve(N_threads);
-        for (int i = 0; i < N_threads; i++) {
-            thread_pool.push_back(std::thread());
-        }
-        for (std::thread& th : thread_pool) {
-            if (th.joinable()) {
-                th.join();
-            }
-        }
-
         unsigned int offset = (unsigned int)generation.chromosomes.size();
 
         // Pre-fill the new solutions
@@ -1024,42 +1920,32 @@ protected:
             generation.chromosomes.push_back(ThisChromosomeType());
         }
 
-        unsigned int x_index = 0;
-        while (x_index < N_add && !user_request_stop) {
-            int free_thread = -1;
-            for (int i = 0; i < N_threads && free_thread < 0; i++)
-                if (!active_threads[i]) {
-                    free_thread = i;
-                    if (thread_pool[free_thread].joinable()) {
-                        thread_pool[free_thread].join();
-                    }
-                }
-            if (free_thread > -1) {
-                active_threads[free_thread] = true;
-                thread_pool[free_thread] = std::thread(
-                    action_function,
-                    this,
-                    &generation,
-                    offset + int(x_index), /* from */
-                    offset + int(x_index), /* to */
-                    &attempts[free_thread],
-                    std::ref(active_threads[free_thread]));
-                x_index++;
-            }
-            else {
-                idle();
-            }
+        std::atomic<unsigned int> next_index(0);
+        std::atomic<int> finished_threads(0);
+        vector<WorkerState> states = new_action_worker_states(N_threads);
+        vector<std::thread> thread_pool;
+        thread_pool.reserve(N_threads);
+        for (int i = 0; i < N_threads; i++) {
+            thread_pool.push_back(std::thread([&, i]() {
+                std::atomic<bool> active_thread(true);
+                const PerfCounterValues perf_start = perf_read();
+                for (unsigned int x_index = next_index++; x_index < N_add && !user_request_stop;
+                     x_index = next_index++)
+                    (this->*action_function)(
+                        &generation,
+                        int(offset + x_index),
+                        int(offset + x_index),
+                        &attempts[i],
+                        active_thread,
+                        states[i]);
+                perf_worker_add(perf_start);
+                finished_threads++;
+            }));
         }
 
-        bool all_tasks_finished;
-        do {
-            all_tasks_finished = true;
-            for (int i = 0; i < N_threads; i++)
-                if (active_threads[i]) all_tasks_finished = false;
-            if (!all_tasks_finished) idle();
-        } while (!all_tasks_finished);
+        // keep the user interface alive until the tasks are finished
+        while (finished_threads < N_threads) idle();
 
-        // wait for tasks to finish
         for (std::thread& th : thread_pool)
             if (th.joinable()) th.join();
 
@@ -1080,7 +1966,8 @@ protected:
         int index_from,
         int index_to,
         unsigned int* attemps,
-        std::atomic<bool>& active_thread)>
+        std::atomic<bool>& active_thread,
+        WorkerState& local)>
     void static_thread_action(ThisGenerationType& generation, unsigned int N_add, unsigned int& total_attempts) {
         vector<atomic<bool>> active_threads(N_threads);
         for (auto& at : active_threads) std::atomic_init(&at, false);
@@ -1100,6 +1987,7 @@ protected:
         for (unsigned int i = 0; i < N_add; i++) generation.chromosomes.push_back(ThisChromosomeType());
 
         // Use determined thread pools
+        vector<WorkerState> states = new_action_worker_states(N_threads);
         int x_index_start = offset;
         int x_index_end = 0;
         int pop_chunk = std::max(int(N_add / N_threads), 1);
@@ -1111,14 +1999,12 @@ protected:
 
             if (x_index_end >= x_index_start) {
                 active_threads[i] = true;
-                thread_pool[i] = std::thread(
-                    action_function,
-                    this,
-                    &generation,
-                    x_index_start,
-                    x_index_end,
-                    &attempts[i],
-                    std::ref(active_threads[i]));
+                thread_pool[i] = std::thread([&, i, x_index_start, x_index_end]() {
+                    const PerfCounterValues perf_start = perf_read();
+                    (this->*action_function)(
+                        &generation, x_index_start, x_index_end, &attempts[i], active_threads[i], states[i]);
+                    perf_worker_add(perf_start);
+                });
             }
             x_index_start = x_index_end + 1;
         }
@@ -1138,6 +2024,125 @@ protected:
         for (unsigned int ac : attempts) total_attempts += ac;
     }
 
+    /****************************************************
+     * IGA pipeline mode: the missing candidates of a
+     * generation are prepared in parallel and each one is
+     * published to the user interface as soon as it is
+     * ready, so the user can rate the first candidates
+     * while the rest are still being prepared. Offspring
+     * bred speculatively during the previous rating phase
+     * are used first. eval_solution_IGA only sees the
+     * candidates which existed before this call.
+     ****************************************************/
+    void IGA_pipeline_action(
+        ThisGenerationType& generation, unsigned int N_add, bool offspring, unsigned int& total_attempts) {
+        const unsigned int offset = (unsigned int)generation.chromosomes.size();
+        const unsigned int N_total = offset + N_add;
+        const ThisGenerationType snapshot = generation;
+        iga_pipeline->begin_batch(N_total);
+        generation.chromosomes.resize(N_total);
+        for (unsigned int i = 0; i < offset; i++) iga_pipeline->publish(i, generation.chromosomes[i]);
+
+        unsigned int next = offset;
+        ThisChromosomeType X;
+        while (offspring && next < N_total && iga_pipeline->pop_speculative(X)) {
+            generation.chromosomes[next] = X;
+            iga_pipeline->publish(next, X);
+            next++;
+        }
+        if (verbose && offspring) cout << (next - offset) << " speculative candidates are used." << endl;
+        iga_pipeline->clear_speculative(); // the rest was bred from older parents
+
+        std::atomic<unsigned int> next_index(next);
+        std::atomic<unsigned int> attempts(0);
+        std::atomic<int> finished_workers(0);
+        auto worker = [&]() {
+            WorkerState local = new_worker_state();
+            local.batch = parent_batch.get();
+            for (unsigned int i = next_index++; i < N_total && !user_request_stop; i = next_index++) {
+                ThisChromosomeType Y;
+                int duplicate_attempts = 0;
+                bool accepted = false;
+                while (!accepted) {
+                    if (offspring)
+                        Y.genes = breed_offspring(last_generation, local);
+                    else
+                        generate_genes(Y.genes, local);
+                    if (!filter_duplicate(Y.genes, duplicate_attempts, local)) continue;
+                    attempts++;
+                    accepted = eval_solution_IGA(Y.genes, Y.middle_costs, snapshot);
+                }
+                generation.chromosomes[i] = Y;
+                iga_pipeline->publish(i, Y);
+            }
+            finished_workers++;
+        };
+
+        int N_workers = multi_threading ? std::min(N_threads, int(N_total - next)) : 0;
+        if (N_workers < 1) {
+            worker();
+        }
+        else {
+            vector<std::thread> workers;
+            for (int i = 0; i < N_workers; i++) workers.push_back(std::thread(worker));
+            while (finished_workers < N_workers) idle(); // keep the user interface alive
+            for (std::thread& th : workers) th.join();
+        }
+        total_attempts += attempts;
+    }
+
+    /****************************************************
+     * IGA pipeline mode: waits for the user ratings of a
+     * generation. Meanwhile, offspring for the next
+     * generation are bred and evaluated speculatively
+     * from the ranking of the ratings given so far. A
+     * speculator reserves its slot in the pool before
+     * breeding, so no more than IGA_speculative_candidates
+     * are prepared. eval_solution_IGA sees a snapshot of
+     * the rated generation.
+     ****************************************************/
+    void wait_IGA_ratings(ThisGenerationType& g) {
+        int limit = IGA_speculative_candidates < 0 ? int(population) - elite_count : IGA_speculative_candidates;
+        bool speculate = multi_threading && limit > 0 && generation_step < generation_max;
+        std::atomic<bool> rating_done(false);
+        const ThisGenerationType snapshot = g; // shared read-only context of eval_solution_IGA
+        auto speculator = [&]() {
+            ThisGenerationType provisional = g;
+            WorkerState local = new_worker_state();
+            vector<double> costs;
+            while (!rating_done && !user_request_stop && iga_pipeline->reserve_speculative(std::size_t(limit))) {
+                bool accepted = false;
+                int duplicate_attempts = 0;
+                while (!accepted && !rating_done && !user_request_stop) {
+                    iga_pipeline->provisional_costs(costs);
+                    for (unsigned int i = 0; i < provisional.chromosomes.size(); i++)
+                        provisional.chromosomes[i].total_cost = costs[i];
+                    rank_population_SO(provisional);
+                    local.forget_selection(); // drawn from the previous ranking
+                    ThisChromosomeType X;
+                    X.genes = breed_offspring(provisional, local);
+                    if (!filter_duplicate(X.genes, duplicate_attempts, local)) continue;
+                    accepted = eval_solution_IGA(X.genes, X.middle_costs, snapshot);
+                    if (accepted) iga_pipeline->push_speculative(X);
+                }
+                if (!accepted) iga_pipeline->release_speculative();
+            }
+        };
+        vector<std::thread> speculators;
+        if (speculate)
+            for (int i = 0; i < N_threads; i++) speculators.push_back(std::thread(speculator));
+
+        while (!user_request_stop && !iga_pipeline->wait_all_rated(std::max(idle_delay_us, 1L)))
+            if (custom_refresh != nullptr) custom_refresh();
+        rating_done = true;
+        for (std::thread& th : speculators) th.join();
+
+        vector<double> costs;
+        iga_pipeline->provisional_costs(costs);
+        for (unsigned int i = 0; i < g.chromosomes.size(); i++) g.chromosomes[i].total_cost = costs[i];
+        if (calculate_IGA_total_fitness != nullptr) calculate_IGA_total_fitness(g);
+    }
+
     /****************************************************
      * This function generates the initial population
      ****************************************************/
@@ -1158,7 +2163,10 @@ protected:
         }
 
         unsigned int total_attempts = 0;
-        if (!multi_threading || N_threads == 1 || is_interactive()) {
+        if (iga_pipeline) {
+            IGA_pipeline_action(generation0, N_add, false, total_attempts);
+        }
+        else if (!multi_threading || N_threads == 1 || is_interactive()) {
             sequential_action<&ThisType::init_population_range>(generation0, N_add, total_attempts);
         }
         else {
@@ -1180,12 +2188,245 @@ protected:
         }
     }
 
-    int select_parent(const ThisGenerationType& g) {
-        int N_max = int(g.chromosomes.size());
-        double r = random01();
-        int position = 0;
-        while (position < N_max && g.selection_chance_cumulative[position] < r) position++;
-        return position;
+    WorkerState new_worker_state() {
+        std::lock_guard<std::mutex> lock(mtx_rand);
+        uint64_t seed_selection = rng();
+        return WorkerState(seed_selection, rng());
+    }
+
+    // state of a worker of a thread action, which takes its parents from parent_batch
+    WorkerState new_action_worker_state() {
+        WorkerState local = new_worker_state();
+        local.batch = parent_batch.get();
+        return local;
+    }
+
+    // the states of all workers of a thread action, seeded in order on the calling thread
+    vector<WorkerState> new_action_worker_states(int N_workers) {
+        vector<WorkerState> states;
+        states.reserve(std::size_t(std::max(N_workers, 0)));
+        for (int i = 0; i < N_workers; i++) states.push_back(new_action_worker_state());
+        return states;
+    }
+
+    void generate_genes(GeneType& genes, WorkerState& local) {
+        if (init_genes_bulk)
+            init_genes_bulk(genes, local.bulk);
+        else
+            init_genes(genes, [this]() { return random01(); });
+    }
+
+    GeneType mutate_genes(const GeneType& genes, WorkerState& local) {
+        double shrink_scale = get_shrink_scale(generation_step, [this]() { return random01(); });
+        if (mutate_bulk) return mutate_bulk(genes, local.bulk, shrink_scale);
+        return mutate(
+            genes, [this]() { return random01(); }, shrink_scale);
+    }
+
+    /****************************************************
+     * Draws a parent with the selection strategy. Only the
+     * state of the calling worker is modified, so the
+     * workers select in parallel without any lock.
+     ****************************************************/
+    unsigned int select_parent(const ThisGenerationType& g, WorkerState& local) {
+        const unsigned int N = (unsigned int)g.chromosomes.size();
+        switch (selection_strategy) {
+        case SelectionStrategy::Tournament:
+            if (is_single_objective()) {
+                return tournament_select(
+                    N,
+                    tournament_size,
+                    [&g](unsigned int a, unsigned int b) {
+                        return g.chromosomes[a].total_cost < g.chromosomes[b].total_cost;
+                    },
+                    local.rnd);
+            }
+            return tournament_select(
+                N,
+                tournament_size,
+                [&g](unsigned int a, unsigned int b) { return g.ranks[a] < g.ranks[b]; },
+                local.rnd);
+        case SelectionStrategy::CrowdedTournament:
+            return tournament_select(
+                N,
+                tournament_size,
+                [&g](unsigned int a, unsigned int b) {
+                    return g.ranks[a] < g.ranks[b] ||
+                        (g.ranks[a] == g.ranks[b] && g.crowding_distance[a] > g.crowding_distance[b]);
+                },
+                local.rnd);
+        case SelectionStrategy::StochasticUniversal: {
+            // parents of another generation, or draws beyond the batch after rejected offspring
+            if (local.pool.empty())
+                stochastic_universal_sampling(g.selection_chance_cumulative, N, local.pool, local.rnd);
+            unsigned int parent = local.pool.back();
+            local.pool.pop_back();
+            return parent;
+        }
+        case SelectionStrategy::Lexicase:
+            return lexicase_select(
+                N,
+                N_selection_objectives(g),
+                [this, &g](unsigned int i, unsigned int c) { return selection_objective(g.chromosomes[i], c); },
+                local.rnd);
+        default: return roulette_select(g.selection_chance_cumulative, local.rnd());
+        }
+    }
+
+    void select_parent_pair(
+        const ThisGenerationType& parents, WorkerState& local, unsigned int& pidx_c1, unsigned int& pidx_c2) {
+        int tries = 0;
+        do {
+            pidx_c1 = select_parent(parents, local);
+            pidx_c2 = select_parent(parents, local);
+        } while (pidx_c1 == pidx_c2 && ++tries < 100);
+        if (pidx_c1 == pidx_c2) { // the strategy keeps picking the same member
+            const unsigned int N = (unsigned int)parents.chromosomes.size();
+            pidx_c2 = (pidx_c1 + 1 + local.rnd.below(N - 1)) % N;
+        }
+    }
+
+    // parents are last_generation if local has a batch
+    GeneType breed_offspring(const ThisGenerationType& parents, WorkerState& local) {
+        unsigned int pidx_c1, pidx_c2;
+        const bool planned = take_parent_pair(local, pidx_c1, pidx_c2);
+        if (mutate_gradient && local.rnd() < gradient_mutation_rate) {
+            const ThisChromosomeType& parent = parents.chromosomes[planned ? pidx_c1 : select_parent(parents, local)];
+            if (!parent.gradient.empty()) { // members restored from the evaluation_store have none
+                if (verbose) cout << "Gradient mutation of a chromosome" << endl;
+                double shrink_scale = get_shrink_scale(generation_step, [this]() { return random01(); });
+                return mutate_gradient(parent, local.bulk, shrink_scale);
+            }
+        }
+        if (!planned) select_parent_pair(parents, local, pidx_c1, pidx_c2);
+        if (verbose) cout << "Crossover of chromosomes " << pidx_c1 << "," << pidx_c2 << endl;
+        return recombine(parents.chromosomes[pidx_c1].genes, parents.chromosomes[pidx_c2].genes, local);
+    }
+
+    // crossover of the parents, mutated with mutation_rate
+    GeneType recombine(const GeneType& p1, const GeneType& p2, WorkerState& local) {
+        GeneType X = crossover_bulk ? crossover_bulk(p1, p2, local.bulk)
+                                    : crossover(p1, p2, [this]() { return random01(); });
+        if (random01() <= mutation_rate * mutation_boost) {
+            if (verbose) cout << "Mutation of chromosome " << endl;
+            X = mutate_genes(X, local);
+        }
+        return X;
+    }
+
+    /****************************************************
+     * Duplicate elimination: returns false if the genes
+     * were already seen in the current or the recent
+     * generations and should not be evaluated. A duplicate
+     * is mutated up to duplicate_retry_max times first.
+     * After duplicate_retry_max rejections for the same
+     * slot, the duplicate is let through so that the
+     * generation can always be completed.
+     ****************************************************/
+    bool filter_duplicate(GeneType& genes, int& rejected_attempts, WorkerState& local) {
+        if (!duplicate_fingerprints) return true;
+        if (duplicate_fingerprints->insert(hash_genes(genes), generation_step)) return true;
+        duplicate_fingerprints->n_detected++;
+        for (int i = 0; i < duplicate_retry_max; i++) {
+            genes = mutate_genes(genes, local);
+            if (duplicate_fingerprints->insert(hash_genes(genes), generation_step)) {
+                duplicate_fingerprints->n_remutated++;
+                return true;
+            }
+        }
+        if (++rejected_attempts > duplicate_retry_max) {
+            duplicate_fingerprints->n_accepted++;
+            return true;
+        }
+        duplicate_fingerprints->n_rejected++;
+        return false;
+    }
+
+    // counts of the calling thread, if collect_perf_counters
+    PerfCounterValues perf_read() const {
+        return perf_workers ? thread_perf_counters().read() : PerfCounterValues();
+    }
+
+    // adds the counts since mark to the phase and moves the mark
+    void perf_phase(PerfMetrics& perf, EnginePhase phase, PerfCounterValues& mark) const {
+        if (!perf_workers) return;
+        const PerfCounterValues now = thread_perf_counters().read();
+        perf.phase(phase).add(now.since(mark));
+        mark = now;
+    }
+
+    void perf_collect(PerfMetrics& perf, ThisGenerationType& g) const {
+        if (!perf_workers) return;
+        perf.workers = perf_workers->take();
+        g.perf = perf;
+    }
+
+    void perf_worker_add(const PerfCounterValues& start) const {
+        if (perf_workers) perf_workers->add(thread_perf_counters().read().since(start));
+    }
+
+    /****************************************************
+     * Selects the parent pairs of all N_add offspring of
+     * last_generation before they are bred. The workers
+     * share the pairs in order, which lets a worker page
+     * in the parents of the pairs that are taken after the
+     * ones being bred (prefetch_genes). Under stochastic
+     * universal sampling, the parents are drawn in a
+     * single pass, so the low variance of the sampling
+     * holds for the generation and not only within a
+     * worker.
+     ****************************************************/
+    void draw_parent_batch(unsigned int N_add, unsigned int N_workers) {
+        parent_batch = nullptr;
+        const bool SUS = selection_strategy == SelectionStrategy::StochasticUniversal;
+        if (!SUS && !prefetch_genes) return;
+        WorkerState local = new_worker_state();
+        const ThisGenerationType& g = last_generation;
+        vector<unsigned int> parents;
+        if (SUS) {
+            stochastic_universal_sampling(g.selection_chance_cumulative, 2 * N_add, parents, local.rnd);
+            // a member paired with itself swaps partners with a later pair
+            for (std::size_t k = 0; k + 1 < parents.size(); k += 2)
+                for (std::size_t j = k + 2; j < parents.size() && parents[k] == parents[k + 1]; j++)
+                    if (parents[j] != parents[k]) std::swap(parents[k + 1], parents[j]);
+        }
+        else {
+            parents.resize(2 * N_add);
+            for (unsigned int k = 0; k < N_add; k++) select_parent_pair(g, local, parents[2 * k], parents[2 * k + 1]);
+        }
+        parent_batch = std::make_shared<ParentBatch>(parents);
+        parent_lookahead = std::max(N_workers, 1u);
+        unsigned int p1, p2;
+        for (std::size_t k = 0; prefetch_genes && k < parent_lookahead && parent_batch->pair(k, p1, p2); k++) {
+            prefetch_genes(g.chromosomes[p1].genes);
+            prefetch_genes(g.chromosomes[p2].genes);
+        }
+    }
+
+    /****************************************************
+     * Takes the next parent pair of the batch. Each worker
+     * breeds one pair at a time, so the pairs up to
+     * parent_lookahead ahead are bred right now and their
+     * parents are already paged in. The pair after them
+     * is prefetched while this one is bred.
+     ****************************************************/
+    bool take_parent_pair(WorkerState& local, unsigned int& pidx_c1, unsigned int& pidx_c2) {
+        std::size_t k;
+        if (!local.batch || !local.batch->take(pidx_c1, pidx_c2, k)) return false;
+        unsigned int p1, p2;
+        if (prefetch_genes && local.batch->pair(k + parent_lookahead, p1, p2)) {
+            prefetch_genes(last_generation.chromosomes[p1].genes);
+            prefetch_genes(last_generation.chromosomes[p2].genes);
+        }
+        return true;
+    }
+
+    // The survivors of the last generation take part in the duplicate search.
+    void refresh_fingerprints() {
+        if (!duplicate_fingerprints) return;
+        duplicate_fingerprints->expire(generation_step - duplicate_memory);
+        for (const ThisChromosomeType& c : last_generation.chromosomes)
+            duplicate_fingerprints->touch(hash_genes(c.genes), generation_step);
     }
 
     void crossover_and_mutation_range(
@@ -1193,27 +2434,17 @@ protected:
         int x_index_begin,
         int x_index_end,
         unsigned int* attemps,
-        std::atomic<bool>& active_thread) {
+        std::atomic<bool>& active_thread,
+        WorkerState& local) {
         for (int index = x_index_begin; index <= x_index_end; index++) {
             if (verbose) cout << "Action: crossover" << endl;
 
             bool successful = false;
+            int duplicate_attempts = 0;
             while (!successful) {
                 ThisChromosomeType X;
-
-                int pidx_c1 = select_parent(last_generation);
-                int pidx_c2 = select_parent(last_generation);
-                if (pidx_c1 == pidx_c2) continue;
-                if (verbose) cout << "Crossover of chromosomes " << pidx_c1 << "," << pidx_c2 << endl;
-                GeneType Xp1 = last_generation.chromosomes[pidx_c1].genes;
-                GeneType Xp2 = last_generation.chromosomes[pidx_c2].genes;
-                X.genes = crossover(Xp1, Xp2, [this]() { return random01(); });
-                if (random01() <= mutation_rate) {
-                    if (verbose) cout << "Mutation of chromosome " << endl;
-                    double shrink_scale = get_shrink_scale(generation_step, [this]() { return random01(); });
-                    X.genes = mutate(
-                        X.genes, [this]() { return random01(); }, shrink_scale);
-                }
+                X.genes = breed_offspring(last_generation, local);
+                if (!filter_duplicate(X.genes, duplicate_attempts, local)) continue;
                 if (is_interactive()) {
                     if (eval_solution_IGA(X.genes, X.middle_costs, *p_new_generation)) {
                         p_new_generation->chromosomes.push_back(X);
@@ -1223,7 +2454,7 @@ protected:
                         (*attemps)++;
                 }
                 else {
-                    if (eval_solution(X.genes, X.middle_costs)) {
+                    if (evaluate(X.genes, X.middle_costs, &X.gradient)) {
                         if (index >= 0)
                             p_new_generation->chromosomes[index] = X;
                         else
@@ -1253,7 +2484,13 @@ protected:
                 throw runtime_error("In IGA mode, elite fraction + crossover fraction must be equal to 1.0 !");
         }
 
-        if (!multi_threading || N_threads == 1 || is_interactive()) {
+        refresh_fingerprints();
+        const bool sequential = !multi_threading || N_threads == 1 || is_interactive();
+        draw_parent_batch(N_add, iga_pipeline || !sequential ? (unsigned int)N_threads : 1u);
+        if (iga_pipeline) {
+            IGA_pipeline_action(new_generation, N_add, true, total_attempts);
+        }
+        else if (sequential) {
             sequential_action<&ThisType::crossover_and_mutation_range>(new_generation, N_add, total_attempts);
         }
         else {
@@ -1266,10 +2503,212 @@ protected:
                 static_thread_action<&ThisType::crossover_and_mutation_range>(new_generation, N_add, total_attempts);
             }
         }
+        parent_batch = nullptr;
 
         if (verbose) {
             cout << "Mutations and crossovers of " << N_add << " solutions are calculated with " << total_attempts
                  << " attemps." << endl;
+            if (duplicate_fingerprints) {
+                DuplicateStats stats = duplicate_fingerprints->stats();
+                cout << "Duplicates so far: " << stats.detected << " detected, " << stats.remutated << " re-mutated, "
+                     << stats.rejected << " rejected, " << stats.accepted << " accepted, " << stats.saved()
+                     << " evaluations saved." << endl;
+            }
+        }
+    }
+
+    /****************************************************
+     * Estimation-of-distribution mode: instead of crossover
+     * and mutation, the offspring are drawn from a
+     * DistributionModel fitted to the best
+     * eda_selection_fraction of the ranked last generation
+     * (fronts first in multi-objective mode). The genes
+     * are encoded and the model is fitted on the worker
+     * threads, the batch is sampled at once and evaluated
+     * in parallel. A rejected member is replaced by a new
+     * draw. The survivors are selected as usual.
+     ****************************************************/
+    void sample_offspring(ThisGenerationType& new_generation) {
+        if (user_request_stop) return;
+        transfer(new_generation);
+        if (generation_step <= 0) return;
+
+        const ThisGenerationType& g = last_generation;
+        vector<unsigned int> ranked;
+        if (is_single_objective())
+            ranked.assign(g.sorted_indices.begin(), g.sorted_indices.end());
+        else
+            for (const vector<unsigned int>& front : g.fronts) ranked.insert(ranked.end(), front.begin(), front.end());
+        const unsigned int N_ranked = (unsigned int)ranked.size();
+        const unsigned int N_selected = std::min(
+            N_ranked, std::max(2u, (unsigned int)std::lround(eda_selection_fraction * double(N_ranked))));
+        const int N_workers = multi_threading ? std::max(1, N_threads) : 1;
+
+        vector<vector<unsigned int>> selected(N_selected);
+        const int N_encoders = std::min(N_workers, int(N_selected));
+        run_on_workers(N_encoders, [&](int w) {
+            for (unsigned int i = (unsigned int)w; i < N_selected; i += (unsigned int)N_encoders)
+                eda_encode(g.chromosomes[ranked[i]].genes, selected[i]);
+        });
+        if (!eda_model) {
+            vector<unsigned int> cardinality = eda_cardinality;
+            if (cardinality.empty()) cardinality.assign(selected[0].size(), 2);
+            eda_model = std::make_shared<DistributionModel>(cardinality, eda_mode);
+            eda_model->learning_rate = PBIL_learning_rate;
+            eda_model->linkage_threshold = linkage_threshold;
+            eda_model->max_block = linkage_max_block;
+        }
+        eda_model->margin = eda_probability_margin * mutation_boost;
+        eda_model->fit(selected, N_workers);
+
+        const unsigned int N_add = (unsigned int)(std::round(double(population) * crossover_fraction));
+        vector<vector<unsigned int>> batch;
+        {
+            uint64_t seed;
+            {
+                std::lock_guard<std::mutex> lock(mtx_rand);
+                seed = rng();
+            }
+            BulkRandom bulk(seed);
+            eda_model->sample(N_add, bulk, batch);
+        }
+
+        const unsigned int offset = (unsigned int)new_generation.chromosomes.size();
+        new_generation.chromosomes.resize(offset + N_add);
+        std::atomic<unsigned int> next_task(0);
+        run_on_workers(std::min(N_workers, int(N_add)), [&](int) {
+            WorkerState local = new_worker_state();
+            const PerfCounterValues perf_start = perf_read();
+            vector<vector<unsigned int>> redraw;
+            for (unsigned int t = next_task++; t < N_add && !user_request_stop; t = next_task++) {
+                ThisChromosomeType& X = new_generation.chromosomes[offset + t];
+                eda_decode(batch[t], X.genes);
+                while (!evaluate(X.genes, X.middle_costs, &X.gradient) && !user_request_stop) {
+                    eda_model->sample(1, local.bulk, redraw);
+                    eda_decode(redraw[0], X.genes);
+                }
+            }
+            perf_worker_add(perf_start);
+        });
+    }
+
+    /****************************************************
+     * Age-layered population structure (ALPS). Here,
+     * population is the size of a layer. The age of a
+     * member is the number of generations since its oldest
+     * ancestor was created by init_genes. Every layer
+     * breeds from parents of its own layer and the layer
+     * below, picked by tournaments of tournament_size, and
+     * the offspring of all layers are evaluated together
+     * on the worker threads. Every ALPS_age_gap generations
+     * the bottom layer moves up and is replaced by fresh
+     * random members. A member older than the age limit
+     * of its layer competes in the layer above, the top
+     * layer has no limit. The layers above the bottom
+     * open as soon as members reach them.
+     ****************************************************/
+    unsigned int ALPS_age_limit(unsigned int layer) const {
+        if (layer + 1 >= ALPS_layers) return std::numeric_limits<unsigned int>::max();
+        const unsigned int scheme = layer < 2 ? layer + 1 : layer * layer; // 1, 2, 4, 9, 16, ...
+        return ALPS_age_gap * scheme;
+    }
+
+    unsigned int ALPS_age(const ThisChromosomeType& X) const { return (unsigned int)(generation_step - X.birth); }
+
+    void breed_age_layers(ThisGenerationType& new_generation) {
+        if (user_request_stop) return;
+        const vector<vector<unsigned int>>& layers = last_generation.layers;
+        const unsigned int N_old_layers = (unsigned int)layers.size();
+        const bool reseed = generation_step % int(ALPS_age_gap) == 0;
+        new_generation.chromosomes = last_generation.chromosomes;
+        new_generation.layers.assign(std::min(N_old_layers + (reseed ? 1u : 0u), ALPS_layers), vector<unsigned int>());
+        for (unsigned int l = 0; l < N_old_layers; l++) {
+            const unsigned int target = (reseed && l == 0 && ALPS_layers > 1) ? 1 : l;
+            for (unsigned int i : layers[l]) new_generation.layers[target].push_back(i);
+        }
+
+        // parents of layer l come from layers l and l-1
+        const unsigned int N_offspring = (unsigned int)(std::round(double(population) * crossover_fraction));
+        vector<vector<unsigned int>> pools(N_old_layers);
+        vector<unsigned int> task_layer;
+        for (unsigned int l = 0; l < N_old_layers; l++) {
+            if (reseed && l == 0) continue;
+            pools[l] = layers[l];
+            if (l > 0) pools[l].insert(pools[l].end(), layers[l - 1].begin(), layers[l - 1].end());
+            if (pools[l].size() < 2) continue;
+            for (unsigned int k = 0; k < N_offspring; k++) task_layer.push_back(l);
+        }
+        const unsigned int N_fresh = reseed ? population : 0;
+        const unsigned int N_tasks = N_fresh + (unsigned int)task_layer.size();
+        const unsigned int offset = (unsigned int)new_generation.chromosomes.size();
+        new_generation.chromosomes.resize(offset + N_tasks);
+
+        refresh_fingerprints();
+        std::atomic<unsigned int> next_task(0);
+        run_on_workers(multi_threading ? std::min(N_threads, int(N_tasks)) : 1, [&](int) {
+            WorkerState local = new_worker_state();
+            const PerfCounterValues perf_start = perf_read();
+            for (unsigned int t = next_task++; t < N_tasks && !user_request_stop; t = next_task++) {
+                ThisChromosomeType& X = new_generation.chromosomes[offset + t];
+                int duplicate_attempts = 0;
+                bool accepted = false;
+                while (!accepted && !user_request_stop) {
+                    if (t < N_fresh) {
+                        generate_genes(X.genes, local);
+                        X.birth = generation_step;
+                    }
+                    else {
+                        const vector<unsigned int>& pool = pools[task_layer[t - N_fresh]];
+                        auto better = [&](unsigned int a, unsigned int b) {
+                            return last_generation.chromosomes[pool[a]].total_cost <
+                                last_generation.chromosomes[pool[b]].total_cost;
+                        };
+                        const unsigned int N = (unsigned int)pool.size();
+                        const unsigned int i1 = tournament_select(N, tournament_size, better, local.rnd);
+                        unsigned int i2 = tournament_select(N, tournament_size, better, local.rnd);
+                        if (i2 == i1) i2 = (i1 + 1 + local.rnd.below(N - 1)) % N;
+                        const ThisChromosomeType& p1 = last_generation.chromosomes[pool[i1]];
+                        const ThisChromosomeType& p2 = last_generation.chromosomes[pool[i2]];
+                        X.genes = recombine(p1.genes, p2.genes, local);
+                        X.birth = std::min(p1.birth, p2.birth);
+                    }
+                    if (!filter_duplicate(X.genes, duplicate_attempts, local)) continue;
+                    accepted = evaluate(X.genes, X.middle_costs, &X.gradient);
+                }
+            }
+            perf_worker_add(perf_start);
+        });
+        for (unsigned int t = 0; t < N_tasks; t++)
+            new_generation.layers[t < N_fresh ? 0 : task_layer[t - N_fresh]].push_back(offset + t);
+    }
+
+    // The best members of each layer survive, the ones too old for their layer move up.
+    void select_population_ALPS(const ThisGenerationType& g, ThisGenerationType& g2) {
+        if (generation_step <= 0) {
+            g2 = g;
+            return;
+        }
+        vector<unsigned int> promoted;
+        for (unsigned int l = 0; l < ALPS_layers && (l < g.layers.size() || !promoted.empty()); l++) {
+            vector<unsigned int> candidates;
+            candidates.swap(promoted);
+            if (l < g.layers.size()) candidates.insert(candidates.end(), g.layers[l].begin(), g.layers[l].end());
+            vector<unsigned int> kept;
+            for (unsigned int i : candidates) {
+                if (ALPS_age(g.chromosomes[i]) > ALPS_age_limit(l))
+                    promoted.push_back(i);
+                else
+                    kept.push_back(i);
+            }
+            std::stable_sort(kept.begin(), kept.end(), [&g](unsigned int a, unsigned int b) {
+                return g.chromosomes[a].total_cost < g.chromosomes[b].total_cost;
+            });
+            if (kept.size() > population) kept.resize(population);
+            g2.layers.push_back(vector<unsigned int>());
+            for (unsigned int i : kept) {
+                g2.layers.back().push_back((unsigned int)g2.chromosomes.size());
+                g2.chromosomes.push_back(g.chromosomes[i]);
+            }
         }
     }
 
@@ -1296,26 +2735,179 @@ protected:
 
         if (best_stall_count >= best_stall_max) return StopReason::StallBest;
 
+        if (diversity_collapsed && diversity_action == DiversityAction::Stop) return StopReason::DiversityCollapse;
+
         if (user_request_stop) return StopReason::UserRequest;
 
         return StopReason::Undefined;
     }
 
+    /****************************************************
+     * Evaluates the given members on the thread pool. The
+     * genes are kept, replaced by random genes or by a
+     * hypermutant of a random member depending on the
+     * response. Rejected genes are replaced by random ones
+     * until they are accepted. The evaluations go through
+     * evaluate(), so they use the evaluation_store and the
+     * evaluation_replay like the rest of the run.
+     ****************************************************/
+    void evaluate_members(ThisGenerationType& g, const vector<unsigned int>& members, ChangeResponse response) {
+        const unsigned int N_tasks = (unsigned int)members.size();
+        if (N_tasks == 0) return;
+        vector<GeneType> mutation_source;
+        if (response == ChangeResponse::Hypermutation) {
+            const unsigned int N = (unsigned int)g.chromosomes.size();
+            for (unsigned int t = 0; t < N_tasks; t++)
+                mutation_source.push_back(g.chromosomes[(unsigned int)(random01() * N) % N].genes);
+        }
+        std::atomic<unsigned int> next_task(0);
+        run_on_workers(multi_threading ? std::min(N_threads, int(N_tasks)) : 1, [&](int) {
+            WorkerState local = new_worker_state();
+            for (unsigned int t = next_task++; t < N_tasks && !user_request_stop; t = next_task++) {
+                ThisChromosomeType& X = g.chromosomes[members[t]];
+                if (response == ChangeResponse::RandomImmigrants) generate_genes(X.genes, local);
+                if (response == ChangeResponse::Hypermutation) X.genes = mutate_genes(mutation_source[t], local);
+                X.cost_samples = RunningStats();
+                X.gradient.clear();
+                X.serial = 0; // a new member for the snapshots
+                X.retained = RetainedMiddleCosts();
+                while (!evaluate(X.genes, X.middle_costs, &X.gradient) && !user_request_stop)
+                    generate_genes(X.genes, local);
+            }
+        });
+    }
+
+    /****************************************************
+     * Noisy evaluations: every chromosome keeps the
+     * statistics of its total cost over the replications
+     * and survivors carry them to the next generations.
+     * New members are replicated noise_min_replications
+     * times. The extra budget goes to the members near the
+     * boundary of the elites (OCBA), in rounds of one
+     * replication per thread. It is spent once per
+     * generation: the immigrants evaluated after the
+     * selection only get their minimum replications.
+     * Replication k of every member uses the same seed
+     * (common random numbers), so that the members are
+     * compared under the same conditions.
+     * The total cost becomes the mean of the replications.
+     ****************************************************/
+    void resample_noisy(ThisGenerationType& g) {
+        const unsigned int N = (unsigned int)g.chromosomes.size();
+        vector<unsigned int> extra(N, 0);
+        for (unsigned int i = 0; i < N; i++) {
+            RunningStats& stats = g.chromosomes[i].cost_samples;
+            if (stats.n == 0) stats.add(g.chromosomes[i].total_cost); // the regular evaluation
+            if (stats.n < noise_min_replications) extra[i] = noise_min_replications - (unsigned int)stats.n;
+        }
+        run_replications(g, extra);
+
+        unsigned int budget = noise_replications_budget < 0 ? population : (unsigned int)noise_replications_budget;
+        if (noise_budget_step == generation_step) budget = 0;
+        noise_budget_step = generation_step;
+        const unsigned int round = multi_threading ? (unsigned int)std::max(N_threads, 1) : 1u;
+        const unsigned int m = (unsigned int)std::max(elite_count, 1);
+        vector<RunningStats> stats(N);
+        while (budget > 0 && !user_request_stop) {
+            for (unsigned int i = 0; i < N; i++) stats[i] = g.chromosomes[i].cost_samples;
+            extra = ocba_allocation(stats, m, std::min(budget, round), noise_max_replications);
+            unsigned int allocated = 0;
+            for (unsigned int e : extra) allocated += e;
+            if (allocated == 0) break;
+            run_replications(g, extra);
+            budget -= allocated;
+        }
+        for (ThisChromosomeType& c : g.chromosomes) c.total_cost = c.cost_samples.mean;
+    }
+
+    // Evaluates extra[i] more replications of member i on the thread pool.
+    void run_replications(ThisGenerationType& g, const vector<unsigned int>& extra) {
+        vector<unsigned int> task_member;
+        vector<unsigned long> task_replication;
+        for (unsigned int i = 0; i < extra.size(); i++)
+            for (unsigned int k = 0; k < extra[i]; k++) {
+                task_member.push_back(i);
+                task_replication.push_back(g.chromosomes[i].cost_samples.n + k);
+            }
+        const unsigned int N_tasks = (unsigned int)task_member.size();
+        if (N_tasks == 0) return;
+        vector<double> cost(N_tasks, 0.0);
+        vector<char> accepted(N_tasks, 0);
+        std::atomic<unsigned int> next_task(0);
+        run_on_workers(multi_threading ? std::min(N_threads, int(N_tasks)) : 1, [&](int) {
+            for (unsigned int t = next_task++; t < N_tasks && !user_request_stop; t = next_task++) {
+                ThisChromosomeType X; // the genes and fresh middle costs, without the rest of the member
+                X.genes = g.chromosomes[task_member[t]].genes;
+                ResourceLease lease = lease_eval_resources(X.genes);
+                const bool ok = eval_solution_noisy(X.genes, X.middle_costs, replication_seed(task_replication[t]));
+                lease.release();
+                if (ok) {
+                    cost[t] = calculate_SO_total_fitness(X);
+                    accepted[t] = 1;
+                }
+            }
+        });
+        for (unsigned int t = 0; t < N_tasks; t++)
+            if (accepted[t]) g.chromosomes[task_member[t]].cost_samples.add(cost[t]);
+    }
+
     void finalize_objectives(ThisGenerationType& g) {
         if (user_request_stop) return;
 
         switch (problem_mode) {
         case GaMode::SOGA:
             for (int i = 0; i < int(g.chromosomes.size()); i++)
-                g.chromosomes[i].total_cost = calculate_SO_total_fitness(g.chromosomes[i]);
+                if (g.chromosomes[i].retained.in_place())
+                    g.chromosomes[i].total_cost = calculate_SO_total_fitness(g.chromosomes[i]);
+            if (eval_solution_noisy) resample_noisy(g);
+            break;
+        case GaMode::IGA:
+            if (iga_pipeline)
+                wait_IGA_ratings(g);
+            else
+                calculate_IGA_total_fitness(g);
             break;
-        case GaMode::IGA: calculate_IGA_total_fitness(g); break;
         case GaMode::NSGA_III:
             for (unsigned int i = 0; i < g.chromosomes.size(); i++)
-                g.chromosomes[i].objectives = calculate_MO_objectives(g.chromosomes[i]);
+                if (g.chromosomes[i].retained.in_place())
+                    g.chromosomes[i].objectives = calculate_MO_objectives(g.chromosomes[i]);
             break;
         default: throw runtime_error("Code should not reach here!");
         }
+        for (ThisChromosomeType& x : g.chromosomes)
+            if (!x.serial) x.serial = ++last_serial;
+        retain_middle_costs(g);
+    }
+
+    /****************************************************
+     * Applies middle_cost_retention to the members whose
+     * middle costs are still in place. Their total cost
+     * and objectives are kept from now on instead of
+     * being calculated again in every generation. The
+     * members are serialized on the worker threads.
+     ****************************************************/
+    void retain_middle_costs(ThisGenerationType& g) {
+        if (middle_cost_retention == MiddleCostRetention::Keep) return;
+        vector<unsigned int> members;
+        for (unsigned int i = 0; i < g.chromosomes.size(); i++)
+            if (g.chromosomes[i].retained.in_place()) members.push_back(i);
+        const unsigned int N_tasks = (unsigned int)members.size();
+        std::atomic<unsigned int> next_task(0);
+        run_on_workers(multi_threading ? std::min(N_threads, int(N_tasks)) : 1, [&](int) {
+            for (unsigned int t = next_task++; t < N_tasks; t = next_task++) {
+                ThisChromosomeType& x = g.chromosomes[members[t]];
+                if (middle_cost_retention == MiddleCostRetention::Compress) {
+                    std::string packed;
+                    lz_compress(serialize_middle_costs(x.middle_costs), packed);
+                    x.retained.compressed = std::make_shared<const std::string>(std::move(packed));
+                }
+                if (middle_cost_retention == MiddleCostRetention::Spill)
+                    x.retained.spilled =
+                        std::make_shared<const SpillRecord>(middle_cost_spill, serialize_middle_costs(x.middle_costs));
+                x.retained.state = middle_cost_retention;
+                x.middle_costs = MiddleCostType();
+            }
+        });
     }
 };
 
@@ -0,0 +1,880 @@
+#define OPENGA_EXTERN_LOCAL_VARS
+#include <openGA.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Point {
+    double x, y;
+};
+
+struct Cost {
+    double c;
+};
+
+using GA = EA::Genetic<Point, Cost>;
+
+double target = 0.0; // the optimum of the sphere is at (target, target)
+
+double sphere_cost(const Point& p) { return (p.x - target) * (p.x - target) + (p.y - target) * (p.y - target); }
+
+// on a grid of 0.5, so that offspring often repeat earlier genes
+double snap(double v) { return std::round(std::min(10.0, std::max(-10.0, v)) * 2.0) / 2.0; }
+
+// a small single objective problem which runs all generations on the calling thread
+void sphere(GA& ga) {
+    ga.problem_mode = EA::GaMode::SOGA;
+    ga.multi_threading = false;
+    ga.population = 20;
+    ga.generation_max = 10;
+    ga.best_stall_max = 1000;
+    ga.average_stall_max = 1000;
+    ga.elite_count = 2;
+    ga.random_seed = 1;
+    ga.init_genes = [](Point& p, const std::function<double(void)>& rnd01) {
+        p.x = snap(20.0 * rnd01() - 10.0);
+        p.y = snap(20.0 * rnd01() - 10.0);
+    };
+    ga.eval_solution = [](const Point& p, Cost& c) {
+        c.c = sphere_cost(p);
+        return true;
+    };
+    ga.calculate_SO_total_fitness = [](const GA::ThisChromosomeType& X) { return X.middle_costs.c; };
+    ga.mutate = [](const Point& p, const std::function<double(void)>& rnd01, double scale) {
+        return Point{snap(p.x + 4.0 * scale * (rnd01() - rnd01())), snap(p.y + 4.0 * scale * (rnd01() - rnd01()))};
+    };
+    ga.crossover = [](const Point& a, const Point& b, const std::function<double(void)>& rnd01) {
+        const double w = rnd01();
+        return Point{snap(w * a.x + (1 - w) * b.x), snap(w * a.y + (1 - w) * b.y)};
+    };
+    ga.SO_report_generation = [](int, const GA::ThisGenerationType&, const Point&) {};
+    ga.hash_genes = [](const Point& p) { return EA::hash_fields(p.x, p.y); };
+    ga.serialize_middle_costs = [](const Cost& c) { return std::string((const char*)&c.c, sizeof(double)); };
+    ga.deserialize_middle_costs = [](const std::string& bytes, Cost& c) {
+        if (bytes.size() != sizeof(double)) return false;
+        std::memcpy(&c.c, bytes.data(), sizeof(double));
+        return true;
+    };
+}
+
+} // namespace
+
+#ifdef OPENGA_HAS_MMAP
+
+TEST(GeneticTest, problemChangeBypassesOldStoreResults) {
+    const std::string path = ::testing::TempDir() + "openga_engine_store";
+    std::remove((path + ".log").c_str());
+    std::remove((path + ".idx").c_str());
+    {
+        GA ga;
+        sphere(ga);
+        ga.generation_max = 5;
+        ga.evaluation_store = std::make_shared<EA::EvaluationStore>(path);
+        ga.generation_archive = std::make_shared<EA::GenerationArchive<GA::ThisGenerationType>>();
+        target = 0.0;
+        ga.solve();
+        ga.evaluation_store->flush();
+
+        target = 3.0;
+        ga.notify_problem_changed();
+        ga.resume();
+        for (const GA::ThisChromosomeType& X : ga.last_generation.chromosomes)
+            EXPECT_DOUBLE_EQ(X.total_cost, sphere_cost(X.genes));
+
+        // the generations after the change continue the step count of the archive
+        ASSERT_EQ(ga.generation_archive->size(), 12u);
+        for (std::size_t i = 0; i < 12; i++) EXPECT_EQ(ga.generation_archive->at(i)->generation_step, int(i));
+    }
+    std::remove((path + ".log").c_str());
+    std::remove((path + ".idx").c_str());
+}
+
+#endif
+
+TEST(GeneticTest, perfCountersPerWorkerThread) {
+    GA ga;
+    sphere(ga);
+    ga.multi_threading = true;
+    ga.dynamic_threading = true;
+    ga.N_threads = 3;
+    ga.generation_max = 3;
+    ga.collect_perf_counters = true;
+    std::vector<std::size_t> workers;
+    ga.SO_report_generation = [&workers](int, const GA::ThisGenerationType& g, const Point&) {
+        workers.push_back(g.perf.workers.size());
+    };
+    ga.solve();
+    ASSERT_EQ(workers.size(), 4u);
+    for (std::size_t n : workers) {
+        EXPECT_GE(n, 1u);
+        EXPECT_LE(n, 3u); // not one entry per offspring
+    }
+}
+
+TEST(GeneticTest, problemChangeDropsCachedStageOutputs) {
+    GA ga;
+    sphere(ga);
+    ga.generation_max = 5;
+    auto stages = std::make_shared<EA::StagedEvaluation<Point>>();
+    const unsigned int distance = stages->add_stage<double>(
+        "distance", [](const Point& p) { return EA::hash_fields(p.x, p.y); },
+        [](const Point& p, const EA::StageResults&) { return sphere_cost(p); }, 1000);
+    ga.eval_solution = nullptr;
+    ga.evaluation_stages = stages;
+    ga.eval_solution_staged = [distance](const Point&, Cost& c, const EA::StageResults& results) {
+        c.c = results.get<double>(distance);
+        return true;
+    };
+    target = 0.0;
+    ga.solve();
+
+    target = 3.0;
+    ga.notify_problem_changed();
+    ga.resume();
+    for (const GA::ThisChromosomeType& X : ga.last_generation.chromosomes)
+        EXPECT_DOUBLE_EQ(X.total_cost, sphere_cost(X.genes));
+}
+
+namespace {
+
+// the middle costs are the two objectives
+using MOGA = EA::Genetic<Point, Point>;
+
+struct AspirationGA : MOGA {
+    using MOGA::generate_aspiration_reference_vectors;
+};
+
+// a quarter circle front, where x sets the angle of the member and y its distance from the front
+void two_objectives(MOGA& ga) {
+    ga.problem_mode = EA::GaMode::NSGA_III;
+    ga.multi_threading = false;
+    ga.population = 40;
+    ga.generation_max = 60;
+    ga.best_stall_max = 1000;
+    ga.average_stall_max = 1000;
+    ga.random_seed = 1;
+    auto clamp = [](double v) { return std::min(1.0, std::max(0.0, v)); };
+    ga.init_genes = [](Point& p, const std::function<double(void)>& rnd01) {
+        p.x = rnd01();
+        p.y = rnd01();
+    };
+    ga.eval_solution = [](const Point& p, Point& c) {
+        const double pi = 3.14159265358979;
+        const double g = (p.y - 0.5) * (p.y - 0.5);
+        c.x = (1 + g) * std::cos(p.x * pi / 2);
+        c.y = (1 + g) * std::sin(p.x * pi / 2);
+        return true;
+    };
+    ga.calculate_MO_objectives = [](const MOGA::ThisChromosomeType& X) {
+        return std::vector<double>{X.middle_costs.x, X.middle_costs.y};
+    };
+    ga.mutate = [clamp](const Point& p, const std::function<double(void)>& rnd01, double scale) {
+        return Point{clamp(p.x + 0.2 * scale * (rnd01() - rnd01())), clamp(p.y + 0.2 * scale * (rnd01() - rnd01()))};
+    };
+    ga.crossover = [](const Point& a, const Point& b, const std::function<double(void)>& rnd01) {
+        const double w = rnd01();
+        return Point{w * a.x + (1 - w) * b.x, w * a.y + (1 - w) * b.y};
+    };
+    ga.MO_report_generation = [](int, const MOGA::ThisGenerationType&, const std::vector<unsigned int>&) {};
+}
+
+} // namespace
+
+TEST(GeneticTest, aspirationDirectionsAroundTheAspirationPoint) {
+    AspirationGA ga;
+    ga.population = 40;
+    ga.aspiration_points = {{1.2, 2.6, 5.6}, {3.0, 2.0, 1.0}};
+    ga.aspiration_spread = 0.1;
+    ga.aspiration_divisions = 4;
+    const std::vector<double> ideal = {1.0, 2.0, 1.0}, intercepts = {1.0, 2.0, 4.0};
+    // the first point normalizes to (0.2, 0.3, 1.15), which is (0.12, 0.18, 0.70) on the simplex
+    const std::vector<double> center = {0.2 / 1.65, 0.3 / 1.65, 1.15 / 1.65};
+
+    const EA::Matrix<double> d = ga.generate_aspiration_reference_vectors(ideal, intercepts);
+    const unsigned int N_patch = 15; // Das-Dennis directions of 3 objectives and 4 divisions
+    ASSERT_EQ(d.get_n_rows(), 2 * N_patch + 3);
+    ASSERT_EQ(d.get_n_cols(), 3u);
+    for (unsigned int i = 0; i < d.get_n_rows(); i++) {
+        double sum = 0.0;
+        for (unsigned int j = 0; j < 3; j++) {
+            EXPECT_GE(d(i, j), 0.0);
+            sum += d(i, j);
+        }
+        EXPECT_NEAR(sum, 1.0, 1e-12);
+    }
+    // the first patch is not clipped, so it is centered on the point and spread by aspiration_spread
+    for (unsigned int j = 0; j < 3; j++) {
+        double mean = 0.0;
+        for (unsigned int k = 0; k < N_patch; k++) {
+            mean += d(k, j) / double(N_patch);
+            EXPECT_LE(std::abs(d(k, j) - center[j]), 0.1 * 2.0 / 3.0 + 1e-12);
+        }
+        EXPECT_NEAR(mean, center[j], 1e-12);
+    }
+    // the objective axes follow the patches
+    for (unsigned int a = 0; a < 3; a++)
+        for (unsigned int j = 0; j < 3; j++) EXPECT_DOUBLE_EQ(d(2 * N_patch + a, j), a == j ? 1.0 : 0.0);
+
+    // 0 divisions take the most that fit into the population: 4 divisions for 40 members, 5 for 50
+    ga.aspiration_divisions = 0;
+    EXPECT_EQ(ga.generate_aspiration_reference_vectors(ideal, intercepts).get_n_rows(), 2 * N_patch + 3);
+    ga.population = 50;
+    EXPECT_EQ(ga.generate_aspiration_reference_vectors(ideal, intercepts).get_n_rows(), 2 * 21u + 3);
+}
+
+TEST(GeneticTest, aspirationPointConcentratesThePopulation) {
+    MOGA ga;
+    two_objectives(ga);
+    ga.aspiration_points = {{0.3, 0.95}}; // at an angle of 1.27 on the front
+    ga.aspiration_spread = 0.1;
+    ga.solve();
+    const double angle = std::atan2(0.95, 0.3);
+    unsigned int near = 0;
+    for (const MOGA::ThisChromosomeType& X : ga.last_generation.chromosomes) {
+        const double a = std::atan2(X.middle_costs.y, X.middle_costs.x);
+        if (std::abs(a - angle) < 0.2) near++;
+    }
+    EXPECT_GE(near, 3 * ga.population / 4);
+}
+
+TEST(GeneticTest, incrementalRankingFindsTheSameFronts) {
+    // the fronts of every generation, with the members of each front in index order
+    std::vector<std::vector<std::vector<unsigned int>>> fronts[2];
+    unsigned long comparisons[2] = {0, 0};
+    for (int incremental = 0; incremental < 2; incremental++) {
+        MOGA ga;
+        two_objectives(ga);
+        ga.population = 20;
+        ga.generation_max = 30;
+        ga.incremental_MO_ranking = incremental == 1;
+        std::vector<std::vector<std::vector<unsigned int>>>& run = fronts[incremental];
+        ga.MO_report_generation = [&run](int, const MOGA::ThisGenerationType& g, const std::vector<unsigned int>&) {
+            run.push_back(g.fronts);
+            for (std::vector<unsigned int>& front : run.back()) std::sort(front.begin(), front.end());
+        };
+        ga.solve();
+        comparisons[incremental] = ga.get_dominance_comparisons();
+    }
+    ASSERT_EQ(fronts[0].size(), 31u);
+    ASSERT_EQ(fronts[1].size(), fronts[0].size());
+    size_t deepest = 0;
+    for (unsigned int step = 0; step < fronts[0].size(); step++) {
+        EXPECT_EQ(fronts[1][step], fronts[0][step]) << "generation " << step;
+        deepest = std::max(deepest, fronts[0][step].size());
+    }
+    EXPECT_GT(deepest, 1u);
+    EXPECT_EQ(comparisons[0], 0u);
+    EXPECT_GT(comparisons[1], 0u);
+}
+
+TEST(GeneticTest, immigrantsAreReplayed) {
+    const std::string path = ::testing::TempDir() + "openga_engine_trace";
+    std::remove(path.c_str());
+    {
+        GA ga;
+        sphere(ga);
+        ga.evaluation_recorder = std::make_shared<EA::EvaluationTraceWriter>(path);
+        target = 0.0;
+        ga.solve();
+    }
+    // the population always counts as collapsed, so immigrants replace the worst members every generation
+    GA ga;
+    sphere(ga);
+    ga.eval_solution = nullptr;
+    ga.evaluation_replay = std::make_shared<EA::EvaluationTrace>(path);
+    ga.embed_genes = [](const Point& p, std::vector<double>& v) { v = {p.x, p.y}; };
+    ga.diversity_threshold = 1e9;
+    ga.diversity_action = EA::DiversityAction::Immigrants;
+    ga.solve();
+    for (const GA::ThisChromosomeType& X : ga.last_generation.chromosomes) EXPECT_GE(X.total_cost, 0.0);
+    std::remove(path.c_str());
+}
+
+namespace {
+
+// runs the sphere with the retention policy, then changes the problem and resumes
+void retained_run(EA::MiddleCostRetention retention) {
+    GA ga;
+    sphere(ga);
+    ga.middle_cost_retention = retention;
+    if (retention == EA::MiddleCostRetention::Spill)
+        ga.middle_cost_spill = std::make_shared<EA::SpillStore>(::testing::TempDir() + "openga_engine_spill");
+    std::atomic<unsigned long> evaluations(0), fitness_calls(0);
+    ga.eval_solution = [&evaluations](const Point& p, Cost& c) {
+        evaluations++;
+        c.c = sphere_cost(p);
+        return true;
+    };
+    ga.calculate_SO_total_fitness = [&fitness_calls](const GA::ThisChromosomeType& X) {
+        fitness_calls++;
+        return X.middle_costs.c;
+    };
+    target = 0.0;
+    ga.solve();
+    // the survivors are not calculated again from their released middle costs
+    EXPECT_EQ(fitness_calls, evaluations);
+
+    target = 3.0;
+    ga.notify_problem_changed();
+    ga.resume();
+    EXPECT_EQ(fitness_calls, evaluations);
+    for (const GA::ThisChromosomeType& X : ga.last_generation.chromosomes) {
+        EXPECT_FALSE(X.retained.in_place());
+        EXPECT_EQ(X.middle_costs.c, 0.0);
+        EXPECT_DOUBLE_EQ(X.total_cost, sphere_cost(X.genes));
+        Cost c = {-1.0};
+        EXPECT_EQ(ga.load_middle_costs(X, c), retention != EA::MiddleCostRetention::Release);
+        if (retention != EA::MiddleCostRetention::Release) {
+            EXPECT_DOUBLE_EQ(c.c, sphere_cost(X.genes));
+        }
+    }
+    if (retention == EA::MiddleCostRetention::Spill) {
+        // the records of the members which are gone are written over
+        const uint64_t live = ga.middle_cost_spill->bytes() - ga.middle_cost_spill->free_bytes();
+        EXPECT_LE(live, sizeof(double) * ga.population);
+        EXPECT_LT(ga.middle_cost_spill->bytes(), sizeof(double) * evaluations / 2);
+    }
+}
+
+} // namespace
+
+TEST(GeneticTest, releasedMiddleCosts) { retained_run(EA::MiddleCostRetention::Release); }
+
+TEST(GeneticTest, compressedMiddleCosts) { retained_run(EA::MiddleCostRetention::Compress); }
+
+TEST(GeneticTest, spilledMiddleCosts) { retained_run(EA::MiddleCostRetention::Spill); }
+
+TEST(GeneticTest, spilledMiddleCostsOfNoisyEvaluations) {
+    GA ga;
+    sphere(ga);
+    ga.eval_solution = nullptr;
+    ga.eval_solution_noisy = [](const Point& p, Cost& c, uint64_t seed) {
+        c.c = sphere_cost(p) + 0.1 * double(seed % 5);
+        return true;
+    };
+    ga.middle_cost_retention = EA::MiddleCostRetention::Spill;
+    ga.middle_cost_spill = std::make_shared<EA::SpillStore>(::testing::TempDir() + "openga_engine_spill_noisy");
+    target = 0.0;
+    ga.solve();
+    for (const GA::ThisChromosomeType& X : ga.last_generation.chromosomes) {
+        // the replications evaluate the genes again, although the member keeps only its spilled record
+        EXPECT_GE(X.cost_samples.n, ga.noise_min_replications);
+        EXPECT_DOUBLE_EQ(X.total_cost, X.cost_samples.mean);
+        EXPECT_GE(X.total_cost, sphere_cost(X.genes));
+        EXPECT_LE(X.total_cost, sphere_cost(X.genes) + 0.4);
+        Cost c = {-1.0};
+        ASSERT_TRUE(ga.load_middle_costs(X, c));
+        EXPECT_GE(c.c, sphere_cost(X.genes));
+    }
+}
+
+TEST(GeneticTest, noisyBudgetIsSpentOncePerGeneration) {
+    GA ga;
+    sphere(ga);
+    ga.embed_genes = [](const Point& p, std::vector<double>& v) { v = {p.x, p.y}; };
+    ga.diversity_threshold = 1e9; // immigrants replace the worst members after every selection
+    ga.diversity_action = EA::DiversityAction::Immigrants;
+    ga.eval_solution = nullptr;
+    ga.noise_replications_budget = 5;
+    ga.noise_seed = 7;
+    // replications 0 and 1 are the noise_min_replications of the new members, the budget goes beyond
+    const uint64_t minimum_seeds[2] = {EA::hash_combine(ga.noise_seed, 0), EA::hash_combine(ga.noise_seed, 1)};
+    unsigned int replications = 0;
+    ga.eval_solution_noisy = [&replications, minimum_seeds](const Point& p, Cost& c, uint64_t seed) {
+        if (seed != minimum_seeds[0] && seed != minimum_seeds[1]) replications++;
+        c.c = sphere_cost(p) + 0.1 * double(seed % 5);
+        return true;
+    };
+    int generations = 0;
+    ga.SO_report_generation = [&](int, const GA::ThisGenerationType&, const Point&) {
+        EXPECT_LE(replications, (unsigned int)ga.noise_replications_budget);
+        EXPECT_GT(replications, 0u);
+        replications = 0;
+        generations++;
+    };
+    target = 0.0;
+    ga.solve();
+    EXPECT_EQ(generations, ga.generation_max + 1);
+}
+
+TEST(GeneticTest, gradientMutationBeatsPlainMutation) {
+    double best[2] = {0.0, 0.0};
+    unsigned int gradient_steps = 0;
+    for (int with_gradient = 0; with_gradient < 2; with_gradient++) {
+        GA ga;
+        sphere(ga);
+        // the smooth sphere, without the grid of snap
+        ga.init_genes = [](Point& p, const std::function<double(void)>& rnd01) {
+            p.x = 20.0 * rnd01() - 10.0;
+            p.y = 20.0 * rnd01() - 10.0;
+        };
+        ga.mutate = [](const Point& p, const std::function<double(void)>& rnd01, double scale) {
+            return Point{p.x + 4.0 * scale * (rnd01() - rnd01()), p.y + 4.0 * scale * (rnd01() - rnd01())};
+        };
+        ga.crossover = [](const Point& a, const Point& b, const std::function<double(void)>& rnd01) {
+            const double w = rnd01();
+            return Point{w * a.x + (1 - w) * b.x, w * a.y + (1 - w) * b.y};
+        };
+        if (with_gradient) {
+            ga.eval_solution = nullptr;
+            ga.eval_solution_gradient = [](const Point& p, Cost& c, std::vector<double>& gradient) {
+                c.c = sphere_cost(p);
+                gradient = {2.0 * (p.x - target), 2.0 * (p.y - target)};
+                return true;
+            };
+            ga.mutate_gradient = [&gradient_steps](
+                                     const GA::ThisChromosomeType& X, EA::BulkRandom& rng, double shrink_scale) {
+                gradient_steps++;
+                EXPECT_EQ(X.gradient.size(), 2u);
+                const std::vector<double> y =
+                    EA::langevin_step({X.genes.x, X.genes.y}, X.gradient, 0.25, 1e-4 * shrink_scale, rng);
+                return Point{y[0], y[1]};
+            };
+        }
+        target = 3.3;
+        ga.solve();
+        best[with_gradient] = ga.last_generation.best_total_cost;
+    }
+    target = 0.0;
+    EXPECT_GT(gradient_steps, 0u);
+    EXPECT_LT(best[1], best[0] / 10.0);
+}
+
+namespace {
+
+// sphere with the diversity measured on the genes, collapsed below threshold
+void diversity_run(GA& ga, double threshold, EA::DiversityAction action) {
+    sphere(ga);
+    ga.embed_genes = [](const Point& p, std::vector<double>& v) { v = {p.x, p.y}; };
+    ga.diversity_threshold = threshold;
+    ga.diversity_action = action;
+}
+
+} // namespace
+
+TEST(GeneticTest, diversityCollapseStopsTheRun) {
+    GA ga;
+    diversity_run(ga, 1e9, EA::DiversityAction::Stop);
+    EXPECT_EQ(ga.solve(), EA::StopReason::DiversityCollapse);
+    EXPECT_EQ(ga.generation_step, 2); // the stop criteria are checked from the second generation on
+
+    GA diverse;
+    diversity_run(diverse, 1e-9, EA::DiversityAction::Stop);
+    EXPECT_EQ(diverse.solve(), EA::StopReason::MaxGenerations);
+}
+
+TEST(GeneticTest, diversityCollapseRaisesTheMutationRate) {
+    unsigned long mutations[2] = {0, 0};
+    for (int collapsed = 0; collapsed < 2; collapsed++) {
+        GA ga;
+        diversity_run(ga, collapsed ? 1e9 : 1e-9, EA::DiversityAction::RaiseMutation);
+        unsigned long& n = mutations[collapsed];
+        ga.mutate = [&n](const Point& p, const std::function<double(void)>& rnd01, double scale) {
+            n++;
+            return Point{snap(p.x + 4.0 * scale * (rnd01() - rnd01())), snap(p.y + 4.0 * scale * (rnd01() - rnd01()))};
+        };
+        ga.solve();
+    }
+    // the rate doubles every collapsed generation up to a mutation of every offspring
+    EXPECT_GT(mutations[1], 3 * mutations[0]);
+}
+
+TEST(GeneticTest, diversityCollapseBringsImmigrants) {
+    GA ga;
+    diversity_run(ga, 1e9, EA::DiversityAction::Immigrants);
+    unsigned long random_members = 0;
+    ga.init_genes = [&random_members](Point& p, const std::function<double(void)>& rnd01) {
+        random_members++;
+        p.x = snap(20.0 * rnd01() - 10.0);
+        p.y = snap(20.0 * rnd01() - 10.0);
+    };
+    ga.solve();
+    // the worst diversity_immigrant_fraction of the population is replaced in every generation
+    EXPECT_EQ(random_members, ga.population + 10 * 4u);
+    for (const GA::ThisChromosomeType& X : ga.last_generation.chromosomes)
+        EXPECT_DOUBLE_EQ(X.total_cost, sphere_cost(X.genes));
+}
+
+namespace {
+
+using Bits = std::vector<unsigned int>;
+
+struct Zeros {
+    double n;
+};
+
+using EDAGA = EA::Genetic<Bits, Zeros>;
+
+// OneMax on 24 bits, bred by sampling the distribution model
+void onemax(EDAGA& ga, EA::EDAMode mode) {
+    ga.problem_mode = EA::GaMode::SOGA;
+    ga.eda_mode = mode;
+    ga.multi_threading = false;
+    ga.population = 40;
+    ga.generation_max = 40;
+    ga.best_stall_max = 1000;
+    ga.average_stall_max = 1000;
+    ga.elite_count = 2;
+    ga.random_seed = 1;
+    ga.init_genes = [](Bits& x, const std::function<double(void)>& rnd01) {
+        x.resize(24);
+        for (unsigned int& b : x) b = rnd01() < 0.5 ? 1 : 0;
+    };
+    ga.eval_solution = [](const Bits& x, Zeros& c) {
+        c.n = 0;
+        for (unsigned int b : x) c.n += b ? 0 : 1;
+        return true;
+    };
+    ga.calculate_SO_total_fitness = [](const EDAGA::ThisChromosomeType& X) { return X.middle_costs.n; };
+    ga.SO_report_generation = [](int, const EDAGA::ThisGenerationType&, const Bits&) {};
+    ga.eda_encode = [](const Bits& x, std::vector<unsigned int>& v) { v = x; };
+    ga.eda_decode = [](const std::vector<unsigned int>& v, Bits& x) { x = v; };
+}
+
+} // namespace
+
+TEST(GeneticTest, sampledOffspringSolveOneMax) {
+    const EA::EDAMode modes[] = {EA::EDAMode::UMDA, EA::EDAMode::PBIL, EA::EDAMode::LinkageTree};
+    for (EA::EDAMode mode : modes) {
+        EDAGA ga;
+        onemax(ga, mode);
+        ga.PBIL_learning_rate = 0.3;
+        ga.eda_probability_margin = 0.01; // no bit is fixed at 0 for good
+        ga.solve();
+        EXPECT_EQ(ga.last_generation.best_total_cost, 0.0) << int(mode);
+    }
+}
+
+TEST(GeneticTest, rejectedSamplesAreRedrawn) {
+    EDAGA ga;
+    onemax(ga, EA::EDAMode::UMDA);
+    ga.multi_threading = true;
+    ga.N_threads = 3;
+    ga.generation_max = 5;
+    ga.eda_probability_margin = 0.05; // keeps the rejected value in the samples
+    std::atomic<unsigned long> rejected(0);
+    ga.eval_solution = [&rejected](const Bits& x, Zeros& c) {
+        if (x[0] == 0 && x[1] == 0) {
+            rejected++;
+            return false;
+        }
+        c.n = 0;
+        for (unsigned int b : x) c.n += b ? 0 : 1;
+        return true;
+    };
+    ga.solve();
+    EXPECT_GT(rejected, 0u);
+    for (const EDAGA::ThisChromosomeType& X : ga.last_generation.chromosomes) {
+        ASSERT_EQ(X.genes.size(), 24u);
+        EXPECT_TRUE(X.genes[0] || X.genes[1]);
+    }
+}
+
+TEST(GeneticTest, raisedMutationNeedsTheEDAMargin) {
+    EDAGA ga;
+    onemax(ga, EA::EDAMode::UMDA);
+    ga.embed_genes = [](const Bits& x, std::vector<double>& v) { v.assign(x.begin(), x.end()); };
+    ga.diversity_threshold = 0.5;
+    ga.diversity_action = EA::DiversityAction::RaiseMutation;
+    EXPECT_THROW(ga.solve(), std::runtime_error);
+    ga.eda_probability_margin = 0.01;
+    ga.solve();
+    EXPECT_EQ(ga.last_generation.best_total_cost, 0.0);
+}
+
+namespace {
+
+// two_objectives with a third objective equal to twice the first, or to twice the second once swap is set
+void three_objectives(MOGA& ga, const bool& swap) {
+    two_objectives(ga);
+    ga.objective_reduction = EA::ObjectiveReductionMode::Drop;
+    ga.objective_reduction_interval = 5;
+    ga.calculate_MO_objectives = [&swap](const MOGA::ThisChromosomeType& X) {
+        const Point& f = X.middle_costs;
+        return std::vector<double>{f.x, f.y, 2.0 * (swap ? f.y : f.x)};
+    };
+    ga.embed_genes = [](const Point& p, std::vector<double>& v) { v = {p.x, p.y}; };
+    ga.diversity_action = EA::DiversityAction::Stop;
+    // from generation 10 on, the population counts as collapsed and the run is stopped
+    ga.MO_report_generation = [&ga](int step, const MOGA::ThisGenerationType&, const std::vector<unsigned int>&) {
+        if (step == 10) ga.diversity_threshold = 1e9;
+    };
+}
+
+} // namespace
+
+TEST(GeneticTest, recheckKeepsRedundantObjectivesDropped) {
+    bool swap = false;
+    MOGA ga;
+    three_objectives(ga, swap);
+    EXPECT_EQ(ga.solve(), EA::StopReason::DiversityCollapse);
+    EXPECT_EQ(ga.generation_step, 11);
+    ASSERT_GE(ga.objective_reduction_log.size(), 2u);
+    const EA::ObjectiveReductionRecord& reduced = ga.objective_reduction_log.front();
+    EXPECT_EQ(reduced.groups, (std::vector<std::vector<unsigned int>>{{0, 2}, {1}}));
+    EXPECT_FALSE(reduced.final_check);
+    const EA::ObjectiveReductionRecord& recheck = ga.objective_reduction_log.back();
+    EXPECT_TRUE(recheck.final_check);
+    EXPECT_EQ(recheck.generation_step, 11);
+    EXPECT_EQ(recheck.groups, reduced.groups);
+}
+
+TEST(GeneticTest, recheckContinuesWithConflictingObjectives) {
+    bool swap = false;
+    MOGA ga;
+    three_objectives(ga, swap);
+    ga.MO_report_generation =
+        [&ga, &swap](int step, const MOGA::ThisGenerationType&, const std::vector<unsigned int>&) {
+            if (step != 10) return;
+            ga.diversity_threshold = 1e9;
+            swap = true; // the dropped objective follows the second one from now on
+        };
+    EXPECT_EQ(ga.solve(), EA::StopReason::DiversityCollapse);
+    // the first stop is taken back and the run continues with all objectives until it collapses again
+    EXPECT_EQ(ga.generation_step, 12);
+    const EA::ObjectiveReductionRecord& recheck = ga.objective_reduction_log.back();
+    EXPECT_TRUE(recheck.final_check);
+    EXPECT_EQ(recheck.generation_step, 11);
+    EXPECT_EQ(recheck.groups, (std::vector<std::vector<unsigned int>>{{0}, {1, 2}}));
+}
+
+namespace {
+
+struct AgeLayeredGA : GA {
+    using GA::ALPS_age;
+    using GA::ALPS_age_limit;
+};
+
+// the sphere in four age layers of 10 members, with a fresh bottom layer every 3 generations
+void age_layers(AgeLayeredGA& ga) {
+    sphere(ga);
+    ga.population = 10;
+    ga.generation_max = 20;
+    ga.ALPS_layers = 4;
+    ga.ALPS_age_gap = 3;
+}
+
+} // namespace
+
+TEST(GeneticTest, membersOverTheAgeLimitMoveUp) {
+    AgeLayeredGA ga;
+    age_layers(ga);
+    unsigned int promoted = 0;
+    size_t max_layers = 0;
+    ga.SO_report_generation = [&](int, const GA::ThisGenerationType& g, const Point&) {
+        max_layers = std::max(max_layers, g.layers.size());
+        for (unsigned int l = 0; l < g.layers.size(); l++)
+            for (unsigned int i : g.layers[l]) {
+                const unsigned int age = ga.ALPS_age(g.chromosomes[i]);
+                EXPECT_LE(age, ga.ALPS_age_limit(l));
+                // the reseeds only move the bottom layer, which is not older than its limit
+                if (l > 0 && age > ga.ALPS_age_limit(l - 1)) promoted++;
+            }
+    };
+    ga.solve();
+    EXPECT_EQ(max_layers, 4u);
+    EXPECT_GT(promoted, 0u);
+}
+
+TEST(GeneticTest, bottomLayerIsReseeded) {
+    AgeLayeredGA ga;
+    age_layers(ga);
+    unsigned int random_members = 0;
+    ga.init_genes = [&random_members](Point& p, const std::function<double(void)>& rnd01) {
+        random_members++;
+        p.x = snap(20.0 * rnd01() - 10.0);
+        p.y = snap(20.0 * rnd01() - 10.0);
+    };
+    ga.SO_report_generation = [](int step, const GA::ThisGenerationType& g, const Point&) {
+        if (step == 0 || step % 3 != 0) return;
+        ASSERT_EQ(g.layers[0].size(), 10u);
+        for (unsigned int i : g.layers[0]) EXPECT_EQ(g.chromosomes[i].birth, step);
+    };
+    ga.solve();
+    // generation 0 and the reseeds of generations 3, 6, ..., 18
+    EXPECT_EQ(random_members, 7 * ga.population);
+}
+
+TEST(GeneticTest, offspringInheritTheOldestBirth) {
+    AgeLayeredGA ga;
+    age_layers(ga);
+    // continuous genes without mutation, so that the parents can be found by their genes
+    ga.mutation_rate = 0.0;
+    ga.init_genes = [](Point& p, const std::function<double(void)>& rnd01) {
+        p.x = 20.0 * rnd01() - 10.0;
+        p.y = 20.0 * rnd01() - 10.0;
+    };
+    std::vector<std::pair<Point, int>> offspring_births;
+    auto birth_of = [&ga](const Point& p) {
+        for (const GA::ThisChromosomeType& X : ga.last_generation.chromosomes)
+            if (X.genes.x == p.x && X.genes.y == p.y) return X.birth;
+        ADD_FAILURE() << "unknown parent";
+        return -1;
+    };
+    ga.crossover = [&](const Point& a, const Point& b, const std::function<double(void)>& rnd01) {
+        const double w = rnd01();
+        const Point child = {w * a.x + (1 - w) * b.x, w * a.y + (1 - w) * b.y};
+        offspring_births.push_back({child, std::min(birth_of(a), birth_of(b))});
+        return child;
+    };
+    unsigned int checked = 0;
+    ga.SO_report_generation = [&](int, const GA::ThisGenerationType& g, const Point&) {
+        for (const GA::ThisChromosomeType& X : g.chromosomes)
+            for (const std::pair<Point, int>& o : offspring_births)
+                if (X.genes.x == o.first.x && X.genes.y == o.first.y) {
+                    EXPECT_EQ(X.birth, o.second);
+                    checked++;
+                }
+        offspring_births.clear();
+    };
+    ga.solve();
+    EXPECT_GT(checked, 0u);
+}
+
+TEST(GeneticTest, ageLayersKeepTheBestMember) {
+    AgeLayeredGA ga;
+    age_layers(ga);
+    double best = 1e100;
+    ga.SO_report_generation = [&best](int, const GA::ThisGenerationType& g, const Point&) {
+        EXPECT_LE(g.best_total_cost, best);
+        best = g.best_total_cost;
+    };
+    ga.solve();
+    EXPECT_LT(best, 1.0);
+}
+
+TEST(GeneticTest, immigrantsNeedASingleAgeLayer) {
+    AgeLayeredGA ga;
+    age_layers(ga);
+    ga.embed_genes = [](const Point& p, std::vector<double>& v) { v = {p.x, p.y}; };
+    ga.diversity_threshold = 1e9;
+    ga.diversity_action = EA::DiversityAction::Immigrants;
+    EXPECT_THROW(ga.solve(), std::runtime_error);
+    ga.ALPS_layers = 1;
+    EXPECT_EQ(ga.solve(), EA::StopReason::MaxGenerations);
+}
+
+TEST(GeneticTest, pipelineBreedsFromTheRatingsGivenSoFar) {
+    GA ga;
+    ga.problem_mode = EA::GaMode::IGA;
+    ga.IGA_pipeline = true;
+    ga.IGA_speculative_candidates = 3;
+    ga.multi_threading = true;
+    ga.N_threads = 2;
+    ga.idle_delay_us = 100;
+    ga.population = 6;
+    ga.elite_count = 1;
+    ga.crossover_fraction = 0.8; // five offspring next to the elite
+    ga.generation_max = 4;
+    ga.best_stall_max = 1000;
+    ga.average_stall_max = 1000;
+    ga.random_seed = 1;
+    ga.selection_strategy = EA::SelectionStrategy::Tournament;
+    ga.tournament_size = 64; // the best rated candidate wins nearly every tournament
+    ga.init_genes = [](Point& p, const std::function<double(void)>& rnd01) {
+        p.x = 20.0 * rnd01() - 10.0;
+        p.y = 20.0 * rnd01() - 10.0;
+    };
+    ga.mutate = [](const Point& p, const std::function<double(void)>& rnd01, double scale) {
+        return Point{p.x + 4.0 * scale * (rnd01() - rnd01()), p.y + 4.0 * scale * (rnd01() - rnd01())};
+    };
+    ga.SO_report_generation = [](int, const GA::ThisGenerationType&, const Point&) {};
+
+    auto same = [](const Point& a, const Point& b) { return a.x == b.x && a.y == b.y; };
+    std::mutex mtx;
+    std::condition_variable changed;
+    std::vector<Point> presented(ga.population);
+    unsigned int N_presented = 0;
+    bool batch_ready = false; // all candidates are presented, the first ratings are not given yet
+    bool rating = false; // the user has rated some but not all candidates of the batch
+    Point favorite = {0.0, 0.0}; // the best candidate of the batch, rated first
+    std::vector<Point> speculative; // evaluated while the user was rating
+    unsigned int speculative_used = 0, bred_while_rating = 0, bred_from_favorite = 0;
+    ga.IGA_present_candidate = [&](unsigned int index, const GA::ThisChromosomeType& X) {
+        std::unique_lock<std::mutex> lock(mtx);
+        presented[index] = X.genes;
+        for (const Point& p : speculative)
+            if (same(p, X.genes)) speculative_used++;
+        if (++N_presented < ga.population) return;
+        // holds the engine until the user has rated the first candidates, as a slow user interface would
+        N_presented = 0;
+        batch_ready = true;
+        changed.notify_all();
+        changed.wait(lock, [&]() { return !batch_ready; });
+    };
+    ga.eval_solution_IGA = [&](const Point& p, Cost& c, const GA::ThisGenerationType&) {
+        c.c = 0.0;
+        std::lock_guard<std::mutex> lock(mtx);
+        if (rating) speculative.push_back(p);
+        changed.notify_all();
+        return true;
+    };
+    ga.crossover = [&](const Point& a, const Point& b, const std::function<double(void)>& rnd01) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (rating) {
+                bred_while_rating++;
+                if (same(a, favorite) || same(b, favorite)) bred_from_favorite++;
+            }
+        }
+        const double w = rnd01();
+        return Point{w * a.x + (1 - w) * b.x, w * a.y + (1 - w) * b.y};
+    };
+
+    // the user interface rates each batch from its own thread, the worst and the best candidates first
+    std::thread user([&]() {
+        for (int step = 0; step <= ga.generation_max; step++) {
+            std::unique_lock<std::mutex> lock(mtx);
+            changed.wait(lock, [&]() { return batch_ready; });
+            const std::vector<Point> batch = presented;
+            unsigned int best = 0, worst = 0;
+            for (unsigned int i = 0; i < batch.size(); i++) {
+                if (sphere_cost(batch[i]) < sphere_cost(batch[best])) best = i;
+                if (sphere_cost(batch[i]) > sphere_cost(batch[worst])) worst = i;
+            }
+            favorite = batch[best];
+            speculative.clear();
+            rating = true;
+            lock.unlock();
+            EXPECT_TRUE(ga.rate_IGA_candidate(worst, sphere_cost(batch[worst])));
+            EXPECT_TRUE(ga.rate_IGA_candidate(best, sphere_cost(batch[best])));
+            lock.lock();
+            batch_ready = false;
+            changed.notify_all();
+            if (step < ga.generation_max) {
+                changed.wait_for(lock, std::chrono::seconds(5), [&]() { return speculative.size() >= 3; });
+                EXPECT_EQ(speculative.size(), 3u); // IGA_speculative_candidates
+            }
+            rating = false;
+            lock.unlock();
+            for (unsigned int i = (unsigned int)batch.size(); i-- > 0;)
+                if (i != best && i != worst) {
+                    EXPECT_TRUE(ga.rate_IGA_candidate(i, sphere_cost(batch[i])));
+                }
+        }
+    });
+    target = 1.0;
+    ga.solve();
+    user.join();
+
+    // the speculative candidates are bred from the favorite before the other ratings and used next generation
+    EXPECT_GE(bred_while_rating, 3u * ga.generation_max);
+    EXPECT_EQ(bred_from_favorite, bred_while_rating);
+    EXPECT_EQ(speculative_used, 3u * ga.generation_max);
+    EXPECT_EQ(ga.generation_step, ga.generation_max);
+    for (const GA::ThisChromosomeType& X : ga.last_generation.chromosomes)
+        EXPECT_DOUBLE_EQ(X.total_cost, sphere_cost(X.genes));
+    target = 0.0;
+}
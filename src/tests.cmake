@@ -3,6 +3,27 @@ cmake_minimum_required(VERSION 3.21)
 
 add_executable(UnitTests
     src/Matrix.test.cpp
+    src/MiddleCostRetention.test.cpp
+    src/NoisyEvaluation.test.cpp
+    src/BulkRandom.test.cpp
+    src/ParentSelection.test.cpp
+    src/PerfCounters.test.cpp
+    src/Dataset.test.cpp
+    src/Diversity.test.cpp
+    src/DominanceGraph.test.cpp
+    src/EDA.test.cpp
+    src/EvaluationStore.test.cpp
+    src/EvaluationTrace.test.cpp
+    src/FingerprintSet.test.cpp
+    src/GenerationArchive.test.cpp
+    src/GeneStore.test.cpp
+    src/GradientMutation.test.cpp
+    src/IGAPipeline.test.cpp
+    src/ObjectiveReduction.test.cpp
+    src/openGA.test.cpp
+    src/PopulationHistory.test.cpp
+    src/ResourceScheduler.test.cpp
+    src/StagedEvaluation.test.cpp
 )
 
 target_link_libraries(UnitTests
@@ -11,3 +32,15 @@ target_link_libraries(UnitTests
 )
 
 add_test(UnitTests UnitTests)
+
+# replaces the global operator new to count allocations, so it must not share a binary with other tests
+add_executable(SmallGeneticTests
+    src/SmallGenetic.test.cpp
+)
+
+target_link_libraries(SmallGeneticTests
+    gtest_main
+    openGA
+)
+
+add_test(SmallGeneticTests SmallGeneticTests)
@@ -3,7 +3,12 @@ find_package(Threads REQUIRED)
 find_package(GTest QUIET)
 set(THREADS_PREFER_PTHREAD_FLAG ON)
 
-if(NOT ${GTest_FOUND})
+if(${GTest_FOUND})
+    if(NOT TARGET gtest_main)
+        add_library(gtest_main INTERFACE)
+        target_link_libraries(gtest_main INTERFACE GTest::gtest_main Threads::Threads)
+    endif()
+else()
     FetchContent_Declare(
         googletest
         GIT_REPOSITORY https://github.com/google/googletest.git